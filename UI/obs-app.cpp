@@ -396,6 +396,8 @@ bool OBSApp::InitGlobalConfigDefaults()
 			"CenterSnapping", false);
 	config_set_default_double(globalConfig, "BasicWindow",
 			"SnapDistance", 10.0);
+	config_set_default_uint(globalConfig, "BasicWindow",
+			"DisplayMaxFPS", 0);
 	config_set_default_bool(globalConfig, "BasicWindow",
 			"RecordWhenStreaming", false);
 	config_set_default_bool(globalConfig, "BasicWindow",
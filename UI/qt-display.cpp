@@ -1,11 +1,20 @@
 #include "qt-display.hpp"
 #include "qt-wrappers.hpp"
 #include "display-helpers.hpp"
+#include "obs-app.hpp"
 #include <QWindow>
 #include <QScreen>
 #include <QResizeEvent>
 #include <QShowEvent>
 
+static QList<OBSQTDisplay *> displays;
+
+static inline uint32_t GetDisplayMaxFPS()
+{
+	return (uint32_t)config_get_uint(GetGlobalConfig(), "BasicWindow",
+			"DisplayMaxFPS");
+}
+
 OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 	: QWidget(parent, flags)
 {
@@ -39,6 +48,34 @@ OBSQTDisplay::OBSQTDisplay(QWidget *parent, Qt::WindowFlags flags)
 
 	connect(windowHandle(), &QWindow::visibleChanged, windowVisible);
 	connect(windowHandle(), &QWindow::screenChanged, sizeChanged);
+
+	windowHandle()->installEventFilter(this);
+
+	displays.push_back(this);
+}
+
+OBSQTDisplay::~OBSQTDisplay()
+{
+	displays.removeAll(this);
+}
+
+/* applies the preview/projector FPS limit to all existing displays */
+void OBSQTDisplay::UpdateMaxFPS()
+{
+	uint32_t fps = GetDisplayMaxFPS();
+
+	for (auto &window : displays)
+		obs_display_set_max_fps(window->display, fps);
+}
+
+/* windows stop being exposed when they're minimized or (on some platforms)
+ * fully covered, in which case there's no need to render the display */
+bool OBSQTDisplay::eventFilter(QObject *obj, QEvent *event)
+{
+	if (obj == windowHandle() && event->type() == QEvent::Expose)
+		obs_display_set_visible(display, windowHandle()->isExposed());
+
+	return QWidget::eventFilter(obj, event);
 }
 
 void OBSQTDisplay::CreateDisplay()
@@ -57,6 +94,8 @@ void OBSQTDisplay::CreateDisplay()
 	QTToGSWindow(winId(), info.window);
 
 	display = obs_display_create(&info);
+	obs_display_set_visible(display, true);
+	obs_display_set_max_fps(display, GetDisplayMaxFPS());
 
 	emit DisplayCreated(this);
 }
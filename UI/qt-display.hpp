@@ -12,6 +12,7 @@ class OBSQTDisplay : public QWidget {
 
 	void resizeEvent(QResizeEvent *event) override;
 	void paintEvent(QPaintEvent *event) override;
+	bool eventFilter(QObject *obj, QEvent *event) override;
 
 signals:
 	void DisplayCreated(OBSQTDisplay *window);
@@ -19,8 +20,11 @@ signals:
 
 public:
 	OBSQTDisplay(QWidget *parent = 0, Qt::WindowFlags flags = 0);
+	~OBSQTDisplay();
 
 	virtual QPaintEngine *paintEngine() const override;
 
 	inline obs_display_t *GetDisplay() const {return display;}
+
+	static void UpdateMaxFPS();
 };
@@ -191,6 +191,8 @@ VolControl::VolControl(OBSSource source_, bool showConfig)
 	setLayout(mainLayout);
 
 	obs_fader_add_callback(obs_fader, OBSVolumeChanged, this);
+	obs_volmeter_set_update_mode(obs_volmeter,
+			OBS_VOLMETER_UPDATE_INTERVAL);
 	obs_volmeter_add_callback(obs_volmeter, OBSVolumeLevel, this);
 
 	signal_handler_connect(obs_source_get_signal_handler(source),
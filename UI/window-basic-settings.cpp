@@ -311,6 +311,7 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 	HookWidget(ui->systemTrayWhenStarted,CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->systemTrayAlways,     CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->saveProjectors,       CHECK_CHANGED,  GENERAL_CHANGED);
+	HookWidget(ui->displayMaxFPS,        SCROLL_CHANGED, GENERAL_CHANGED);
 	HookWidget(ui->snappingEnabled,      CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->screenSnapping,       CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->centerSnapping,       CHECK_CHANGED,  GENERAL_CHANGED);
@@ -1084,6 +1085,10 @@ void OBSBasicSettings::LoadGeneralSettings()
 			"BasicWindow", "ProjectorAlwaysOnTop");
 	ui->projectorAlwaysOnTop->setChecked(projectorAlwaysOnTop);
 
+	int displayMaxFPS = (int)config_get_uint(GetGlobalConfig(),
+			"BasicWindow", "DisplayMaxFPS");
+	ui->displayMaxFPS->setValue(displayMaxFPS);
+
 	bool doubleClickSwitch = config_get_bool(GetGlobalConfig(),
 			"BasicWindow", "TransitionOnDoubleClick");
 	ui->doubleClickSwitch->setChecked(doubleClickSwitch);
@@ -2688,6 +2693,14 @@ void OBSBasicSettings::SaveGeneralSettings()
 				"SaveProjectors",
 				ui->saveProjectors->isChecked());
 
+	if (WidgetChanged(ui->displayMaxFPS)) {
+		config_set_uint(GetGlobalConfig(), "BasicWindow",
+				"DisplayMaxFPS",
+				ui->displayMaxFPS->value());
+
+		OBSQTDisplay::UpdateMaxFPS();
+	}
+
 	if (WidgetChanged(ui->studioPortraitLayout)) {
 		config_set_bool(GetGlobalConfig(), "BasicWindow",
 				"StudioPortraitLayout",
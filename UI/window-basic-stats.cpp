@@ -58,10 +58,12 @@ OBSBasicStats::OBSBasicStats(QWidget *parent)
 	cpuUsage = new QLabel(this);
 	hddSpace = new QLabel(this);
 	memUsage = new QLabel(this);
+	frameCache = new QLabel(this);
 
 	newStat("CPUUsage", cpuUsage, 0);
 	newStat("HDDSpaceAvailable", hddSpace, 0);
 	newStat("MemoryUsage", memUsage, 0);
+	newStat("FrameCache", frameCache, 0);
 
 	fps = new QLabel(this);
 	renderTime = new QLabel(this);
@@ -212,6 +214,7 @@ static uint32_t first_encoded = 0xFFFFFFFF;
 static uint32_t first_skipped = 0xFFFFFFFF;
 static uint32_t first_rendered = 0xFFFFFFFF;
 static uint32_t first_lagged = 0xFFFFFFFF;
+static uint32_t first_stalls = 0xFFFFFFFF;
 
 void OBSBasicStats::InitializeValues()
 {
@@ -220,6 +223,10 @@ void OBSBasicStats::InitializeValues()
 	first_skipped  = video_output_get_skipped_frames(video);
 	first_rendered = obs_get_total_frames();
 	first_lagged   = obs_get_lagged_frames();
+
+	struct video_cache_stats cache_stats = {};
+	video_output_get_cache_stats(video, &cache_stats);
+	first_stalls   = cache_stats.stalls;
 }
 
 void OBSBasicStats::Update()
@@ -351,6 +358,30 @@ void OBSBasicStats::Update()
 
 	/* ------------------ */
 
+	struct video_cache_stats cache_stats = {};
+	video_output_get_cache_stats(video, &cache_stats);
+
+	if (cache_stats.stalls < first_stalls)
+		first_stalls = cache_stats.stalls;
+
+	num = (long double)cache_stats.max_stall_ns / 1000000.0l;
+
+	str = QString("%1 / %2 (%3, %4 ms)").arg(
+			QString::number(cache_stats.high_water),
+			QString::number(cache_stats.limit),
+			QString::number(cache_stats.stalls - first_stalls),
+			QString::number(num, 'f', 1));
+	frameCache->setText(str);
+
+	if (cache_stats.high_water >= cache_stats.limit)
+		setThemeID(frameCache, "error");
+	else if (cache_stats.stalls != first_stalls)
+		setThemeID(frameCache, "warning");
+	else
+		setThemeID(frameCache, "");
+
+	/* ------------------ */
+
 	uint32_t total_rendered = obs_get_total_frames();
 	uint32_t total_lagged   = obs_get_lagged_frames();
 
@@ -394,6 +425,7 @@ void OBSBasicStats::Reset()
 	first_skipped  = 0xFFFFFFFF;
 	first_rendered = 0xFFFFFFFF;
 	first_lagged   = 0xFFFFFFFF;
+	first_stalls   = 0xFFFFFFFF;
 
 	OBSOutput strOutput = obs_frontend_get_streaming_output();
 	OBSOutput recOutput = obs_frontend_get_recording_output();
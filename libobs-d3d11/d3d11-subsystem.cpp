@@ -1906,6 +1906,21 @@ bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 	return true;
 }
 
+bool gs_stagesurface_try_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+		uint32_t *linesize)
+{
+	D3D11_MAPPED_SUBRESOURCE map;
+
+	/* fails with DXGI_ERROR_WAS_STILL_DRAWING while the copy is pending */
+	if (FAILED(stagesurf->device->context->Map(stagesurf->texture, 0,
+			D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &map)))
+		return false;
+
+	*data = (uint8_t*)map.pData;
+	*linesize = map.RowPitch;
+	return true;
+}
+
 void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
 {
 	stagesurf->device->context->Unmap(stagesurf->texture, 0);
@@ -0,0 +1,182 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/base.h>
+#include <util/bmem.h>
+#include "null-subsystem.h"
+
+static size_t get_vb_data_size(const struct gs_vb_data *data,
+		size_t num_tex)
+{
+	size_t size = 0;
+
+	if (data->points)
+		size += data->num * sizeof(struct vec3);
+	if (data->normals)
+		size += data->num * sizeof(struct vec3);
+	if (data->tangents)
+		size += data->num * sizeof(struct vec3);
+	if (data->colors)
+		size += data->num * sizeof(uint32_t);
+
+	for (size_t i = 0; i < num_tex; i++)
+		size += data->num * data->tvarray[i].width * sizeof(float);
+
+	return size;
+}
+
+gs_vertbuffer_t *device_vertexbuffer_create(gs_device_t *device,
+		struct gs_vb_data *data, uint32_t flags)
+{
+	struct gs_vertex_buffer *vb = bzalloc(sizeof(struct gs_vertex_buffer));
+	vb->device  = device;
+	vb->data    = data;
+	vb->num     = data->num;
+	vb->dynamic = (flags & GS_DYNAMIC) != 0;
+
+	device->stats.buffer_upload_bytes +=
+		get_vb_data_size(data, data->num_tex);
+
+	/* like GPU backends, only dynamic buffers keep their data */
+	if (!vb->dynamic) {
+		gs_vbdata_destroy(vb->data);
+		vb->data = NULL;
+	}
+
+	return vb;
+}
+
+void gs_vertexbuffer_destroy(gs_vertbuffer_t *vb)
+{
+	if (vb) {
+		if (vb->device->cur_vertex_buffer == vb)
+			vb->device->cur_vertex_buffer = NULL;
+
+		gs_vbdata_destroy(vb->data);
+		bfree(vb);
+	}
+}
+
+static inline void gs_vertexbuffer_flush_internal(gs_vertbuffer_t *vb,
+		const struct gs_vb_data *data)
+{
+	size_t num_tex;
+
+	if (!vb->dynamic) {
+		blog(LOG_ERROR, "gs_vertexbuffer_flush (null): vertex buffer "
+				"is not dynamic");
+		return;
+	}
+
+	num_tex = data->num_tex < vb->data->num_tex ?
+		data->num_tex : vb->data->num_tex;
+
+	vb->device->stats.buffer_upload_bytes +=
+		get_vb_data_size(data, num_tex);
+}
+
+void gs_vertexbuffer_flush(gs_vertbuffer_t *vertbuffer)
+{
+	gs_vertexbuffer_flush_internal(vertbuffer, vertbuffer->data);
+}
+
+void gs_vertexbuffer_flush_direct(gs_vertbuffer_t *vertbuffer,
+		const struct gs_vb_data *data)
+{
+	gs_vertexbuffer_flush_internal(vertbuffer, data);
+}
+
+struct gs_vb_data *gs_vertexbuffer_get_data(const gs_vertbuffer_t *vertbuffer)
+{
+	return vertbuffer->data;
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_indexbuffer_t *device_indexbuffer_create(gs_device_t *device,
+		enum gs_index_type type, void *indices, size_t num,
+		uint32_t flags)
+{
+	struct gs_index_buffer *ib = bzalloc(sizeof(struct gs_index_buffer));
+	size_t width = type == GS_UNSIGNED_LONG ? sizeof(long) : sizeof(short);
+
+	ib->device  = device;
+	ib->data    = indices;
+	ib->dynamic = (flags & GS_DYNAMIC) != 0;
+	ib->num     = num;
+	ib->width   = width;
+	ib->size    = width * num;
+	ib->type    = type;
+
+	device->stats.buffer_upload_bytes += ib->size;
+
+	if (!ib->dynamic) {
+		bfree(ib->data);
+		ib->data = NULL;
+	}
+
+	return ib;
+}
+
+void gs_indexbuffer_destroy(gs_indexbuffer_t *ib)
+{
+	if (ib) {
+		if (ib->device->cur_index_buffer == ib)
+			ib->device->cur_index_buffer = NULL;
+
+		bfree(ib->data);
+		bfree(ib);
+	}
+}
+
+static inline void gs_indexbuffer_flush_internal(gs_indexbuffer_t *ib,
+		const void *data)
+{
+	if (!ib->dynamic) {
+		blog(LOG_ERROR, "gs_indexbuffer_flush (null): index buffer "
+				"is not dynamic");
+		return;
+	}
+
+	ib->device->stats.buffer_upload_bytes += ib->size;
+	UNUSED_PARAMETER(data);
+}
+
+void gs_indexbuffer_flush(gs_indexbuffer_t *ib)
+{
+	gs_indexbuffer_flush_internal(ib, ib->data);
+}
+
+void gs_indexbuffer_flush_direct(gs_indexbuffer_t *ib, const void *data)
+{
+	gs_indexbuffer_flush_internal(ib, data);
+}
+
+void *gs_indexbuffer_get_data(const gs_indexbuffer_t *ib)
+{
+	return ib->data;
+}
+
+size_t gs_indexbuffer_get_num_indices(const gs_indexbuffer_t *ib)
+{
+	return ib->num;
+}
+
+enum gs_index_type gs_indexbuffer_get_type(const gs_indexbuffer_t *ib)
+{
+	return ib->type;
+}
@@ -0,0 +1,660 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/base.h>
+#include <util/bmem.h>
+#include "null-subsystem.h"
+
+const char *device_get_name(void)
+{
+	return "Null";
+}
+
+int device_get_type(void)
+{
+	return GS_DEVICE_NULL;
+}
+
+const char *device_preprocessor_name(void)
+{
+	return "_NULL";
+}
+
+int device_create(gs_device_t **p_device, uint32_t adapter)
+{
+	struct gs_device *device = bzalloc(sizeof(struct gs_device));
+
+	blog(LOG_INFO, "---------------------------------");
+	blog(LOG_INFO, "Initializing null graphics...");
+	blog(LOG_INFO, "Null graphics loaded successfully: draw calls will "
+			"not be rasterized");
+
+	matrix4_identity(&device->cur_proj);
+	matrix4_identity(&device->cur_view);
+	matrix4_identity(&device->cur_viewproj);
+
+	*p_device = device;
+
+	UNUSED_PARAMETER(adapter);
+	return GS_SUCCESS;
+}
+
+void device_destroy(gs_device_t *device)
+{
+	if (device) {
+		struct null_stats *stats = &device->stats;
+
+		blog(LOG_INFO, "Null graphics: %llu draw calls (%llu vertices), "
+				"%llu clears, %llu copies, %llu stages, "
+				"%llu presents",
+				(unsigned long long)stats->draw_calls,
+				(unsigned long long)stats->vertices,
+				(unsigned long long)stats->clears,
+				(unsigned long long)stats->copies,
+				(unsigned long long)stats->stages,
+				(unsigned long long)stats->presents);
+		blog(LOG_INFO, "Null graphics: %llu bytes uploaded to "
+				"textures, %llu bytes uploaded to buffers, "
+				"%llu bytes staged for download",
+				(unsigned long long)stats->texture_upload_bytes,
+				(unsigned long long)stats->buffer_upload_bytes,
+				(unsigned long long)stats->download_bytes);
+
+		da_free(device->proj_stack);
+		bfree(device);
+	}
+}
+
+void device_enter_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_leave_context(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+gs_swapchain_t *device_swapchain_create(gs_device_t *device,
+		const struct gs_init_data *info)
+{
+	struct gs_swap_chain *swap = bzalloc(sizeof(struct gs_swap_chain));
+
+	swap->device = device;
+	swap->info   = *info;
+	return swap;
+}
+
+void gs_swapchain_destroy(gs_swapchain_t *swapchain)
+{
+	if (!swapchain)
+		return;
+
+	if (swapchain->device->cur_swap == swapchain)
+		device_load_swapchain(swapchain->device, NULL);
+
+	bfree(swapchain);
+}
+
+void device_resize(gs_device_t *device, uint32_t cx, uint32_t cy)
+{
+	if (!device->cur_swap) {
+		blog(LOG_WARNING, "device_resize (null): No active swap");
+		return;
+	}
+
+	device->cur_swap->info.cx = cx;
+	device->cur_swap->info.cy = cy;
+}
+
+void device_get_size(const gs_device_t *device, uint32_t *cx, uint32_t *cy)
+{
+	if (device->cur_swap) {
+		*cx = device->cur_swap->info.cx;
+		*cy = device->cur_swap->info.cy;
+	} else {
+		*cx = 0;
+		*cy = 0;
+	}
+}
+
+uint32_t device_get_width(const gs_device_t *device)
+{
+	return device->cur_swap ? device->cur_swap->info.cx : 0;
+}
+
+uint32_t device_get_height(const gs_device_t *device)
+{
+	return device->cur_swap ? device->cur_swap->info.cy : 0;
+}
+
+void device_load_swapchain(gs_device_t *device, gs_swapchain_t *swapchain)
+{
+	device->cur_swap = swapchain;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void device_load_vertexbuffer(gs_device_t *device, gs_vertbuffer_t *vb)
+{
+	device->cur_vertex_buffer = vb;
+}
+
+void device_load_indexbuffer(gs_device_t *device, gs_indexbuffer_t *ib)
+{
+	device->cur_index_buffer = ib;
+}
+
+void device_load_texture(gs_device_t *device, gs_texture_t *tex, int unit)
+{
+	if (unit < 0 || unit >= GS_MAX_TEXTURES)
+		return;
+
+	device->cur_textures[unit] = tex;
+}
+
+void device_load_samplerstate(gs_device_t *device,
+		gs_samplerstate_t *ss, int unit)
+{
+	if (unit < 0 || unit >= GS_MAX_TEXTURES)
+		return;
+
+	device->cur_samplers[unit] = ss;
+}
+
+void device_load_vertexshader(gs_device_t *device, gs_shader_t *vertshader)
+{
+	if (vertshader && vertshader->type != GS_SHADER_VERTEX) {
+		blog(LOG_ERROR, "device_load_vertexshader (null): Specified "
+				"shader is not a vertex shader");
+		return;
+	}
+
+	device->cur_vertex_shader = vertshader;
+}
+
+void device_load_pixelshader(gs_device_t *device, gs_shader_t *pixelshader)
+{
+	if (pixelshader && pixelshader->type != GS_SHADER_PIXEL) {
+		blog(LOG_ERROR, "device_load_pixelshader (null): Specified "
+				"shader is not a pixel shader");
+		return;
+	}
+
+	device->cur_pixel_shader = pixelshader;
+
+	if (pixelshader) {
+		for (size_t i = 0; i < pixelshader->samplers.num; i++)
+			device_load_samplerstate(device,
+					pixelshader->samplers.array[i],
+					(int)i);
+	}
+}
+
+/* nothing is sampled, so the default state is just no sampler state */
+void device_load_default_samplerstate(gs_device_t *device, bool b_3d,
+		int unit)
+{
+	UNUSED_PARAMETER(b_3d);
+	device_load_samplerstate(device, NULL, unit);
+}
+
+gs_shader_t *device_get_vertex_shader(const gs_device_t *device)
+{
+	return device->cur_vertex_shader;
+}
+
+gs_shader_t *device_get_pixel_shader(const gs_device_t *device)
+{
+	return device->cur_pixel_shader;
+}
+
+gs_texture_t *device_get_render_target(const gs_device_t *device)
+{
+	return device->cur_render_target;
+}
+
+gs_zstencil_t *device_get_zstencil_target(const gs_device_t *device)
+{
+	return device->cur_zstencil_buffer;
+}
+
+void device_set_render_target(gs_device_t *device, gs_texture_t *tex,
+		gs_zstencil_t *zstencil)
+{
+	if (tex) {
+		if (tex->type != GS_TEXTURE_2D) {
+			blog(LOG_ERROR, "device_set_render_target (null): "
+					"texture is not a 2D texture");
+			return;
+		}
+		if (!tex->is_render_target) {
+			blog(LOG_ERROR, "device_set_render_target (null): "
+					"texture is not a render target");
+			return;
+		}
+	}
+
+	device->cur_render_target   = tex;
+	device->cur_render_side     = 0;
+	device->cur_zstencil_buffer = zstencil;
+}
+
+void device_set_cube_render_target(gs_device_t *device, gs_texture_t *cubetex,
+		int side, gs_zstencil_t *zstencil)
+{
+	if (cubetex) {
+		if (cubetex->type != GS_TEXTURE_CUBE) {
+			blog(LOG_ERROR, "device_set_cube_render_target (null): "
+					"texture is not a cube texture");
+			return;
+		}
+		if (!cubetex->is_render_target) {
+			blog(LOG_ERROR, "device_set_cube_render_target (null): "
+					"texture is not a render target");
+			return;
+		}
+	}
+
+	device->cur_render_target   = cubetex;
+	device->cur_render_side     = side;
+	device->cur_zstencil_buffer = zstencil;
+}
+
+void device_copy_texture_region(gs_device_t *device,
+		gs_texture_t *dst, uint32_t dst_x, uint32_t dst_y,
+		gs_texture_t *src, uint32_t src_x, uint32_t src_y,
+		uint32_t src_w, uint32_t src_h)
+{
+	struct gs_texture_2d *src2d = (struct gs_texture_2d*)src;
+	struct gs_texture_2d *dst2d = (struct gs_texture_2d*)dst;
+	uint32_t bytes_per_pixel;
+	uint32_t nw, nh;
+
+	if (!src) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Source texture is NULL");
+		return;
+	}
+	if (!dst) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Destination texture is NULL");
+		return;
+	}
+	if (dst->type != GS_TEXTURE_2D || src->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Source and destination textures must be 2D "
+				"textures");
+		return;
+	}
+	if (dst->format != src->format) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Source and destination formats do not match");
+		return;
+	}
+	if (gs_is_compressed_format(src->format)) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Compressed textures cannot be copied");
+		return;
+	}
+
+	nw = src_w ? src_w : (src2d->width - src_x);
+	nh = src_h ? src_h : (src2d->height - src_y);
+
+	if (dst2d->width - dst_x < nw || dst2d->height - dst_y < nh) {
+		blog(LOG_ERROR, "device_copy_texture_region (null): "
+				"Destination texture region is not big "
+				"enough to hold the source region");
+		return;
+	}
+
+	bytes_per_pixel = gs_get_format_bpp(src->format) / 8;
+
+	for (uint32_t y = 0; y < nh; y++) {
+		const uint8_t *in = src->data + (src_y + y) * src->linesize +
+			src_x * bytes_per_pixel;
+		uint8_t *out = dst->data + (dst_y + y) * dst->linesize +
+			dst_x * bytes_per_pixel;
+
+		memcpy(out, in, nw * bytes_per_pixel);
+	}
+
+	device->stats.copies++;
+}
+
+void device_copy_texture(gs_device_t *device, gs_texture_t *dst,
+		gs_texture_t *src)
+{
+	device_copy_texture_region(device, dst, 0, 0, src, 0, 0, 0, 0);
+}
+
+void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
+		gs_texture_t *src)
+{
+	struct gs_texture_2d *tex2d = (struct gs_texture_2d*)src;
+
+	if (!src) {
+		blog(LOG_ERROR, "device_stage_texture (null): "
+				"Source texture is NULL");
+		return;
+	}
+	if (src->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "device_stage_texture (null): "
+				"Source texture must be a 2D texture");
+		return;
+	}
+	if (!dst) {
+		blog(LOG_ERROR, "device_stage_texture (null): "
+				"Destination surface is NULL");
+		return;
+	}
+	if (src->format != dst->format ||
+	    tex2d->width != dst->width || tex2d->height != dst->height) {
+		blog(LOG_ERROR, "device_stage_texture (null): "
+				"Source and destination must have the same "
+				"size and format");
+		return;
+	}
+
+	memcpy(dst->data, src->data, (size_t)dst->linesize * dst->height);
+
+	device->stats.stages++;
+	device->stats.download_bytes += (size_t)dst->linesize * dst->height;
+}
+
+void device_begin_scene(gs_device_t *device)
+{
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++)
+		device->cur_textures[i] = NULL;
+}
+
+static void update_viewproj_matrix(struct gs_device *device)
+{
+	struct gs_shader *vs = device->cur_vertex_shader;
+
+	gs_matrix_get(&device->cur_view);
+
+	matrix4_mul(&device->cur_viewproj, &device->cur_view,
+			&device->cur_proj);
+	matrix4_transpose(&device->cur_viewproj, &device->cur_viewproj);
+
+	if (vs->viewproj)
+		gs_shader_set_matrix4(vs->viewproj, &device->cur_viewproj);
+}
+
+static inline void update_shader_params(struct gs_shader *shader)
+{
+	for (size_t i = 0; i < shader->params.num; i++) {
+		struct gs_shader_param *param = shader->params.array + i;
+
+		param->changed = false;
+		param->next_sampler = NULL;
+	}
+}
+
+void device_draw(gs_device_t *device, enum gs_draw_mode draw_mode,
+		uint32_t start_vert, uint32_t num_verts)
+{
+	gs_effect_t *effect = gs_get_effect();
+
+	if (!device->cur_vertex_shader || !device->cur_pixel_shader) {
+		blog(LOG_ERROR, "device_draw (null): No shader loaded");
+		return;
+	}
+
+	if (!device->cur_vertex_buffer) {
+		blog(LOG_ERROR, "device_draw (null): No vertex buffer loaded");
+		return;
+	}
+
+	if (effect)
+		gs_effect_update_params(effect);
+
+	update_viewproj_matrix(device);
+	update_shader_params(device->cur_vertex_shader);
+	update_shader_params(device->cur_pixel_shader);
+
+	if (num_verts == 0)
+		num_verts = (uint32_t)(device->cur_index_buffer ?
+				device->cur_index_buffer->num :
+				device->cur_vertex_buffer->num);
+
+	device->stats.draw_calls++;
+	device->stats.vertices += num_verts;
+
+	UNUSED_PARAMETER(draw_mode);
+	UNUSED_PARAMETER(start_vert);
+}
+
+void device_end_scene(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_clear(gs_device_t *device, uint32_t clear_flags,
+		const struct vec4 *color, float depth, uint8_t stencil)
+{
+	if ((clear_flags & GS_CLEAR_COLOR) != 0 && device->cur_render_target)
+		null_texture_clear(device->cur_render_target,
+				device->cur_render_side, color);
+
+	device->stats.clears++;
+
+	UNUSED_PARAMETER(depth);
+	UNUSED_PARAMETER(stencil);
+}
+
+void device_present(gs_device_t *device)
+{
+	device->stats.presents++;
+}
+
+void device_flush(gs_device_t *device)
+{
+	UNUSED_PARAMETER(device);
+}
+
+void device_set_cull_mode(gs_device_t *device, enum gs_cull_mode mode)
+{
+	device->cur_cull_mode = mode;
+}
+
+enum gs_cull_mode device_get_cull_mode(const gs_device_t *device)
+{
+	return device->cur_cull_mode;
+}
+
+void device_enable_blending(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_depth_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_test(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_stencil_write(gs_device_t *device, bool enable)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(enable);
+}
+
+void device_enable_color(gs_device_t *device, bool red, bool green,
+		bool blue, bool alpha)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(red);
+	UNUSED_PARAMETER(green);
+	UNUSED_PARAMETER(blue);
+	UNUSED_PARAMETER(alpha);
+}
+
+void device_blend_function(gs_device_t *device, enum gs_blend_type src,
+		enum gs_blend_type dest)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(src);
+	UNUSED_PARAMETER(dest);
+}
+
+void device_blend_function_separate(gs_device_t *device,
+		enum gs_blend_type src_c, enum gs_blend_type dest_c,
+		enum gs_blend_type src_a, enum gs_blend_type dest_a)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(src_c);
+	UNUSED_PARAMETER(dest_c);
+	UNUSED_PARAMETER(src_a);
+	UNUSED_PARAMETER(dest_a);
+}
+
+void device_depth_function(gs_device_t *device, enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_function(gs_device_t *device, enum gs_stencil_side side,
+		enum gs_depth_test test)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(test);
+}
+
+void device_stencil_op(gs_device_t *device, enum gs_stencil_side side,
+		enum gs_stencil_op_type fail, enum gs_stencil_op_type zfail,
+		enum gs_stencil_op_type zpass)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(side);
+	UNUSED_PARAMETER(fail);
+	UNUSED_PARAMETER(zfail);
+	UNUSED_PARAMETER(zpass);
+}
+
+void device_set_viewport(gs_device_t *device, int x, int y, int width,
+		int height)
+{
+	device->cur_viewport.x  = x;
+	device->cur_viewport.y  = y;
+	device->cur_viewport.cx = width;
+	device->cur_viewport.cy = height;
+}
+
+void device_get_viewport(const gs_device_t *device, struct gs_rect *rect)
+{
+	*rect = device->cur_viewport;
+}
+
+void device_set_scissor_rect(gs_device_t *device, const struct gs_rect *rect)
+{
+	UNUSED_PARAMETER(device);
+	UNUSED_PARAMETER(rect);
+}
+
+void device_ortho(gs_device_t *device, float left, float right,
+		float top, float bottom, float zNear, float zFar)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml = right-left;
+	float bmt = bottom-top;
+	float fmn = zFar-zNear;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x =         2.0f /  rml;
+	dst->t.x = (left+right) / -rml;
+
+	dst->y.y =         2.0f / -bmt;
+	dst->t.y = (bottom+top) /  bmt;
+
+	dst->z.z =         1.0f /  fmn;
+	dst->t.z =         zNear / -fmn;
+
+	dst->t.w = 1.0f;
+}
+
+void device_frustum(gs_device_t *device, float left, float right,
+		float top, float bottom, float zNear, float zFar)
+{
+	struct matrix4 *dst = &device->cur_proj;
+
+	float rml    = right-left;
+	float bmt    = bottom-top;
+	float fmn    = zFar-zNear;
+	float nearx2 = 2.0f*zNear;
+
+	vec4_zero(&dst->x);
+	vec4_zero(&dst->y);
+	vec4_zero(&dst->z);
+	vec4_zero(&dst->t);
+
+	dst->x.x =         nearx2 /  rml;
+	dst->z.x = (left+right)   / -rml;
+
+	dst->y.y =         nearx2 / -bmt;
+	dst->z.y = (bottom+top)   /  bmt;
+
+	dst->z.z =           zFar  /  fmn;
+	dst->t.z =    (zNear*zFar)  / -fmn;
+
+	dst->z.w = 1.0f;
+}
+
+void device_projection_push(gs_device_t *device)
+{
+	da_push_back(device->proj_stack, &device->cur_proj);
+}
+
+void device_projection_pop(gs_device_t *device)
+{
+	struct matrix4 *end;
+	if (!device->proj_stack.num)
+		return;
+
+	end = da_end(device->proj_stack);
+	device->cur_proj = *end;
+	da_pop_back(device->proj_stack);
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef _WIN32
+bool device_gdi_texture_available(void)
+{
+	return false;
+}
+
+bool device_shared_texture_available(void)
+{
+	return false;
+}
+#endif
@@ -0,0 +1,185 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ *   Headless graphics subsystem.  Does not require a GPU or a display:
+ * textures and staging surfaces are kept in system memory, so uploads,
+ * clears, copies and staging operate on real pixel data, while draw calls
+ * only perform the CPU-side work (parameter updates, matrix setup) and are
+ * otherwise counted but not rasterized.  Intended for profiling and testing
+ * the render pipeline on machines without a GPU.
+ */
+
+#include <util/darray.h>
+#include <graphics/graphics.h>
+#include <graphics/device-exports.h>
+#include <graphics/matrix4.h>
+
+struct gs_sampler_state {
+	gs_device_t          *device;
+	struct gs_sampler_info info;
+};
+
+struct gs_shader_param {
+	enum gs_shader_type  shader_type;
+	enum gs_shader_param_type type;
+
+	char                 *name;
+	gs_shader_t          *shader;
+	gs_samplerstate_t    *next_sampler;
+	int                  array_count;
+
+	struct gs_texture    *texture;
+
+	DARRAY(uint8_t)      cur_value;
+	DARRAY(uint8_t)      def_value;
+	bool                 changed;
+};
+
+struct gs_shader {
+	gs_device_t          *device;
+	enum gs_shader_type  type;
+
+	struct gs_shader_param  *viewproj;
+	struct gs_shader_param  *world;
+
+	DARRAY(struct gs_shader_param) params;
+	DARRAY(gs_samplerstate_t*)      samplers;
+};
+
+struct gs_vertex_buffer {
+	gs_device_t          *device;
+	size_t               num;
+	bool                 dynamic;
+	struct gs_vb_data    *data;
+};
+
+struct gs_index_buffer {
+	gs_device_t          *device;
+	enum gs_index_type   type;
+	void                 *data;
+	size_t               num;
+	size_t               width;
+	size_t               size;
+	bool                 dynamic;
+};
+
+struct gs_texture {
+	gs_device_t          *device;
+	enum gs_texture_type type;
+	enum gs_color_format format;
+	uint32_t             levels;
+	bool                 is_dynamic;
+	bool                 is_render_target;
+
+	/* level 0 only, all faces/slices stored one after another */
+	uint8_t              *data;
+	uint32_t             linesize;
+	size_t               face_size;
+	bool                 mapped;
+};
+
+struct gs_texture_2d {
+	struct gs_texture    base;
+
+	uint32_t             width;
+	uint32_t             height;
+};
+
+struct gs_texture_cube {
+	struct gs_texture    base;
+
+	uint32_t             size;
+};
+
+struct gs_texture_3d {
+	struct gs_texture    base;
+
+	uint32_t             width;
+	uint32_t             height;
+	uint32_t             depth;
+};
+
+struct gs_stage_surface {
+	gs_device_t          *device;
+
+	enum gs_color_format format;
+	uint32_t             width;
+	uint32_t             height;
+
+	uint8_t              *data;
+	uint32_t             linesize;
+};
+
+struct gs_zstencil_buffer {
+	gs_device_t          *device;
+	enum gs_zstencil_format format;
+	uint32_t             width;
+	uint32_t             height;
+};
+
+struct gs_swap_chain {
+	gs_device_t          *device;
+	struct gs_init_data  info;
+};
+
+struct null_stats {
+	uint64_t             draw_calls;
+	uint64_t             vertices;
+	uint64_t             clears;
+	uint64_t             copies;
+	uint64_t             stages;
+	uint64_t             presents;
+	uint64_t             texture_upload_bytes;
+	uint64_t             buffer_upload_bytes;
+	uint64_t             download_bytes;
+};
+
+struct gs_device {
+	gs_texture_t         *cur_render_target;
+	gs_zstencil_t        *cur_zstencil_buffer;
+	int                  cur_render_side;
+	gs_texture_t         *cur_textures[GS_MAX_TEXTURES];
+	gs_samplerstate_t    *cur_samplers[GS_MAX_TEXTURES];
+	gs_vertbuffer_t      *cur_vertex_buffer;
+	gs_indexbuffer_t     *cur_index_buffer;
+	gs_shader_t          *cur_vertex_shader;
+	gs_shader_t          *cur_pixel_shader;
+	gs_swapchain_t       *cur_swap;
+
+	enum gs_cull_mode    cur_cull_mode;
+	struct gs_rect       cur_viewport;
+
+	struct matrix4       cur_proj;
+	struct matrix4       cur_view;
+	struct matrix4       cur_viewproj;
+
+	DARRAY(struct matrix4) proj_stack;
+
+	struct null_stats    stats;
+};
+
+static inline uint32_t null_get_linesize(enum gs_color_format format,
+		uint32_t width)
+{
+	return width * gs_get_format_bpp(format) / 8;
+}
+
+extern void null_texture_clear(struct gs_texture *tex, int side,
+		const struct vec4 *color);
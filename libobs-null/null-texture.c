@@ -0,0 +1,437 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/base.h>
+#include <util/bmem.h>
+#include <graphics/vec4.h>
+#include "null-subsystem.h"
+
+static bool init_texture(struct gs_device *device, struct gs_texture *tex,
+		enum gs_texture_type type, enum gs_color_format format,
+		uint32_t width, uint32_t height, uint32_t faces,
+		uint32_t levels, const uint8_t **data, uint32_t flags)
+{
+	if (gs_get_format_bpp(format) == 0) {
+		blog(LOG_ERROR, "Invalid texture format");
+		return false;
+	}
+
+	tex->device           = device;
+	tex->type             = type;
+	tex->format           = format;
+	tex->levels           = levels;
+	tex->is_dynamic       = (flags & GS_DYNAMIC) != 0;
+	tex->is_render_target = (flags & GS_RENDER_TARGET) != 0;
+	tex->linesize         = null_get_linesize(format, width);
+	tex->face_size        = (size_t)tex->linesize * height;
+	tex->data             = bzalloc(tex->face_size * faces);
+
+	/* only the first mip level of each face is kept */
+	if (data) {
+		for (uint32_t i = 0; i < faces; i++) {
+			if (!data[i * levels])
+				continue;
+
+			memcpy(tex->data + tex->face_size * i,
+					data[i * levels], tex->face_size);
+		}
+
+		device->stats.texture_upload_bytes += tex->face_size * faces;
+	}
+
+	return true;
+}
+
+gs_texture_t *device_texture_create(gs_device_t *device, uint32_t width,
+		uint32_t height, enum gs_color_format color_format,
+		uint32_t levels, const uint8_t **data, uint32_t flags)
+{
+	struct gs_texture_2d *tex = bzalloc(sizeof(struct gs_texture_2d));
+
+	if (levels == 0)
+		levels = 1;
+
+	tex->width  = width;
+	tex->height = height;
+
+	if (!init_texture(device, &tex->base, GS_TEXTURE_2D, color_format,
+				width, height, 1, levels, data, flags)) {
+		blog(LOG_ERROR, "device_texture_create (null) failed");
+		bfree(tex);
+		return NULL;
+	}
+
+	return (gs_texture_t*)tex;
+}
+
+gs_texture_t *device_cubetexture_create(gs_device_t *device, uint32_t size,
+		enum gs_color_format color_format, uint32_t levels,
+		const uint8_t **data, uint32_t flags)
+{
+	struct gs_texture_cube *tex = bzalloc(sizeof(struct gs_texture_cube));
+
+	if (levels == 0)
+		levels = 1;
+
+	tex->size = size;
+
+	if (!init_texture(device, &tex->base, GS_TEXTURE_CUBE, color_format,
+				size, size, 6, levels, data, flags)) {
+		blog(LOG_ERROR, "device_cubetexture_create (null) failed");
+		bfree(tex);
+		return NULL;
+	}
+
+	return (gs_texture_t*)tex;
+}
+
+gs_texture_t *device_voltexture_create(gs_device_t *device, uint32_t width,
+		uint32_t height, uint32_t depth,
+		enum gs_color_format color_format, uint32_t levels,
+		const uint8_t **data, uint32_t flags)
+{
+	struct gs_texture_3d *tex = bzalloc(sizeof(struct gs_texture_3d));
+
+	if (levels == 0)
+		levels = 1;
+
+	tex->width  = width;
+	tex->height = height;
+	tex->depth  = depth;
+
+	/* slices are stored as one tall image */
+	if (!init_texture(device, &tex->base, GS_TEXTURE_3D, color_format,
+				width, height * depth, 1, 1, data, flags)) {
+		blog(LOG_ERROR, "device_voltexture_create (null) failed");
+		bfree(tex);
+		return NULL;
+	}
+
+	tex->base.levels = levels;
+	return (gs_texture_t*)tex;
+}
+
+enum gs_texture_type device_get_texture_type(const gs_texture_t *texture)
+{
+	return texture->type;
+}
+
+static inline void fill_pixels(uint8_t *data, size_t size,
+		const void *pixel, size_t pixel_size)
+{
+	for (size_t i = 0; i + pixel_size <= size; i += pixel_size)
+		memcpy(data + i, pixel, pixel_size);
+}
+
+void null_texture_clear(struct gs_texture *tex, int side,
+		const struct vec4 *color)
+{
+	uint8_t *data = tex->data;
+	uint32_t rgba;
+	uint32_t bgra;
+
+	if (tex->type == GS_TEXTURE_CUBE)
+		data += tex->face_size * (size_t)side;
+
+	switch (tex->format) {
+	case GS_RGBA:
+		rgba = vec4_to_rgba(color);
+		fill_pixels(data, tex->face_size, &rgba, sizeof(rgba));
+		break;
+	case GS_BGRA:
+	case GS_BGRX:
+		bgra = vec4_to_bgra(color);
+		fill_pixels(data, tex->face_size, &bgra, sizeof(bgra));
+		break;
+	case GS_A8:
+		memset(data, (int)(color->w * 255.0f), tex->face_size);
+		break;
+	case GS_R8:
+		memset(data, (int)(color->x * 255.0f), tex->face_size);
+		break;
+	case GS_RGBA32F:
+		fill_pixels(data, tex->face_size, color->ptr,
+				sizeof(float) * 4);
+		break;
+	case GS_R32F:
+		fill_pixels(data, tex->face_size, &color->x, sizeof(float));
+		break;
+	default:
+		/* other formats are only cleared to zero */
+		memset(data, 0, tex->face_size);
+	}
+}
+
+void gs_texture_destroy(gs_texture_t *tex)
+{
+	struct gs_device *device;
+
+	if (!tex)
+		return;
+
+	device = tex->device;
+	if (device->cur_render_target == tex)
+		device->cur_render_target = NULL;
+
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++) {
+		if (device->cur_textures[i] == tex)
+			device->cur_textures[i] = NULL;
+	}
+
+	bfree(tex->data);
+	bfree(tex);
+}
+
+uint32_t gs_texture_get_width(const gs_texture_t *tex)
+{
+	const struct gs_texture_2d *tex2d = (const struct gs_texture_2d*)tex;
+	if (tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "gs_texture_get_width (null): "
+				"texture is not 2D");
+		return 0;
+	}
+
+	return tex2d->width;
+}
+
+uint32_t gs_texture_get_height(const gs_texture_t *tex)
+{
+	const struct gs_texture_2d *tex2d = (const struct gs_texture_2d*)tex;
+	if (tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "gs_texture_get_height (null): "
+				"texture is not 2D");
+		return 0;
+	}
+
+	return tex2d->height;
+}
+
+enum gs_color_format gs_texture_get_color_format(const gs_texture_t *tex)
+{
+	return tex->format;
+}
+
+bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
+{
+	if (tex->type != GS_TEXTURE_2D) {
+		blog(LOG_ERROR, "gs_texture_map (null): texture is not 2D");
+		return false;
+	}
+	if (!tex->is_dynamic) {
+		blog(LOG_ERROR, "gs_texture_map (null): texture is not "
+				"dynamic");
+		return false;
+	}
+
+	*ptr = tex->data;
+	*linesize = tex->linesize;
+	tex->mapped = true;
+	return true;
+}
+
+void gs_texture_unmap(gs_texture_t *tex)
+{
+	if (!tex->mapped)
+		return;
+
+	tex->device->stats.texture_upload_bytes += tex->face_size;
+	tex->mapped = false;
+}
+
+bool gs_texture_is_rect(const gs_texture_t *tex)
+{
+	UNUSED_PARAMETER(tex);
+	return false;
+}
+
+void *gs_texture_get_obj(gs_texture_t *tex)
+{
+	return tex->data;
+}
+
+void gs_cubetexture_destroy(gs_texture_t *cubetex)
+{
+	gs_texture_destroy(cubetex);
+}
+
+uint32_t gs_cubetexture_get_size(const gs_texture_t *cubetex)
+{
+	const struct gs_texture_cube *cube =
+		(const struct gs_texture_cube*)cubetex;
+
+	if (cubetex->type != GS_TEXTURE_CUBE) {
+		blog(LOG_ERROR, "gs_cubetexture_get_size (null): "
+				"texture is not a cube texture");
+		return 0;
+	}
+
+	return cube->size;
+}
+
+enum gs_color_format gs_cubetexture_get_color_format(
+		const gs_texture_t *cubetex)
+{
+	return cubetex->format;
+}
+
+void gs_voltexture_destroy(gs_texture_t *voltex)
+{
+	gs_texture_destroy(voltex);
+}
+
+uint32_t gs_voltexture_get_width(const gs_texture_t *voltex)
+{
+	const struct gs_texture_3d *tex3d = (const struct gs_texture_3d*)voltex;
+	return voltex->type == GS_TEXTURE_3D ? tex3d->width : 0;
+}
+
+uint32_t gs_voltexture_get_height(const gs_texture_t *voltex)
+{
+	const struct gs_texture_3d *tex3d = (const struct gs_texture_3d*)voltex;
+	return voltex->type == GS_TEXTURE_3D ? tex3d->height : 0;
+}
+
+uint32_t gs_voltexture_get_depth(const gs_texture_t *voltex)
+{
+	const struct gs_texture_3d *tex3d = (const struct gs_texture_3d*)voltex;
+	return voltex->type == GS_TEXTURE_3D ? tex3d->depth : 0;
+}
+
+enum gs_color_format gs_voltexture_get_color_format(const gs_texture_t *voltex)
+{
+	return voltex->format;
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width,
+		uint32_t height, enum gs_color_format color_format)
+{
+	struct gs_stage_surface *surf;
+
+	if (gs_get_format_bpp(color_format) == 0) {
+		blog(LOG_ERROR, "device_stagesurface_create (null): "
+				"Invalid format");
+		return NULL;
+	}
+
+	surf = bzalloc(sizeof(struct gs_stage_surface));
+	surf->device   = device;
+	surf->format   = color_format;
+	surf->width    = width;
+	surf->height   = height;
+	surf->linesize = null_get_linesize(color_format, width);
+	surf->data     = bzalloc((size_t)surf->linesize * height);
+
+	return surf;
+}
+
+void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
+{
+	if (stagesurf) {
+		bfree(stagesurf->data);
+		bfree(stagesurf);
+	}
+}
+
+uint32_t gs_stagesurface_get_width(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->width;
+}
+
+uint32_t gs_stagesurface_get_height(const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->height;
+}
+
+enum gs_color_format gs_stagesurface_get_color_format(
+		const gs_stagesurf_t *stagesurf)
+{
+	return stagesurf->format;
+}
+
+bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+		uint32_t *linesize)
+{
+	*data = stagesurf->data;
+	*linesize = stagesurf->linesize;
+	return true;
+}
+
+/* staging is done immediately, so the copy is always complete */
+bool gs_stagesurface_try_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+		uint32_t *linesize)
+{
+	return gs_stagesurface_map(stagesurf, data, linesize);
+}
+
+void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
+{
+	UNUSED_PARAMETER(stagesurf);
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_zstencil_t *device_zstencil_create(gs_device_t *device, uint32_t width,
+		uint32_t height, enum gs_zstencil_format format)
+{
+	struct gs_zstencil_buffer *zs;
+
+	zs = bzalloc(sizeof(struct gs_zstencil_buffer));
+	zs->device = device;
+	zs->format = format;
+	zs->width  = width;
+	zs->height = height;
+
+	return zs;
+}
+
+void gs_zstencil_destroy(gs_zstencil_t *zs)
+{
+	if (zs) {
+		if (zs->device->cur_zstencil_buffer == zs)
+			zs->device->cur_zstencil_buffer = NULL;
+		bfree(zs);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+gs_samplerstate_t *device_samplerstate_create(gs_device_t *device,
+		const struct gs_sampler_info *info)
+{
+	struct gs_sampler_state *sampler;
+
+	sampler = bzalloc(sizeof(struct gs_sampler_state));
+	sampler->device = device;
+	sampler->info   = *info;
+
+	return sampler;
+}
+
+void gs_samplerstate_destroy(gs_samplerstate_t *samplerstate)
+{
+	if (!samplerstate)
+		return;
+
+	for (size_t i = 0; i < GS_MAX_TEXTURES; i++) {
+		if (samplerstate->device->cur_samplers[i] == samplerstate)
+			samplerstate->device->cur_samplers[i] = NULL;
+	}
+
+	bfree(samplerstate);
+}
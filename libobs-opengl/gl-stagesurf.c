@@ -65,9 +65,36 @@ gs_stagesurf_t *device_stagesurface_create(gs_device_t *device, uint32_t width,
 	return surf;
 }
 
+static inline bool gl_sync_supported(void)
+{
+	return GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync;
+}
+
+static inline void gl_delete_sync(struct gs_stage_surface *surf)
+{
+	if (surf->sync) {
+		glDeleteSync(surf->sync);
+		surf->sync = NULL;
+	}
+}
+
+/* lets gs_stagesurface_try_map know when the pack buffer has been written */
+static inline void gl_insert_fence(struct gs_stage_surface *surf)
+{
+	if (!gl_sync_supported())
+		return;
+
+	gl_delete_sync(surf);
+
+	surf->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_success("glFenceSync");
+}
+
 void gs_stagesurface_destroy(gs_stagesurf_t *stagesurf)
 {
 	if (stagesurf) {
+		gl_delete_sync(stagesurf);
+
 		if (stagesurf->pack_buffer)
 			gl_delete_buffers(1, &stagesurf->pack_buffer);
 
@@ -141,6 +168,7 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
 	if (!gl_success("glReadPixels"))
 		goto failed_unbind_all;
 
+	gl_insert_fence(dst);
 	success = true;
 
 failed_unbind_all:
@@ -172,6 +200,8 @@ void device_stage_texture(gs_device_t *device, gs_stagesurf_t *dst,
 	if (!gl_success("glGetTexImage"))
 		goto failed;
 
+	gl_insert_fence(dst);
+
 	gl_bind_texture(GL_TEXTURE_2D, 0);
 	gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 	return;
@@ -205,6 +235,9 @@ enum gs_color_format gs_stagesurface_get_color_format(
 bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 		uint32_t *linesize)
 {
+	/* mapping waits for the copy anyway */
+	gl_delete_sync(stagesurf);
+
 	if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, stagesurf->pack_buffer))
 		goto fail;
 
@@ -222,6 +255,24 @@ fail:
 	return false;
 }
 
+bool gs_stagesurface_try_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+		uint32_t *linesize)
+{
+	GLenum ret;
+
+	if (!stagesurf->sync)
+		return gl_sync_supported() &&
+			gs_stagesurface_map(stagesurf, data, linesize);
+
+	ret = glClientWaitSync(stagesurf->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (ret == GL_TIMEOUT_EXPIRED)
+		return false;
+	if (ret == GL_WAIT_FAILED)
+		gl_success("glClientWaitSync");
+
+	return gs_stagesurface_map(stagesurf, data, linesize);
+}
+
 void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
 {
 	if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, stagesurf->pack_buffer))
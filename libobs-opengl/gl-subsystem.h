@@ -411,6 +411,8 @@ struct gs_texture {
 	gs_samplerstate_t    *cur_sampler;
 };
 
+#define GL_UPLOAD_RING_SIZE 3
+
 struct gs_texture_2d {
 	struct gs_texture    base;
 
@@ -418,6 +420,13 @@ struct gs_texture_2d {
 	uint32_t             height;
 	bool                 gen_mipmaps;
 	GLuint               unpack_buffer;
+
+	/* persistently mapped ring of upload slots within unpack_buffer,
+	 * only used if buffer storage is available */
+	uint8_t              *upload_ptr;
+	size_t               upload_size;
+	uint32_t             upload_slot;
+	GLsync               upload_fences[GL_UPLOAD_RING_SIZE];
 };
 
 struct gs_texture_cube {
@@ -438,6 +447,7 @@ struct gs_stage_surface {
 	GLint                gl_internal_format;
 	GLenum               gl_type;
 	GLuint               pack_buffer;
+	GLsync               sync;
 };
 
 struct gs_zstencil_buffer {
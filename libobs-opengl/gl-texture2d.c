@@ -43,6 +43,36 @@ static bool upload_texture_2d(struct gs_texture_2d *tex, const uint8_t **data)
 	return success;
 }
 
+static inline bool can_use_upload_ring(struct gs_texture_2d *tex)
+{
+	return (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) &&
+		!gs_is_compressed_format(tex->base.format);
+}
+
+/* Allocates GL_UPLOAD_RING_SIZE upload slots and keeps them mapped for the
+ * lifetime of the texture, so that the next frame can be written while the
+ * GPU is still reading the previous ones. */
+static bool create_upload_ring(struct gs_texture_2d *tex, GLsizeiptr size)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+		GL_MAP_COHERENT_BIT;
+	GLsizeiptr total_size = size * GL_UPLOAD_RING_SIZE;
+
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, total_size, NULL, flags);
+	if (!gl_success("glBufferStorage"))
+		return false;
+
+	tex->upload_ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+			total_size, flags);
+	if (!gl_success("glMapBufferRange") || !tex->upload_ptr) {
+		tex->upload_ptr = NULL;
+		return false;
+	}
+
+	tex->upload_size = (size_t)size;
+	return true;
+}
+
 static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 {
 	GLsizeiptr size;
@@ -64,10 +94,27 @@ static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 		size /= 8;
 	}
 
+	if (can_use_upload_ring(tex)) {
+		if (create_upload_ring(tex, size))
+			goto finish;
+
+		/* buffer storage is immutable, start over with a new buffer */
+		blog(LOG_WARNING, "Failed to create persistently mapped "
+		                  "upload buffer, falling back to glMapBuffer");
+		gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		gl_delete_buffers(1, &tex->unpack_buffer);
+
+		if (!gl_gen_buffers(1, &tex->unpack_buffer))
+			return false;
+		if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffer))
+			return false;
+	}
+
 	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
 	if (!gl_success("glBufferData"))
 		success = false;
 
+finish:
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
 		success = false;
 
@@ -132,6 +179,12 @@ void gs_texture_destroy(gs_texture_t *tex)
 	if (tex->cur_sampler)
 		gs_samplerstate_destroy(tex->cur_sampler);
 
+	for (size_t i = 0; i < GL_UPLOAD_RING_SIZE; i++) {
+		if (tex2d->upload_fences[i])
+			glDeleteSync(tex2d->upload_fences[i]);
+	}
+
+	/* also unmaps the upload ring */
 	if (!tex->is_dummy && tex->is_dynamic && tex2d->unpack_buffer)
 		gl_delete_buffers(1, &tex2d->unpack_buffer);
 
@@ -164,6 +217,59 @@ enum gs_color_format gs_texture_get_color_format(const gs_texture_t *tex)
 	return tex->format;
 }
 
+/* the GPU may still be reading this slot from GL_UPLOAD_RING_SIZE uploads
+ * ago, in which case this is the only place that waits for it */
+static uint8_t *map_upload_slot(struct gs_texture_2d *tex)
+{
+	GLsync *fence = &tex->upload_fences[tex->upload_slot];
+
+	if (*fence) {
+		GLenum ret = glClientWaitSync(*fence,
+				GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+		if (ret == GL_TIMEOUT_EXPIRED)
+			blog(LOG_WARNING, "gs_texture_map (GL): Timed out "
+			                  "waiting for upload slot");
+		else if (ret == GL_WAIT_FAILED)
+			gl_success("glClientWaitSync");
+
+		glDeleteSync(*fence);
+		*fence = NULL;
+	}
+
+	return tex->upload_ptr + tex->upload_slot * tex->upload_size;
+}
+
+static void unmap_upload_slot(struct gs_texture_2d *tex)
+{
+	GLsync *fence = &tex->upload_fences[tex->upload_slot];
+	size_t offset = tex->upload_slot * tex->upload_size;
+
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffer))
+		goto failed;
+	if (!gl_bind_texture(GL_TEXTURE_2D, tex->base.texture))
+		goto failed;
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex->width, tex->height,
+			tex->base.gl_format, tex->base.gl_type,
+			(const GLvoid*)(uintptr_t)offset);
+	if (!gl_success("glTexSubImage2D"))
+		goto failed;
+
+	*fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_success("glFenceSync");
+
+	tex->upload_slot = (tex->upload_slot + 1) % GL_UPLOAD_RING_SIZE;
+
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	return;
+
+failed:
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	blog(LOG_ERROR, "gs_texture_unmap (GL) failed");
+}
+
 bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 {
 	struct gs_texture_2d *tex2d = (struct gs_texture_2d*)tex;
@@ -176,14 +282,19 @@ bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 		goto fail;
 	}
 
-	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
-		goto fail;
+	if (tex2d->upload_ptr) {
+		*ptr = map_upload_slot(tex2d);
+	} else {
+		if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER,
+					tex2d->unpack_buffer))
+			goto fail;
 
-	*ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-	if (!gl_success("glMapBuffer"))
-		goto fail;
+		*ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+		if (!gl_success("glMapBuffer"))
+			goto fail;
 
-	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
 
 	*linesize = tex2d->width * gs_get_format_bpp(tex->format) / 8;
 	*linesize = (*linesize + 3) & 0xFFFFFFFC;
@@ -200,6 +311,11 @@ void gs_texture_unmap(gs_texture_t *tex)
 	if (!is_texture_2d(tex, "gs_texture_unmap"))
 		goto failed;
 
+	if (tex2d->upload_ptr) {
+		unmap_upload_slot(tex2d);
+		return;
+	}
+
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
 		goto failed;
 
@@ -1480,6 +1480,7 @@ static inline bool ep_compile_technique(struct effect_parser *ep, size_t idx)
 	tech_in = ep->techniques.array+idx;
 
 	tech->name = bstrdup(tech_in->name);
+	tech->name_hash = effect_name_hash(tech->name);
 	tech->section = EFFECT_TECHNIQUE;
 	tech->effect = ep->effect;
 
@@ -1505,6 +1506,10 @@ static bool ep_compile(struct effect_parser *ep)
 
 	for (i = 0; i < ep->params.num; i++)
 		ep_compile_param(ep, i);
+
+	/* passes look their parameters up by name */
+	effect_build_index(ep->effect);
+
 	for (i = 0; i < ep->techniques.num; i++) {
 		if (!ep_compile_technique(ep, i))
 			success = false;
@@ -35,14 +35,44 @@ void gs_effect_destroy(gs_effect_t *effect)
 	}
 }
 
+/* called once the effect parameters have been compiled */
+void effect_build_index(gs_effect_t *effect)
+{
+	size_t size = 8;
+	size_t mask;
+
+	while (size < effect->params.num * 2)
+		size *= 2;
+	mask = size - 1;
+
+	bfree(effect->param_index);
+	effect->param_index = bzalloc(size * sizeof(size_t));
+	effect->param_index_size = size;
+
+	for (size_t i = 0; i < effect->params.num; i++) {
+		struct gs_effect_param *param = effect->params.array+i;
+		size_t slot;
+
+		param->name_hash = effect_name_hash(param->name);
+
+		slot = param->name_hash & mask;
+		while (effect->param_index[slot])
+			slot = (slot + 1) & mask;
+
+		effect->param_index[slot] = i + 1;
+	}
+}
+
 gs_technique_t *gs_effect_get_technique(const gs_effect_t *effect,
 		const char *name)
 {
 	if (!effect) return NULL;
 
+	uint32_t hash = effect_name_hash(name);
+
 	for (size_t i = 0; i < effect->techniques.num; i++) {
 		struct gs_effect_technique *tech = effect->techniques.array+i;
-		if (strcmp(tech->name, name) == 0)
+		if (tech->name_hash == hash && strcmp(tech->name, name) == 0)
 			return tech;
 	}
 
@@ -272,20 +302,39 @@ gs_eparam_t *gs_effect_get_param_by_idx(const gs_effect_t *effect, size_t param)
 gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect,
 		const char *name)
 {
-	if (!effect) return NULL;
+	if (!effect || !effect->param_index) return NULL;
 
 	struct gs_effect_param *params = effect->params.array;
+	uint32_t hash = effect_name_hash(name);
+	size_t mask = effect->param_index_size - 1;
+	size_t slot = hash & mask;
+	size_t idx;
 
-	for (size_t i = 0; i < effect->params.num; i++) {
-		struct gs_effect_param *param = params+i;
+	while ((idx = effect->param_index[slot]) != 0) {
+		struct gs_effect_param *param = params + idx - 1;
 
-		if (strcmp(param->name, name) == 0)
+		if (param->name_hash == hash && strcmp(param->name, name) == 0)
 			return param;
+
+		slot = (slot + 1) & mask;
 	}
 
 	return NULL;
 }
 
+gs_eparam_t *gs_effect_get_param_cached(const gs_effect_t *effect,
+		const char *name, struct gs_eparam_cache *cache)
+{
+	if (!effect || !cache) return NULL;
+
+	if (cache->effect_id != effect->id) {
+		cache->param = gs_effect_get_param_by_name(effect, name);
+		cache->effect_id = effect->id;
+	}
+
+	return cache->param;
+}
+
 gs_eparam_t *gs_effect_get_viewproj_matrix(const gs_effect_t *effect)
 {
 	return effect ? effect->view_proj : NULL;
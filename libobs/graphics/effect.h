@@ -46,8 +46,23 @@ enum effect_section {
 
 /* ------------------------------------------------------------------------- */
 
+static inline uint32_t effect_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct gs_effect_param {
 	char *name;
+	uint32_t name_hash;
 	enum effect_section section;
 
 	enum gs_shader_param_type type;
@@ -114,6 +129,7 @@ static inline void effect_pass_free(struct gs_effect_pass *pass)
 
 struct gs_effect_technique {
 	char *name;
+	uint32_t name_hash;
 	enum effect_section section;
 	struct gs_effect *effect;
 
@@ -141,9 +157,17 @@ struct gs_effect {
 	bool cached;
 	char *effect_path, *effect_dir;
 
+	/* unique for the lifetime of the program, used to validate cached
+	 * parameter lookups */
+	long id;
+
 	DARRAY(struct gs_effect_param) params;
 	DARRAY(struct gs_effect_technique) techniques;
 
+	/* open addressing hash table of parameter indices + 1 */
+	size_t *param_index;
+	size_t param_index_size;
+
 	struct gs_effect_technique *cur_technique;
 	struct gs_effect_pass *cur_pass;
 
@@ -172,12 +196,17 @@ static inline void effect_free(gs_effect_t *effect)
 	da_free(effect->params);
 	da_free(effect->techniques);
 
+	bfree(effect->param_index);
+	effect->param_index = NULL;
+	effect->param_index_size = 0;
+
 	bfree(effect->effect_path);
 	bfree(effect->effect_dir);
 	effect->effect_path = NULL;
 	effect->effect_dir = NULL;
 }
 
+EXPORT void effect_build_index(gs_effect_t *effect);
 EXPORT void effect_upload_params(gs_effect_t *effect, bool changed_only);
 EXPORT void effect_upload_shader_params(gs_effect_t *effect,
 		gs_shader_t *shader, struct darray *pass_params,
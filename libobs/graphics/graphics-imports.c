@@ -133,6 +133,7 @@ bool load_graphics_imports(struct gs_exports *exports, void *module,
 	GRAPHICS_IMPORT(gs_stagesurface_get_height);
 	GRAPHICS_IMPORT(gs_stagesurface_get_color_format);
 	GRAPHICS_IMPORT(gs_stagesurface_map);
+	GRAPHICS_IMPORT_OPTIONAL(gs_stagesurface_try_map);
 	GRAPHICS_IMPORT(gs_stagesurface_unmap);
 
 	GRAPHICS_IMPORT(gs_zstencil_destroy);
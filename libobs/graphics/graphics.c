@@ -815,10 +815,13 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename,
 	if (!gs_valid_p("gs_effect_create", effect_string))
 		return NULL;
 
+	static volatile long last_effect_id = 0;
+
 	struct gs_effect *effect = bzalloc(sizeof(struct gs_effect));
 	struct effect_parser parser;
 	bool success;
 
+	effect->id = os_atomic_inc_long(&last_effect_id);
 	effect->graphics = thread_graphics;
 	effect->effect_path = bstrdup(filename);
 
@@ -2423,6 +2426,22 @@ bool gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 	return graphics->exports.gs_stagesurface_map(stagesurf, data, linesize);
 }
 
+bool gs_stagesurface_try_map(gs_stagesurf_t *stagesurf, uint8_t **data,
+		uint32_t *linesize)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid_p3("gs_stagesurface_try_map", stagesurf, data, linesize))
+		return 0;
+
+	/* without a way to query the copy, assume it is still in flight */
+	if (!graphics->exports.gs_stagesurface_try_map)
+		return false;
+
+	return graphics->exports.gs_stagesurface_try_map(stagesurf, data,
+			linesize);
+}
+
 void gs_stagesurface_unmap(gs_stagesurf_t *stagesurf)
 {
 	graphics_t *graphics = thread_graphics;
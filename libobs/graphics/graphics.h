@@ -375,6 +375,20 @@ EXPORT gs_eparam_t *gs_effect_get_param_by_idx(const gs_effect_t *effect,
 EXPORT gs_eparam_t *gs_effect_get_param_by_name(const gs_effect_t *effect,
 		const char *name);
 
+/**
+ * Cached parameter lookup.  The parameter is only looked up by name the
+ * first time the cache is used with a given effect, after which the cached
+ * parameter is returned until the cache is used with a different effect.
+ * Zero-initialize the cache before first use.
+ */
+struct gs_eparam_cache {
+	long        effect_id;
+	gs_eparam_t *param;
+};
+
+EXPORT gs_eparam_t *gs_effect_get_param_cached(const gs_effect_t *effect,
+		const char *name, struct gs_eparam_cache *cache);
+
 /** Helper function to simplify effect usage.  Use with a while loop that
  * contains drawing functions.  Automatically handles techniques, passes, and
  * unloading. */
@@ -462,6 +476,7 @@ struct gs_init_data {
 
 #define GS_DEVICE_OPENGL      1
 #define GS_DEVICE_DIRECT3D_11 2
+#define GS_DEVICE_NULL        3
 
 EXPORT const char *gs_get_device_name(void);
 EXPORT int gs_get_device_type(void);
@@ -719,6 +734,8 @@ EXPORT enum gs_color_format gs_stagesurface_get_color_format(
 		const gs_stagesurf_t *stagesurf);
 EXPORT bool     gs_stagesurface_map(gs_stagesurf_t *stagesurf, uint8_t **data,
 		uint32_t *linesize);
+EXPORT bool     gs_stagesurface_try_map(gs_stagesurf_t *stagesurf,
+		uint8_t **data, uint32_t *linesize);
 EXPORT void     gs_stagesurface_unmap(gs_stagesurf_t *stagesurf);
 
 EXPORT void     gs_zstencil_destroy(gs_zstencil_t *zstencil);
@@ -18,6 +18,7 @@
 #include "image-file.h"
 #include "../util/base.h"
 #include "../util/platform.h"
+#include "../util/threading.h"
 
 #define blog(level, format, ...) \
 	blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -59,7 +60,257 @@ static inline int get_full_decoded_gif_size(gs_image_file_t *image)
 	return image->gif.width * image->gif.height * 4 * image->gif.frame_count;
 }
 
-static bool init_animated_gif(gs_image_file_t *image, const char *path)
+static inline size_t get_gif_frame_size(gs_image_file_t *image)
+{
+	return (size_t)image->gif.width * (size_t)image->gif.height * 4;
+}
+
+/* ------------------------------------------------------------------------- */
+/* streamed gif decoding                                                     */
+
+/*
+ *   Animated gifs that are too large to keep fully decoded in memory are
+ * decoded in order by a worker thread into a small ring of frames, which are
+ * uploaded and released again as the animation reaches them.  If the
+ * animation jumps to a frame that is not about to be decoded (e.g. when it is
+ * reset), decoding restarts at that frame.
+ */
+
+#define GIF_STREAM_FRAMES 4
+
+struct gs_gif_stream {
+	pthread_t thread;
+	bool thread_active;
+	pthread_mutex_t mutex;
+	os_event_t *event;
+	bool stop;
+
+	uint8_t *frames[GIF_STREAM_FRAMES];
+	int frame_ids[GIF_STREAM_FRAMES];
+	size_t read_idx;
+	size_t count;
+
+	int next_frame;
+	int seek_frame;
+	int uploaded_frame;
+	bool pending;
+};
+
+static bool gif_stream_create(gs_image_file_t *image)
+{
+	struct gs_gif_stream *stream = bzalloc(sizeof(*stream));
+	size_t frame_size = get_gif_frame_size(image);
+
+	pthread_mutex_init_value(&stream->mutex);
+	if (pthread_mutex_init(&stream->mutex, NULL) != 0) {
+		bfree(stream);
+		return false;
+	}
+	if (os_event_init(&stream->event, OS_EVENT_TYPE_AUTO) != 0) {
+		pthread_mutex_destroy(&stream->mutex);
+		bfree(stream);
+		return false;
+	}
+
+	for (size_t i = 0; i < GIF_STREAM_FRAMES; i++)
+		stream->frames[i] = bmalloc(frame_size);
+
+	/* frame 0 is decoded on load and used for the initial texture */
+	stream->next_frame = 1 % (int)image->gif.frame_count;
+	stream->seek_frame = -1;
+	stream->uploaded_frame = 0;
+
+	image->gif_stream = stream;
+	return true;
+}
+
+static void gif_stream_destroy(gs_image_file_t *image)
+{
+	struct gs_gif_stream *stream = image->gif_stream;
+
+	if (!stream)
+		return;
+
+	if (stream->thread_active) {
+		pthread_mutex_lock(&stream->mutex);
+		stream->stop = true;
+		pthread_mutex_unlock(&stream->mutex);
+
+		os_event_signal(stream->event);
+		pthread_join(stream->thread, NULL);
+	}
+
+	for (size_t i = 0; i < GIF_STREAM_FRAMES; i++)
+		bfree(stream->frames[i]);
+
+	os_event_destroy(stream->event);
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream);
+
+	image->gif_stream = NULL;
+}
+
+static void gif_stream_decode_frame(gs_image_file_t *image, int frame)
+{
+	int first_frame;
+
+	/* frames are composited on top of each other, so decode any frames
+	 * in between first; if looped, start over from frame 0 */
+	first_frame = (frame <= image->last_decoded_frame) ?
+		0 : image->last_decoded_frame + 1;
+
+	for (int i = first_frame; i < frame; i++)
+		gif_decode_frame(&image->gif, i);
+
+	if (gif_decode_frame(&image->gif, frame) != GIF_OK)
+		blog(LOG_DEBUG, "Couldn't decode frame %d", frame);
+
+	image->last_decoded_frame = frame;
+}
+
+static void *gif_stream_thread(void *data)
+{
+	gs_image_file_t *image = data;
+	struct gs_gif_stream *stream = image->gif_stream;
+	size_t frame_size = get_gif_frame_size(image);
+	int frame_count = (int)image->gif.frame_count;
+
+	os_set_thread_name("gs_image_file: gif decode thread");
+
+	for (;;) {
+		bool stop, full;
+		size_t slot;
+		int frame;
+
+		pthread_mutex_lock(&stream->mutex);
+
+		if (stream->seek_frame >= 0) {
+			stream->next_frame = stream->seek_frame;
+			stream->seek_frame = -1;
+			stream->read_idx = 0;
+			stream->count = 0;
+		}
+
+		stop = stream->stop;
+		full = stream->count == GIF_STREAM_FRAMES;
+		slot = (stream->read_idx + stream->count) % GIF_STREAM_FRAMES;
+		frame = stream->next_frame;
+
+		pthread_mutex_unlock(&stream->mutex);
+
+		if (stop)
+			break;
+		if (full) {
+			os_event_wait(stream->event);
+			continue;
+		}
+
+		/* the slot past the end of the ring is not touched by the
+		 * consumer, so it can be written without holding the lock */
+		gif_stream_decode_frame(image, frame);
+		memcpy(stream->frames[slot], image->gif.frame_image,
+				frame_size);
+
+		pthread_mutex_lock(&stream->mutex);
+		if (stream->seek_frame < 0) {
+			stream->frame_ids[slot] = frame;
+			stream->count++;
+			stream->next_frame = (frame + 1) % frame_count;
+		}
+		pthread_mutex_unlock(&stream->mutex);
+	}
+
+	return NULL;
+}
+
+static void gif_stream_start(gs_image_file_t *image)
+{
+	struct gs_gif_stream *stream = image->gif_stream;
+
+	if (pthread_create(&stream->thread, NULL, gif_stream_thread,
+				image) != 0) {
+		blog(LOG_WARNING, "Failed to create decode thread for "
+				"%ux%u gif", image->gif.width,
+				image->gif.height);
+		return;
+	}
+
+	stream->thread_active = true;
+}
+
+static void gif_stream_update_texture(gs_image_file_t *image)
+{
+	struct gs_gif_stream *stream = image->gif_stream;
+	int frame_count = (int)image->gif.frame_count;
+	int frame = image->cur_frame;
+	bool found = false;
+	bool released = false;
+	size_t last_idx = 0;
+	int distance;
+
+	pthread_mutex_lock(&stream->mutex);
+
+	if (frame == stream->uploaded_frame) {
+		stream->pending = false;
+		goto unlock;
+	}
+
+	/* release frames until the current frame is reached; the texture
+	 * keeps its own copy once uploaded */
+	while (stream->count) {
+		last_idx = stream->read_idx;
+		found = stream->frame_ids[last_idx] == frame;
+
+		stream->read_idx = (last_idx + 1) % GIF_STREAM_FRAMES;
+		stream->count--;
+		released = true;
+
+		if (found)
+			break;
+	}
+
+	/* if the decode thread is behind, show the newest frame it has
+	 * decoded in the meantime */
+	if (released) {
+		gs_texture_set_image(image->texture, stream->frames[last_idx],
+				image->gif.width * 4, false);
+		stream->uploaded_frame = stream->frame_ids[last_idx];
+	}
+
+	stream->pending = !found;
+
+	if (!found) {
+		distance = (frame - stream->next_frame + frame_count) %
+			frame_count;
+		if (distance >= GIF_STREAM_FRAMES) {
+			stream->seek_frame = frame;
+			released = true;
+		}
+	}
+
+unlock:
+	pthread_mutex_unlock(&stream->mutex);
+
+	if (released)
+		os_event_signal(stream->event);
+}
+
+static inline bool gif_stream_pending(gs_image_file_t *image)
+{
+	struct gs_gif_stream *stream = image->gif_stream;
+	bool pending;
+
+	pthread_mutex_lock(&stream->mutex);
+	pending = stream->pending;
+	pthread_mutex_unlock(&stream->mutex);
+
+	return pending;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool init_animated_gif(gs_image_file_t *image, const char *path,
+		uint64_t max_cache_size)
 {
 	bool is_animated_gif = true;
 	gif_result result;
@@ -111,28 +362,48 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path)
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height *
 		(uint64_t)image->gif.frame_count * 4LLU;
 
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
-		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size",
-				path);
-		goto fail;
-	}
-
 	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
 	if (image->is_animated_gif) {
-		gif_decode_frame(&image->gif, 0);
+		bool stream = max_size > max_cache_size ||
+			(uint64_t)get_full_decoded_gif_size(image) != max_size;
 
-		image->animation_frame_cache = bzalloc(
-				image->gif.frame_count * sizeof(uint8_t*));
-		image->animation_frame_data = bzalloc(
-				get_full_decoded_gif_size(image));
+		if (stream) {
+			gif_decode_frame(&image->gif, 0);
 
-		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				blog(LOG_WARNING, "Couldn't decode frame %u "
-						"of '%s'", i, path);
-		}
+			if (!gif_stream_create(image)) {
+				blog(LOG_WARNING, "Failed to create gif "
+						"decode stream for '%s'", path);
+				goto fail;
+			}
+
+		} else {
+			size_t frame_size = get_gif_frame_size(image);
+
+			image->animation_frame_cache = bzalloc(
+					image->gif.frame_count *
+					sizeof(uint8_t*));
+			image->animation_frame_data = bzalloc(
+					get_full_decoded_gif_size(image));
+
+			for (unsigned int i = 0; i < image->gif.frame_count;
+					i++) {
+				uint8_t *data = image->animation_frame_data +
+					i * frame_size;
+
+				if (gif_decode_frame(&image->gif, i) != GIF_OK) {
+					blog(LOG_WARNING, "Couldn't decode "
+							"frame %u of '%s'",
+							i, path);
+					continue;
+				}
+
+				memcpy(data, image->gif.frame_image,
+						frame_size);
+				image->animation_frame_cache[i] = data;
+			}
 
-		gif_decode_frame(&image->gif, 0);
+			gif_decode_frame(&image->gif, 0);
+		}
 
 		image->cx = (uint32_t)image->gif.width;
 		image->cy = (uint32_t)image->gif.height;
@@ -158,6 +429,13 @@ not_animated:
 }
 
 void gs_image_file_init(gs_image_file_t *image, const char *file)
+{
+	gs_image_file_init_ex(image, file,
+			GS_IMAGE_FILE_DEFAULT_GIF_CACHE_SIZE);
+}
+
+void gs_image_file_init_ex(gs_image_file_t *image, const char *file,
+		uint64_t max_gif_cache_size)
 {
 	size_t len;
 
@@ -172,7 +450,7 @@ void gs_image_file_init(gs_image_file_t *image, const char *file)
 	len = strlen(file);
 
 	if (len > 4 && strcmp(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file))
+		if (init_animated_gif(image, file, max_gif_cache_size))
 			return;
 	}
 
@@ -193,6 +471,7 @@ void gs_image_file_free(gs_image_file_t *image)
 
 	if (image->loaded) {
 		if (image->is_animated_gif) {
+			gif_stream_destroy(image);
 			gif_finalise(&image->gif);
 			bfree(image->animation_frame_cache);
 			bfree(image->animation_frame_data);
@@ -217,6 +496,10 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 				(const uint8_t**)&image->gif.frame_image,
 				GS_DYNAMIC);
 
+		/* the decode thread takes over the gif state from here */
+		if (image->gif_stream && image->texture)
+			gif_stream_start(image);
+
 	} else {
 		image->texture = gs_texture_create(
 				image->cx, image->cy, image->format, 1,
@@ -309,12 +592,16 @@ bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 				loops);
 
 		if (new_frame != image->cur_frame) {
-			decode_new_frame(image, new_frame);
+			if (image->gif_stream)
+				image->cur_frame = new_frame;
+			else
+				decode_new_frame(image, new_frame);
 			return true;
 		}
 	}
 
-	return false;
+	/* keep updating until the decode thread has caught up */
+	return image->gif_stream && gif_stream_pending(image);
 }
 
 void gs_image_file_update_texture(gs_image_file_t *image)
@@ -322,6 +609,11 @@ void gs_image_file_update_texture(gs_image_file_t *image)
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (image->gif_stream) {
+		gif_stream_update_texture(image);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame);
 
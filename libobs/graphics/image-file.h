@@ -20,6 +20,12 @@
 #include "graphics.h"
 #include "libnsgif/libnsgif.h"
 
+/* animated gifs larger than this when fully decoded are decoded on the fly
+ * by a worker thread instead of caching every frame */
+#define GS_IMAGE_FILE_DEFAULT_GIF_CACHE_SIZE (256ULL * 1024ULL * 1024ULL)
+
+struct gs_gif_stream;
+
 struct gs_image_file {
 	gs_texture_t *texture;
 	enum gs_color_format format;
@@ -37,6 +43,7 @@ struct gs_image_file {
 	int cur_frame;
 	int cur_loop;
 	int last_decoded_frame;
+	struct gs_gif_stream *gif_stream;
 
 	uint8_t *texture_data;
 	gif_bitmap_callback_vt bitmap_callbacks;
@@ -45,6 +52,8 @@ struct gs_image_file {
 typedef struct gs_image_file gs_image_file_t;
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
+EXPORT void gs_image_file_init_ex(gs_image_file_t *image, const char *file,
+		uint64_t max_gif_cache_size);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
 
 EXPORT void gs_image_file_init_texture(gs_image_file_t *image);
@@ -20,6 +20,12 @@
 #include "../util/c99defs.h"
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MATH_SSE 1
+#endif
+
 #ifdef _MSC_VER
 #include <float.h>
 
@@ -38,6 +44,178 @@ static inline float db_to_mul(const float db)
 	return isfinite((double)db) ? powf(10.0f, db / 20.0f) : 0.0f;
 }
 
+/* out[i] += in[i] * gain */
+static inline void audio_mix_add_gain(float *out, const float *in,
+		float gain, size_t count)
+{
+	size_t i = 0;
+
+#ifdef AUDIO_MATH_SSE
+	__m128 g = _mm_set1_ps(gain);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 o = _mm_loadu_ps(out + i);
+		__m128 v = _mm_loadu_ps(in + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(o, _mm_mul_ps(v, g)));
+	}
+#endif
+
+	for (; i < count; i++)
+		out[i] += in[i] * gain;
+}
+
+/* out[i] += in[i] */
+static inline void audio_mix_add(float *out, const float *in, size_t count)
+{
+	size_t i = 0;
+
+#ifdef AUDIO_MATH_SSE
+	for (; i + 4 <= count; i += 4) {
+		__m128 o = _mm_loadu_ps(out + i);
+		__m128 v = _mm_loadu_ps(in + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(o, v));
+	}
+#endif
+
+	for (; i < count; i++)
+		out[i] += in[i];
+}
+
+/* out[i] += in[i] * vol[i] * gain */
+static inline void audio_mix_add_vol(float *out, const float *in,
+		const float *vol, float gain, size_t count)
+{
+	size_t i = 0;
+
+#ifdef AUDIO_MATH_SSE
+	__m128 g = _mm_set1_ps(gain);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 o = _mm_loadu_ps(out + i);
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(in + i),
+				_mm_loadu_ps(vol + i));
+		_mm_storeu_ps(out + i, _mm_add_ps(o, _mm_mul_ps(v, g)));
+	}
+#endif
+
+	for (; i < count; i++)
+		out[i] += in[i] * vol[i] * gain;
+}
+
+/* out[i] = in[i] * gain */
+static inline void audio_copy_gain(float *out, const float *in, float gain,
+		size_t count)
+{
+	size_t i = 0;
+
+#ifdef AUDIO_MATH_SSE
+	__m128 g = _mm_set1_ps(gain);
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), g));
+#endif
+
+	for (; i < count; i++)
+		out[i] = in[i] * gain;
+}
+
+/* returns the maximum absolute value, adds the sum of squares to sum_sq */
+static inline float audio_peak_sum_sq(const float *data, size_t count,
+		float *sum_sq)
+{
+	float peak = 0.0f;
+	float sq = 0.0f;
+	size_t i = 0;
+
+#ifdef AUDIO_MATH_SSE
+	__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 peak4 = _mm_setzero_ps();
+	__m128 sq4 = _mm_setzero_ps();
+	float tmp[4];
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_loadu_ps(data + i);
+		peak4 = _mm_max_ps(peak4, _mm_and_ps(v, abs_mask));
+		sq4 = _mm_add_ps(sq4, _mm_mul_ps(v, v));
+	}
+
+	_mm_storeu_ps(tmp, peak4);
+	peak = fmaxf(fmaxf(tmp[0], tmp[1]), fmaxf(tmp[2], tmp[3]));
+	_mm_storeu_ps(tmp, sq4);
+	sq = (tmp[0] + tmp[1]) + (tmp[2] + tmp[3]);
+#endif
+
+	for (; i < count; i++) {
+		float v = data[i];
+		peak = fmaxf(peak, fabsf(v));
+		sq += v * v;
+	}
+
+	*sum_sq += sq;
+	return peak;
+}
+
+/*
+ * Estimates the inter-sample peak by interpolating (Catmull-Rom) three points
+ * between each pair of samples, i.e. 4x oversampling.  Only the intervals
+ * between data[1] and data[count - 2] are evaluated, as each interpolation
+ * needs one sample on either side; callers handle the edges by carrying the
+ * last three samples over to the next call.
+ */
+static inline float audio_true_peak(const float *data, size_t count)
+{
+	static const float w[3][4] = {
+		{-0.0703125f, 0.8671875f, 0.2265625f, -0.0234375f},
+		{-0.0625f,    0.5625f,    0.5625f,    -0.0625f},
+		{-0.0234375f, 0.2265625f, 0.8671875f, -0.0703125f},
+	};
+	float peak = 0.0f;
+	size_t i = 0;
+	size_t n;
+
+	if (count < 4)
+		return 0.0f;
+
+	/* number of intervals evaluated */
+	n = count - 3;
+
+#ifdef AUDIO_MATH_SSE
+	__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 peak4 = _mm_setzero_ps();
+	float tmp[4];
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 x0 = _mm_loadu_ps(data + i);
+		__m128 x1 = _mm_loadu_ps(data + i + 1);
+		__m128 x2 = _mm_loadu_ps(data + i + 2);
+		__m128 x3 = _mm_loadu_ps(data + i + 3);
+
+		for (size_t j = 0; j < 3; j++) {
+			__m128 y = _mm_mul_ps(x0, _mm_set1_ps(w[j][0]));
+			y = _mm_add_ps(y, _mm_mul_ps(x1, _mm_set1_ps(w[j][1])));
+			y = _mm_add_ps(y, _mm_mul_ps(x2, _mm_set1_ps(w[j][2])));
+			y = _mm_add_ps(y, _mm_mul_ps(x3, _mm_set1_ps(w[j][3])));
+			peak4 = _mm_max_ps(peak4, _mm_and_ps(y, abs_mask));
+		}
+	}
+
+	_mm_storeu_ps(tmp, peak4);
+	peak = fmaxf(fmaxf(tmp[0], tmp[1]), fmaxf(tmp[2], tmp[3]));
+#endif
+
+	for (; i < n; i++) {
+		const float *x = data + i;
+
+		for (size_t j = 0; j < 3; j++) {
+			float y = x[0] * w[j][0] + x[1] * w[j][1] +
+				x[2] * w[j][2] + x[3] * w[j][3];
+			peak = fmaxf(peak, fabsf(y));
+		}
+	}
+
+	return peak;
+}
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
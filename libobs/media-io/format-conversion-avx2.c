@@ -0,0 +1,468 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * AVX2 versions of the format conversion functions.  This file is compiled
+ * with AVX2 code generation enabled, so nothing in it may be called unless
+ * the CPU has been checked for AVX2 support first (see format-conversion.c).
+ *
+ * The output of every function here must be identical to the SSE2/scalar
+ * versions, including for the trailing pixels of a line, which are handled
+ * with scalar code that works on the same pixel groups as the SSE2 code.
+ */
+
+#include "format-conversion.h"
+#include <immintrin.h>
+
+static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
+{
+	return a < b ? a : b;
+}
+
+/* builds a byte shuffle that takes byte 'b' of each of the eight packed
+ * pixels and moves them to bytes 0-3 of the low lane and 4-7 of the high
+ * lane, so that OR'ing both lanes together produces all eight in order */
+#define GATHER_MASK(b) _mm256_setr_epi8( \
+		b, b+4, b+8, b+12, -1, -1, -1, -1, \
+		-1, -1, -1, -1, -1, -1, -1, -1, \
+		-1, -1, -1, -1, b, b+4, b+8, b+12, \
+		-1, -1, -1, -1, -1, -1, -1, -1)
+
+static FORCE_INLINE __m128i gather_bytes(__m256i val, __m256i mask)
+{
+	val = _mm256_shuffle_epi8(val, mask);
+	return _mm_or_si128(_mm256_castsi256_si128(val),
+			_mm256_extracti128_si256(val, 1));
+}
+
+/* averages each 2x2 block of u/v values.  each resulting 64bit value holds
+ * the averaged u and v of one block as its first two 16bit values */
+static FORCE_INLINE __m256i average_chroma(__m256i line1, __m256i line2,
+		__m256i uv_mask)
+{
+	__m256i add_val = _mm256_add_epi16(
+			_mm256_and_si256(line1, uv_mask),
+			_mm256_and_si256(line2, uv_mask));
+	add_val = _mm256_add_epi16(add_val,
+			_mm256_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm256_srli_epi16(add_val, 2);
+}
+
+/* scalar version of a single four pixel group, matching the SSE2 code */
+static FORCE_INLINE void compress_group_c(const uint8_t *img,
+		uint32_t in_linesize, uint8_t *lum0, uint8_t *lum1,
+		uint8_t *u, uint8_t *v, uint32_t uv_step)
+{
+	const uint8_t *img2 = img + in_linesize;
+
+	for (uint32_t i = 0; i < 4; i++) {
+		lum0[i] = img[i * 4 + 1];
+		lum1[i] = img2[i * 4 + 1];
+	}
+
+	for (uint32_t i = 0; i < 2; i++) {
+		const uint8_t *p1 = img  + i * 8;
+		const uint8_t *p2 = img2 + i * 8;
+
+		u[i * uv_step] = (uint8_t)((p1[0] + p1[4] + p2[0] + p2[4]) >> 2);
+		v[i * uv_step] = (uint8_t)((p1[2] + p1[6] + p2[2] + p2[6]) >> 2);
+	}
+}
+
+void compress_uyvx_to_i420_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint8_t  *lum_plane   = output[0];
+	uint8_t  *u_plane     = output[1];
+	uint8_t  *v_plane     = output[2];
+	uint32_t width        = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m256i lum_shuf = GATHER_MASK(1);
+	__m256i uv_mask  = _mm256_set1_epi16(0x00FF);
+	__m256i uv_shuf  = _mm256_setr_epi8(
+			0, 8, -1, -1, 2, 10, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, 0, 8, -1, -1, 2, 10,
+			-1, -1, -1, -1, -1, -1, -1, -1);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos        = y      * in_linesize;
+		uint32_t chroma_y_pos = (y>>1) * out_linesize[1];
+		uint32_t lum_y_pos    = y      * out_linesize[0];
+		uint32_t x;
+
+		for (x = 0; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x*4;
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint32_t lum_pos1  = lum_pos0 + out_linesize[0];
+			uint32_t chroma_pos = chroma_y_pos + (x>>1);
+
+			__m256i line1 = _mm256_loadu_si256((const __m256i*)img);
+			__m256i line2 = _mm256_loadu_si256(
+					(const __m256i*)(img + in_linesize));
+			__m128i uv;
+
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos0),
+					gather_bytes(line1, lum_shuf));
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos1),
+					gather_bytes(line2, lum_shuf));
+
+			uv = gather_bytes(average_chroma(line1, line2, uv_mask),
+					uv_shuf);
+			*(uint32_t*)(u_plane + chroma_pos) =
+				(uint32_t)_mm_cvtsi128_si32(uv);
+			*(uint32_t*)(v_plane + chroma_pos) =
+				(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(uv, 4));
+		}
+
+		for (; x < width; x += 4) {
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint32_t chroma_pos = chroma_y_pos + (x>>1);
+
+			compress_group_c(input + y_pos + x*4, in_linesize,
+					lum_plane + lum_pos0,
+					lum_plane + lum_pos0 + out_linesize[0],
+					u_plane + chroma_pos,
+					v_plane + chroma_pos, 1);
+		}
+	}
+}
+
+void compress_uyvx_to_nv12_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane    = output[0];
+	uint8_t *chroma_plane = output[1];
+	uint32_t width        = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m256i lum_shuf = GATHER_MASK(1);
+	__m256i uv_mask  = _mm256_set1_epi16(0x00FF);
+	__m256i uv_shuf  = _mm256_setr_epi8(
+			0, 2, 8, 10, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, 0, 2, 8, 10,
+			-1, -1, -1, -1, -1, -1, -1, -1);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos        = y      * in_linesize;
+		uint32_t chroma_y_pos = (y>>1) * out_linesize[1];
+		uint32_t lum_y_pos    = y      * out_linesize[0];
+		uint32_t x;
+
+		for (x = 0; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x*4;
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint32_t lum_pos1  = lum_pos0 + out_linesize[0];
+
+			__m256i line1 = _mm256_loadu_si256((const __m256i*)img);
+			__m256i line2 = _mm256_loadu_si256(
+					(const __m256i*)(img + in_linesize));
+
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos0),
+					gather_bytes(line1, lum_shuf));
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos1),
+					gather_bytes(line2, lum_shuf));
+			_mm_storel_epi64(
+					(__m128i*)(chroma_plane + chroma_y_pos + x),
+					gather_bytes(average_chroma(
+							line1, line2, uv_mask),
+						uv_shuf));
+		}
+
+		for (; x < width; x += 4) {
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint8_t *chroma    = chroma_plane + chroma_y_pos + x;
+
+			compress_group_c(input + y_pos + x*4, in_linesize,
+					lum_plane + lum_pos0,
+					lum_plane + lum_pos0 + out_linesize[0],
+					chroma, chroma + 1, 2);
+		}
+	}
+}
+
+void convert_uyvx_to_i444_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint8_t  *lum_plane   = output[0];
+	uint8_t  *u_plane     = output[1];
+	uint8_t  *v_plane     = output[2];
+	uint32_t width        = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m256i lum_shuf = GATHER_MASK(1);
+	__m256i u_shuf   = GATHER_MASK(0);
+	__m256i v_shuf   = GATHER_MASK(2);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos        = y      * in_linesize;
+		uint32_t lum_y_pos    = y      * out_linesize[0];
+		uint32_t x;
+
+		for (x = 0; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x*4;
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint32_t lum_pos1  = lum_pos0 + out_linesize[0];
+
+			__m256i line1 = _mm256_loadu_si256((const __m256i*)img);
+			__m256i line2 = _mm256_loadu_si256(
+					(const __m256i*)(img + in_linesize));
+
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos0),
+					gather_bytes(line1, lum_shuf));
+			_mm_storel_epi64((__m128i*)(lum_plane + lum_pos1),
+					gather_bytes(line2, lum_shuf));
+			_mm_storel_epi64((__m128i*)(u_plane + lum_pos0),
+					gather_bytes(line1, u_shuf));
+			_mm_storel_epi64((__m128i*)(u_plane + lum_pos1),
+					gather_bytes(line2, u_shuf));
+			_mm_storel_epi64((__m128i*)(v_plane + lum_pos0),
+					gather_bytes(line1, v_shuf));
+			_mm_storel_epi64((__m128i*)(v_plane + lum_pos1),
+					gather_bytes(line2, v_shuf));
+		}
+
+		for (; x < width; x++) {
+			const uint8_t *img1 = input + y_pos + x*4;
+			const uint8_t *img2 = img1 + in_linesize;
+			uint32_t lum_pos0  = lum_y_pos + x;
+			uint32_t lum_pos1  = lum_pos0 + out_linesize[0];
+
+			lum_plane[lum_pos0] = img1[1];
+			lum_plane[lum_pos1] = img2[1];
+			u_plane[lum_pos0]   = img1[0];
+			u_plane[lum_pos1]   = img2[0];
+			v_plane[lum_pos0]   = img1[2];
+			v_plane[lum_pos1]   = img2[2];
+		}
+	}
+}
+
+void decompress_420_avx2(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y/2;
+	uint32_t width_d2   = in_linesize[0]/2;
+	uint32_t height_d2  = end_y/2;
+	uint32_t y;
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
+		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
+		const uint8_t *lum0, *lum1;
+		uint32_t *output0, *output1;
+		uint32_t x;
+
+		lum0 = input[0] + y * 2 * in_linesize[0];
+		lum1 = lum0 + in_linesize[0];
+		output0 = (uint32_t*)(output + y * 2 * out_linesize);
+		output1 = (uint32_t*)((uint8_t*)output0 + out_linesize);
+
+		/* 8 chroma samples (16 pixels) per iteration */
+		for (x = 0; x + 8 <= width_d2; x += 8) {
+			__m128i u  = _mm_loadl_epi64((const __m128i*)chroma0);
+			__m128i v  = _mm_loadl_epi64((const __m128i*)chroma1);
+			__m128i uv = _mm_unpacklo_epi8(v, u);
+			__m256i uv_lo = _mm256_cvtepu16_epi32(
+					_mm_unpacklo_epi16(uv, uv));
+			__m256i uv_hi = _mm256_cvtepu16_epi32(
+					_mm_unpackhi_epi16(uv, uv));
+			__m128i l0 = _mm_loadu_si128((const __m128i*)lum0);
+			__m128i l1 = _mm_loadu_si128((const __m128i*)lum1);
+
+			_mm256_storeu_si256((__m256i*)output0, _mm256_or_si256(
+					_mm256_slli_epi32(
+						_mm256_cvtepu8_epi32(l0), 16),
+					uv_lo));
+			_mm256_storeu_si256((__m256i*)(output0 + 8),
+					_mm256_or_si256(_mm256_slli_epi32(
+						_mm256_cvtepu8_epi32(
+							_mm_srli_si128(l0, 8)),
+						16), uv_hi));
+			_mm256_storeu_si256((__m256i*)output1, _mm256_or_si256(
+					_mm256_slli_epi32(
+						_mm256_cvtepu8_epi32(l1), 16),
+					uv_lo));
+			_mm256_storeu_si256((__m256i*)(output1 + 8),
+					_mm256_or_si256(_mm256_slli_epi32(
+						_mm256_cvtepu8_epi32(
+							_mm_srli_si128(l1, 8)),
+						16), uv_hi));
+
+			chroma0 += 8;
+			chroma1 += 8;
+			lum0    += 16;
+			lum1    += 16;
+			output0 += 16;
+			output1 += 16;
+		}
+
+		for (; x < width_d2; x++) {
+			uint32_t out;
+			out = (*(chroma0++) << 8) | *(chroma1++);
+
+			*(output0++) = (*(lum0++) << 16) | out;
+			*(output0++) = (*(lum0++) << 16) | out;
+
+			*(output1++) = (*(lum1++) << 16) | out;
+			*(output1++) = (*(lum1++) << 16) | out;
+		}
+	}
+}
+
+void decompress_nv12_avx2(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize)
+{
+	uint32_t start_y_d2 = start_y/2;
+	uint32_t width_d2   = min_uint32(in_linesize[0], out_linesize)/2;
+	uint32_t height_d2  = end_y/2;
+	uint32_t y;
+
+	for (y = start_y_d2; y < height_d2; y++) {
+		const uint16_t *chroma;
+		const uint8_t *lum0, *lum1;
+		uint32_t *output0, *output1;
+		uint32_t x;
+
+		chroma = (const uint16_t*)(input[1] + y * in_linesize[1]);
+		lum0 = input[0] + y * 2 * in_linesize[0];
+		lum1 = lum0 + in_linesize[0];
+		output0 = (uint32_t*)(output + y * 2 * out_linesize);
+		output1 = (uint32_t*)((uint8_t*)output0 + out_linesize);
+
+		/* 8 chroma samples (16 pixels) per iteration */
+		for (x = 0; x + 8 <= width_d2; x += 8) {
+			__m128i uv = _mm_loadu_si128((const __m128i*)chroma);
+			__m256i uv_lo = _mm256_slli_epi32(_mm256_cvtepu16_epi32(
+					_mm_unpacklo_epi16(uv, uv)), 8);
+			__m256i uv_hi = _mm256_slli_epi32(_mm256_cvtepu16_epi32(
+					_mm_unpackhi_epi16(uv, uv)), 8);
+			__m128i l0 = _mm_loadu_si128((const __m128i*)lum0);
+			__m128i l1 = _mm_loadu_si128((const __m128i*)lum1);
+
+			_mm256_storeu_si256((__m256i*)output0, _mm256_or_si256(
+					_mm256_cvtepu8_epi32(l0), uv_lo));
+			_mm256_storeu_si256((__m256i*)(output0 + 8),
+					_mm256_or_si256(_mm256_cvtepu8_epi32(
+						_mm_srli_si128(l0, 8)), uv_hi));
+			_mm256_storeu_si256((__m256i*)output1, _mm256_or_si256(
+					_mm256_cvtepu8_epi32(l1), uv_lo));
+			_mm256_storeu_si256((__m256i*)(output1 + 8),
+					_mm256_or_si256(_mm256_cvtepu8_epi32(
+						_mm_srli_si128(l1, 8)), uv_hi));
+
+			chroma  += 8;
+			lum0    += 16;
+			lum1    += 16;
+			output0 += 16;
+			output1 += 16;
+		}
+
+		for (; x < width_d2; x++) {
+			uint32_t out = *(chroma++) << 8;
+
+			*(output0++) = *(lum0++) | out;
+			*(output0++) = *(lum0++) | out;
+
+			*(output1++) = *(lum1++) | out;
+			*(output1++) = *(lum1++) | out;
+		}
+	}
+}
+
+static FORCE_INLINE void decompress_422_line(const uint32_t *input32,
+		uint32_t width_d2, uint32_t *output32, __m256i shuf,
+		bool leading_lum)
+{
+	const uint32_t *input32_end = input32 + width_d2;
+
+	/* 8 input values (16 pixels) per iteration.  each input value is
+	 * written as is, followed by a copy with the first luma value
+	 * replaced with the second */
+	while (input32 + 8 <= input32_end) {
+		__m256i in  = _mm256_loadu_si256((const __m256i*)input32);
+		__m256i dup = _mm256_shuffle_epi8(in, shuf);
+		__m256i lo  = _mm256_unpacklo_epi32(in, dup);
+		__m256i hi  = _mm256_unpackhi_epi32(in, dup);
+
+		_mm256_storeu_si256((__m256i*)output32,
+				_mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i*)(output32 + 8),
+				_mm256_permute2x128_si256(lo, hi, 0x31));
+
+		input32  += 8;
+		output32 += 16;
+	}
+
+	while (input32 < input32_end) {
+		uint32_t dw = *input32;
+
+		output32[0] = dw;
+		if (leading_lum) {
+			dw &= 0xFFFFFF00;
+			dw |= (uint8_t)(dw>>16);
+		} else {
+			dw &= 0xFFFF00FF;
+			dw |= (dw>>16) & 0xFF00;
+		}
+		output32[1] = dw;
+
+		output32 += 2;
+		input32++;
+	}
+}
+
+void decompress_422_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize,
+		bool leading_lum)
+{
+	uint32_t width_d2 = min_uint32(in_linesize, out_linesize)/2;
+	uint32_t y;
+
+	/* YUYV: Y0 U Y1 V -> Y1 U Y1 V, UYVY: U Y0 V Y1 -> U Y1 V Y1 */
+	__m256i shuf = leading_lum ?
+		_mm256_setr_epi8(
+				2, 1, 2, 3, 6, 5, 6, 7,
+				10, 9, 10, 11, 14, 13, 14, 15,
+				2, 1, 2, 3, 6, 5, 6, 7,
+				10, 9, 10, 11, 14, 13, 14, 15) :
+		_mm256_setr_epi8(
+				0, 3, 2, 3, 4, 7, 6, 7,
+				8, 11, 10, 11, 12, 15, 14, 15,
+				0, 3, 2, 3, 4, 7, 6, 7,
+				8, 11, 10, 11, 12, 15, 14, 15);
+
+	for (y = start_y; y < end_y; y++) {
+		decompress_422_line((const uint32_t*)(input + y*in_linesize),
+				width_d2, (uint32_t*)(output + y*out_linesize),
+				shuf, leading_lum);
+	}
+}
@@ -16,9 +16,14 @@
 ******************************************************************************/
 
 #include "format-conversion.h"
+#include "../util/threading.h"
 #include <xmmintrin.h>
 #include <emmintrin.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
 
@@ -89,7 +94,7 @@ static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
 	return a < b ? a : b;
 }
 
-void compress_uyvx_to_i420(
+static void compress_uyvx_to_i420_sse2(
 		const uint8_t *input, uint32_t in_linesize,
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output[], const uint32_t out_linesize[])
@@ -127,7 +132,7 @@ void compress_uyvx_to_i420(
 	}
 }
 
-void compress_uyvx_to_nv12(
+static void compress_uyvx_to_nv12_sse2(
 		const uint8_t *input, uint32_t in_linesize,
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output[], const uint32_t out_linesize[])
@@ -163,7 +168,7 @@ void compress_uyvx_to_nv12(
 	}
 }
 
-void convert_uyvx_to_i444(
+static void convert_uyvx_to_i444_sse2(
 		const uint8_t *input, uint32_t in_linesize,
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output[], const uint32_t out_linesize[])
@@ -202,7 +207,7 @@ void convert_uyvx_to_i444(
 	}
 }
 
-void decompress_420(
+static void decompress_420_c(
 		const uint8_t *const input[], const uint32_t in_linesize[],
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output, uint32_t out_linesize)
@@ -237,7 +242,7 @@ void decompress_420(
 	}
 }
 
-void decompress_nv12(
+static void decompress_nv12_c(
 		const uint8_t *const input[], const uint32_t in_linesize[],
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output, uint32_t out_linesize)
@@ -271,7 +276,7 @@ void decompress_nv12(
 	}
 }
 
-void decompress_422(
+static void decompress_422_c(
 		const uint8_t *input, uint32_t in_linesize,
 		uint32_t start_y, uint32_t end_y,
 		uint8_t *output, uint32_t out_linesize,
@@ -322,3 +327,166 @@ void decompress_422(
 		}
 	}
 }
+
+/* ------------------------------------------------------------------------- */
+/* runtime dispatch                                                          */
+
+/* implemented in format-conversion-avx2.c */
+extern void compress_uyvx_to_i420_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[]);
+extern void compress_uyvx_to_nv12_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[]);
+extern void convert_uyvx_to_i444_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[]);
+extern void decompress_420_avx2(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize);
+extern void decompress_nv12_avx2(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize);
+extern void decompress_422_avx2(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize,
+		bool leading_lum);
+
+typedef void (*compress_func_t)(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[]);
+typedef void (*decompress_planar_func_t)(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize);
+typedef void (*decompress_packed_func_t)(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize,
+		bool leading_lum);
+
+static struct {
+	compress_func_t          uyvx_to_i420;
+	compress_func_t          uyvx_to_nv12;
+	compress_func_t          uyvx_to_i444;
+	decompress_planar_func_t decompress_420;
+	decompress_planar_func_t decompress_nv12;
+	decompress_packed_func_t decompress_422;
+} conv_funcs;
+
+static pthread_once_t conv_funcs_init_token = PTHREAD_ONCE_INIT;
+
+static bool cpu_has_avx2(void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	/* the OS must also save the upper halves of the ymm registers */
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+static void init_conv_funcs(void)
+{
+	if (cpu_has_avx2()) {
+		conv_funcs.uyvx_to_i420    = compress_uyvx_to_i420_avx2;
+		conv_funcs.uyvx_to_nv12    = compress_uyvx_to_nv12_avx2;
+		conv_funcs.uyvx_to_i444    = convert_uyvx_to_i444_avx2;
+		conv_funcs.decompress_420  = decompress_420_avx2;
+		conv_funcs.decompress_nv12 = decompress_nv12_avx2;
+		conv_funcs.decompress_422  = decompress_422_avx2;
+	} else {
+		conv_funcs.uyvx_to_i420    = compress_uyvx_to_i420_sse2;
+		conv_funcs.uyvx_to_nv12    = compress_uyvx_to_nv12_sse2;
+		conv_funcs.uyvx_to_i444    = convert_uyvx_to_i444_sse2;
+		conv_funcs.decompress_420  = decompress_420_c;
+		conv_funcs.decompress_nv12 = decompress_nv12_c;
+		conv_funcs.decompress_422  = decompress_422_c;
+	}
+}
+
+#define init_funcs() pthread_once(&conv_funcs_init_token, init_conv_funcs)
+
+void compress_uyvx_to_i420(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	init_funcs();
+	conv_funcs.uyvx_to_i420(input, in_linesize, start_y, end_y,
+			output, out_linesize);
+}
+
+void compress_uyvx_to_nv12(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	init_funcs();
+	conv_funcs.uyvx_to_nv12(input, in_linesize, start_y, end_y,
+			output, out_linesize);
+}
+
+void convert_uyvx_to_i444(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output[], const uint32_t out_linesize[])
+{
+	init_funcs();
+	conv_funcs.uyvx_to_i444(input, in_linesize, start_y, end_y,
+			output, out_linesize);
+}
+
+void decompress_420(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize)
+{
+	init_funcs();
+	conv_funcs.decompress_420(input, in_linesize, start_y, end_y,
+			output, out_linesize);
+}
+
+void decompress_nv12(
+		const uint8_t *const input[], const uint32_t in_linesize[],
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize)
+{
+	init_funcs();
+	conv_funcs.decompress_nv12(input, in_linesize, start_y, end_y,
+			output, out_linesize);
+}
+
+void decompress_422(
+		const uint8_t *input, uint32_t in_linesize,
+		uint32_t start_y, uint32_t end_y,
+		uint8_t *output, uint32_t out_linesize,
+		bool leading_lum)
+{
+	init_funcs();
+	conv_funcs.decompress_422(input, in_linesize, start_y, end_y,
+			output, out_linesize, leading_lum);
+}
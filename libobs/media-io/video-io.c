@@ -22,6 +22,8 @@
 #include "../util/profiler.h"
 #include "../util/threading.h"
 #include "../util/darray.h"
+#include "../util/circlebuf.h"
+#include "../util/task-pool.h"
 
 #include "format-conversion.h"
 #include "video-io.h"
@@ -31,30 +33,61 @@
 extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 #define MAX_CONVERT_BUFFERS 3
-#define MAX_CACHE_SIZE 16
+#define MAX_CACHE_SIZE 128
+#define DEFAULT_CACHE_MEMORY_LIMIT (256ULL * 1024ULL * 1024ULL)
+#define CACHE_SHRINK_DELAY_NS 2000000000ULL
+#define MAX_SCALE_THREADS 4
+#define MAX_INPUT_QUEUE 2
+
+/* frame data of a cache entry.  threaded inputs hold references to the
+ * buffer while the frame is queued for them, so that the cache entry itself
+ * can be reused straight away with a different buffer */
+struct frame_buffer {
+	struct video_frame frame;
+	int refs;
+};
 
 struct cached_frame_info {
 	struct video_data frame;
+	struct frame_buffer *buffer;
 	int skipped;
 	int count;
 };
 
+struct queued_frame {
+	struct frame_buffer       *buffer;
+	struct video_data         frame;
+	int                       count;
+};
+
 struct video_input {
 	struct video_scale_info   conversion;
 	video_scaler_t            *scaler;
 	struct video_frame        frame[MAX_CONVERT_BUFFERS];
 	int                       cur_frame;
 
+	struct video_data         scaled_frame;
+	bool                      scaled;
+
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
-};
 
-static inline void video_input_free(struct video_input *input)
-{
-	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-		video_frame_free(&input->frame[i]);
-	video_scaler_destroy(input->scaler);
-}
+	/* threaded inputs receive frames on their own thread through a small
+	 * queue of cached frames.  the queue is protected by the video
+	 * output's data mutex */
+	struct video_output       *video;
+	bool                      threaded;
+	bool                      thread_initialized;
+	bool                      detached;
+	volatile bool             stop;
+	pthread_t                 thread;
+	os_sem_t                  *queue_semaphore;
+	struct circlebuf          queue;
+
+	uint32_t                  total_frames;
+	uint32_t                  lagged_frames;
+	uint32_t                  dropped_frames;
+};
 
 struct video_output {
 	struct video_output_info   info;
@@ -71,16 +104,179 @@ struct video_output {
 	bool                       initialized;
 
 	pthread_mutex_t            input_mutex;
-	DARRAY(struct video_input) inputs;
-
+	DARRAY(struct video_input*) inputs;
+	os_task_pool_t             *scale_pool;
+
+	/* the cache ring can hold up to cache_limit frames, but frame buffers
+	 * are only allocated when a frame is actually added to the cache.
+	 * buffers beyond info.cache_size are freed again once the video
+	 * thread has caught up */
+	size_t                     cache_limit;
 	size_t                     available_frames;
 	size_t                     first_added;
 	size_t                     last_added;
+	DARRAY(struct frame_buffer*) free_buffers;
+	size_t                     num_buffers;
+	uint64_t                   last_grow_time;
+	volatile long              detached_inputs;
 	struct cached_frame_info   cache[MAX_CACHE_SIZE];
+
+	size_t                     high_water;
+	uint32_t                   stalls;
+	uint64_t                   stall_start;
+	uint64_t                   last_stall_ns;
+	uint64_t                   max_stall_ns;
 };
 
 /* ------------------------------------------------------------------------- */
 
+static const char *cache_grow_name = "video_cache_grow";
+
+/* buffer functions must be called with data_mutex locked */
+static struct frame_buffer *get_frame_buffer(struct video_output *video)
+{
+	struct frame_buffer *buffer;
+
+	if (video->free_buffers.num) {
+		buffer = video->free_buffers.array[video->free_buffers.num - 1];
+		da_pop_back(video->free_buffers);
+	} else {
+		profile_start(cache_grow_name);
+		buffer = bzalloc(sizeof(*buffer));
+		video_frame_init(&buffer->frame, video->info.format,
+				video->info.width, video->info.height);
+		profile_end(cache_grow_name);
+
+		video->num_buffers++;
+		video->last_grow_time = os_gettime_ns();
+	}
+
+	buffer->refs = 1;
+	return buffer;
+}
+
+static inline void release_frame_buffer(struct video_output *video,
+		struct frame_buffer *buffer)
+{
+	if (--buffer->refs == 0)
+		da_push_back(video->free_buffers, &buffer);
+}
+
+static inline void free_frame_buffer(struct frame_buffer *buffer)
+{
+	video_frame_free(&buffer->frame);
+	bfree(buffer);
+}
+
+static void set_cache_buffer(struct cached_frame_info *cfi,
+		struct frame_buffer *buffer)
+{
+	cfi->buffer = buffer;
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		cfi->frame.data[i]     = buffer->frame.data[i];
+		cfi->frame.linesize[i] = buffer->frame.linesize[i];
+	}
+}
+
+/* threaded inputs may still be using the frame, so the cache entry only
+ * drops its own reference and gets a new buffer the next time it's used */
+static inline void release_cache_buffer(struct video_output *video,
+		struct cached_frame_info *cfi)
+{
+	release_frame_buffer(video, cfi->buffer);
+	cfi->buffer = NULL;
+}
+
+static inline size_t cache_depth(const struct video_output *video)
+{
+	return video->cache_limit - video->available_frames;
+}
+
+/* a stall is any period where more frames are waiting than the configured
+ * cache size, which is where frames used to be skipped before the cache
+ * could grow.  must be called with data_mutex locked */
+static void update_cache_stall(struct video_output *video)
+{
+	size_t depth = cache_depth(video);
+
+	if (depth > video->high_water)
+		video->high_water = depth;
+
+	if (depth > video->info.cache_size) {
+		if (!video->stall_start) {
+			video->stall_start = os_gettime_ns();
+			video->stalls++;
+		}
+
+	} else if (video->stall_start) {
+		uint64_t duration = os_gettime_ns() - video->stall_start;
+
+		video->last_stall_ns = duration;
+		if (duration > video->max_stall_ns)
+			video->max_stall_ns = duration;
+		video->stall_start = 0;
+	}
+}
+
+/* frees one spare buffer per completed frame once the cache hasn't needed
+ * to grow for a while.  must be called with data_mutex locked */
+static inline void shrink_cache(struct video_output *video)
+{
+	struct frame_buffer *buffer;
+
+	if (video->stall_start ||
+	    video->num_buffers <= video->info.cache_size ||
+	    !video->free_buffers.num)
+		return;
+	if (os_gettime_ns() - video->last_grow_time < CACHE_SHRINK_DELAY_NS)
+		return;
+
+	buffer = video->free_buffers.array[0];
+	da_erase(video->free_buffers, 0);
+	free_frame_buffer(buffer);
+	video->num_buffers--;
+}
+
+static inline struct queued_frame *queue_front(struct video_input *input)
+{
+	return circlebuf_data(&input->queue, 0);
+}
+
+static inline struct queued_frame *queue_back(struct video_input *input)
+{
+	return circlebuf_data(&input->queue,
+			input->queue.size - sizeof(struct queued_frame));
+}
+
+static inline size_t queue_num_frames(const struct video_input *input)
+{
+	return input->queue.size / sizeof(struct queued_frame);
+}
+
+/* must be called with data_mutex locked */
+static void clear_input_queue(struct video_input *input)
+{
+	struct video_output *video = input->video;
+
+	while (input->queue.size) {
+		struct queued_frame qf;
+		circlebuf_pop_front(&input->queue, &qf, sizeof(qf));
+		release_frame_buffer(video, qf.buffer);
+	}
+}
+
+static inline void video_input_free(struct video_input *input)
+{
+	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+		video_frame_free(&input->frame[i]);
+	video_scaler_destroy(input->scaler);
+
+	circlebuf_free(&input->queue);
+	os_sem_destroy(input->queue_semaphore);
+	bfree(input);
+}
+
 static inline bool scale_video_output(struct video_input *input,
 		struct video_data *data)
 {
@@ -112,6 +308,118 @@ static inline bool scale_video_output(struct video_input *input,
 	return success;
 }
 
+struct scale_job {
+	struct video_output       *video;
+	const struct video_data   *frame;
+};
+
+static void scale_input_task(void *param, size_t idx)
+{
+	struct scale_job *job = param;
+	struct video_input *input = job->video->inputs.array[idx];
+
+	if (input->threaded)
+		return;
+
+	input->scaled_frame = *job->frame;
+	input->scaled = scale_video_output(input, &input->scaled_frame);
+}
+
+static inline void scale_inputs(struct video_output *video,
+		const struct video_data *frame)
+{
+	size_t num_scaled = 0;
+
+	for (size_t i = 0; i < video->inputs.num; i++) {
+		struct video_input *input = video->inputs.array[i];
+
+		if (input->scaler && !input->threaded)
+			num_scaled++;
+	}
+
+	struct scale_job job = {video, frame};
+
+	/* only worth waking the pool if more than one input needs scaling */
+	os_task_pool_run(num_scaled > 1 ? video->scale_pool : NULL,
+			scale_input_task, &job, video->inputs.num);
+}
+
+/* hands the current frame to a threaded input.  if the input is still busy
+ * with earlier frames, the frame is counted as lagged, and if its queue is
+ * full, the last queued frame is repeated instead, the same way frames are
+ * repeated when the cache is full.  must be called with data_mutex locked */
+static void queue_input_frame(struct video_input *input,
+		struct cached_frame_info *cfi)
+{
+	size_t num_queued = queue_num_frames(input);
+
+	if (num_queued)
+		input->lagged_frames++;
+
+	if (num_queued >= MAX_INPUT_QUEUE) {
+		queue_back(input)->count++;
+		input->dropped_frames++;
+	} else {
+		struct queued_frame qf = {cfi->buffer, cfi->frame, 1};
+
+		circlebuf_push_back(&input->queue, &qf, sizeof(qf));
+		cfi->buffer->refs++;
+	}
+
+	input->total_frames++;
+	os_sem_post(input->queue_semaphore);
+}
+
+static void *video_input_thread(void *param)
+{
+	struct video_input *input = param;
+	struct video_output *video = input->video;
+
+	os_set_thread_name("video-io: input thread");
+
+	while (os_sem_wait(input->queue_semaphore) == 0) {
+		struct video_data frame;
+		struct queued_frame *qf;
+
+		if (input->stop)
+			break;
+
+		pthread_mutex_lock(&video->data_mutex);
+		qf = input->queue.size ? queue_front(input) : NULL;
+		if (qf)
+			frame = qf->frame;
+		pthread_mutex_unlock(&video->data_mutex);
+
+		if (!qf)
+			continue;
+
+		if (scale_video_output(input, &frame))
+			input->callback(input->param, &frame);
+
+		pthread_mutex_lock(&video->data_mutex);
+		qf = queue_front(input);
+		qf->frame.timestamp += video->frame_time;
+
+		if (--qf->count == 0) {
+			release_frame_buffer(video, qf->buffer);
+			circlebuf_pop_front(&input->queue, NULL, sizeof(*qf));
+		}
+		pthread_mutex_unlock(&video->data_mutex);
+	}
+
+	/* disconnected from within its own callback */
+	if (input->detached) {
+		pthread_mutex_lock(&video->data_mutex);
+		clear_input_queue(input);
+		pthread_mutex_unlock(&video->data_mutex);
+
+		video_input_free(input);
+		os_atomic_dec_long(&video->detached_inputs);
+	}
+
+	return NULL;
+}
+
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
@@ -130,12 +438,22 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 	pthread_mutex_lock(&video->input_mutex);
 
+	/* scaling is independent for each input, so it is spread across the
+	 * scale pool before the callbacks are called in order */
+	scale_inputs(video, &frame_info->frame);
+
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array+i;
-		struct video_data frame = frame_info->frame;
+		struct video_input *input = video->inputs.array[i];
 
-		if (scale_video_output(input, &frame))
-			input->callback(input->param, &frame);
+		if (input->threaded) {
+			pthread_mutex_lock(&video->data_mutex);
+			queue_input_frame(input, frame_info);
+			pthread_mutex_unlock(&video->data_mutex);
+
+		} else if (input->scaled) {
+			input->total_frames++;
+			input->callback(input->param, &input->scaled_frame);
+		}
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
@@ -149,11 +467,16 @@ static inline bool video_output_cur_frame(struct video_output *video)
 	skipped = frame_info->skipped > 0;
 
 	if (complete) {
-		if (++video->first_added == video->info.cache_size)
+		release_cache_buffer(video, frame_info);
+
+		if (++video->first_added == video->cache_limit)
 			video->first_added = 0;
 
-		if (++video->available_frames == video->info.cache_size)
+		if (++video->available_frames == video->cache_limit)
 			video->last_added = video->first_added;
+
+		update_cache_stall(video);
+		shrink_cache(video);
 	} else if (skipped) {
 		--frame_info->skipped;
 		++video->skipped_frames;
@@ -202,20 +525,71 @@ static inline bool valid_video_params(const struct video_output_info *info)
 	       info->fps_num != 0;
 }
 
+static size_t get_frame_size(const struct video_output_info *info)
+{
+	size_t pixels = (size_t)info->width * (size_t)info->height;
+
+	switch (info->format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+		return pixels * 3 / 2;
+	case VIDEO_FORMAT_Y800:
+		return pixels;
+	case VIDEO_FORMAT_YVYU:
+	case VIDEO_FORMAT_YUY2:
+	case VIDEO_FORMAT_UYVY:
+		return pixels * 2;
+	case VIDEO_FORMAT_I444:
+		return pixels * 3;
+	case VIDEO_FORMAT_NONE:
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		break;
+	}
+
+	return pixels * 4;
+}
+
 static inline void init_cache(struct video_output *video)
 {
+	uint64_t memory_limit = video->info.cache_memory_limit;
+	size_t frame_size = get_frame_size(&video->info);
+	uint64_t limit;
+
+	if (!memory_limit)
+		memory_limit = DEFAULT_CACHE_MEMORY_LIMIT;
+
 	if (video->info.cache_size > MAX_CACHE_SIZE)
 		video->info.cache_size = MAX_CACHE_SIZE;
+	else if (video->info.cache_size == 0)
+		video->info.cache_size = 1;
 
-	for (size_t i = 0; i < video->info.cache_size; i++) {
-		struct video_frame *frame;
-		frame = (struct video_frame*)&video->cache[i];
+	limit = frame_size ? memory_limit / frame_size : MAX_CACHE_SIZE;
+	if (limit > MAX_CACHE_SIZE)
+		limit = MAX_CACHE_SIZE;
+	if (limit < video->info.cache_size)
+		limit = video->info.cache_size;
 
-		video_frame_init(frame, video->info.format,
-				video->info.width, video->info.height);
+	video->cache_limit = (size_t)limit;
+	video->available_frames = video->cache_limit;
+
+	/* the configured cache size is allocated up front so that the cache
+	 * only has to allocate when the video thread falls behind */
+	for (size_t i = 0; i < video->info.cache_size; i++) {
+		struct frame_buffer *buffer = get_frame_buffer(video);
+		da_push_back(video->free_buffers, &buffer);
 	}
+}
+
+static size_t get_scale_worker_count(void)
+{
+	int threads = os_get_logical_cores() / 2;
+
+	if (threads > MAX_SCALE_THREADS)
+		threads = MAX_SCALE_THREADS;
 
-	video->available_frames = video->info.cache_size;
+	return threads > 1 ? (size_t)(threads - 1) : 0;
 }
 
 int video_output_open(video_t **video, struct video_output_info *info)
@@ -250,6 +624,9 @@ int video_output_open(video_t **video, struct video_output_info *info)
 
 	init_cache(out);
 
+	out->scale_pool = os_task_pool_create("video-io: scale thread",
+			get_scale_worker_count());
+
 	out->initialized = true;
 	*video = out;
 	return VIDEO_OUTPUT_SUCCESS;
@@ -259,19 +636,58 @@ fail:
 	return VIDEO_OUTPUT_FAIL;
 }
 
+static void video_input_stop(struct video_input *input)
+{
+	struct video_output *video = input->video;
+
+	if (!input->thread_initialized) {
+		video_input_free(input);
+		return;
+	}
+
+	input->stop = true;
+	os_sem_post(input->queue_semaphore);
+
+	/* the input thread frees itself if it is disconnected from within
+	 * its own callback */
+	if (pthread_equal(pthread_self(), input->thread)) {
+		input->detached = true;
+		os_atomic_inc_long(&video->detached_inputs);
+		pthread_detach(input->thread);
+		return;
+	}
+
+	pthread_join(input->thread, NULL);
+
+	pthread_mutex_lock(&video->data_mutex);
+	clear_input_queue(input);
+	pthread_mutex_unlock(&video->data_mutex);
+
+	video_input_free(input);
+}
+
 void video_output_close(video_t *video)
 {
 	if (!video)
 		return;
 
 	video_output_stop(video);
+	os_task_pool_destroy(video->scale_pool);
 
 	for (size_t i = 0; i < video->inputs.num; i++)
-		video_input_free(&video->inputs.array[i]);
+		video_input_stop(video->inputs.array[i]);
 	da_free(video->inputs);
 
-	for (size_t i = 0; i < video->info.cache_size; i++)
-		video_frame_free((struct video_frame*)&video->cache[i]);
+	while (os_atomic_load_long(&video->detached_inputs))
+		os_sleep_ms(1);
+
+	for (size_t i = 0; i < video->cache_limit; i++) {
+		if (video->cache[i].buffer)
+			free_frame_buffer(video->cache[i].buffer);
+	}
+	for (size_t i = 0; i < video->free_buffers.num; i++)
+		free_frame_buffer(video->free_buffers.array[i]);
+	da_free(video->free_buffers);
 
 	os_sem_destroy(video->update_semaphore);
 	pthread_mutex_destroy(&video->data_mutex);
@@ -284,7 +700,7 @@ static size_t video_get_input_idx(const video_t *video,
 		void *param)
 {
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array+i;
+		struct video_input *input = video->inputs.array[i];
 		if (input->callback == callback && input->param == param)
 			return i;
 	}
@@ -330,8 +746,20 @@ static inline bool video_input_init(struct video_input *input,
 	return true;
 }
 
-bool video_output_connect(video_t *video,
-		const struct video_scale_info *conversion,
+static inline bool video_input_start_thread(struct video_input *input)
+{
+	if (os_sem_init(&input->queue_semaphore, 0) != 0)
+		return false;
+	if (pthread_create(&input->thread, NULL, video_input_thread,
+				input) != 0)
+		return false;
+
+	input->thread_initialized = true;
+	return true;
+}
+
+static bool connect_input(video_t *video,
+		const struct video_scale_info *conversion, bool threaded,
 		void (*callback)(void *param, struct video_data *frame),
 		void *param)
 {
@@ -345,31 +773,44 @@ bool video_output_connect(video_t *video,
 	if (video->inputs.num == 0) {
 		video->skipped_frames = 0;
 		video->total_frames = 0;
+
+		pthread_mutex_lock(&video->data_mutex);
+		video->high_water = 0;
+		video->stalls = 0;
+		video->last_stall_ns = 0;
+		video->max_stall_ns = 0;
+		pthread_mutex_unlock(&video->data_mutex);
 	}
 
 	if (video_get_input_idx(video, callback, param) == DARRAY_INVALID) {
-		struct video_input input;
-		memset(&input, 0, sizeof(input));
+		struct video_input *input = bzalloc(sizeof(*input));
 
-		input.callback = callback;
-		input.param    = param;
+		input->callback = callback;
+		input->param    = param;
+		input->video    = video;
+		input->threaded = threaded;
 
 		if (conversion) {
-			input.conversion = *conversion;
+			input->conversion = *conversion;
 		} else {
-			input.conversion.format    = video->info.format;
-			input.conversion.width     = video->info.width;
-			input.conversion.height    = video->info.height;
+			input->conversion.format    = video->info.format;
+			input->conversion.width     = video->info.width;
+			input->conversion.height    = video->info.height;
 		}
 
-		if (input.conversion.width == 0)
-			input.conversion.width = video->info.width;
-		if (input.conversion.height == 0)
-			input.conversion.height = video->info.height;
+		if (input->conversion.width == 0)
+			input->conversion.width = video->info.width;
+		if (input->conversion.height == 0)
+			input->conversion.height = video->info.height;
+
+		success = video_input_init(input, video);
+		if (success && threaded)
+			success = video_input_start_thread(input);
 
-		success = video_input_init(&input, video);
 		if (success)
 			da_push_back(video->inputs, &input);
+		else
+			video_input_free(input);
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
@@ -377,10 +818,42 @@ bool video_output_connect(video_t *video,
 	return success;
 }
 
+bool video_output_connect(video_t *video,
+		const struct video_scale_info *conversion,
+		void (*callback)(void *param, struct video_data *frame),
+		void *param)
+{
+	return connect_input(video, conversion, false, callback, param);
+}
+
+bool video_output_connect_threaded(video_t *video,
+		const struct video_scale_info *conversion,
+		void (*callback)(void *param, struct video_data *frame),
+		void *param)
+{
+	return connect_input(video, conversion, true, callback, param);
+}
+
+static inline void log_input_stats(const struct video_input *input)
+{
+	if (!input->dropped_frames)
+		return;
+
+	blog(LOG_INFO, "video-io: Input stopped, number of frames repeated "
+			"due to input lag: %"PRIu32"/%"PRIu32" (%0.1f%%), "
+			"lagged frames: %"PRIu32,
+			input->dropped_frames, input->total_frames,
+			(double)input->dropped_frames /
+			(double)input->total_frames * 100.0,
+			input->lagged_frames);
+}
+
 void video_output_disconnect(video_t *video,
 		void (*callback)(void *param, struct video_data *frame),
 		void *param)
 {
+	struct video_input *input = NULL;
+
 	if (!video || !callback)
 		return;
 
@@ -388,8 +861,9 @@ void video_output_disconnect(video_t *video,
 
 	size_t idx = video_get_input_idx(video, callback, param);
 	if (idx != DARRAY_INVALID) {
-		video_input_free(video->inputs.array+idx);
+		input = video->inputs.array[idx];
 		da_erase(video->inputs, idx);
+		log_input_stats(input);
 	}
 
 	if (video->inputs.num == 0) {
@@ -404,9 +878,71 @@ void video_output_disconnect(video_t *video,
 					video->skipped_frames,
 					video->total_frames,
 					percentage_skipped);
+
+		pthread_mutex_lock(&video->data_mutex);
+		if (video->stalls)
+			blog(LOG_INFO, "Video stopped, frame cache stalls: "
+					"%"PRIu32", longest stall: %0.1f ms, "
+					"high water mark: %d/%d frames",
+					video->stalls,
+					(double)video->max_stall_ns / 1000000.0,
+					(int)video->high_water,
+					(int)video->cache_limit);
+		pthread_mutex_unlock(&video->data_mutex);
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
+
+	/* the input thread is stopped outside of the input mutex so that its
+	 * callback can never deadlock against it */
+	if (input)
+		video_input_stop(input);
+}
+
+bool video_output_get_input_stats(video_t *video,
+		void (*callback)(void *param, struct video_data *frame),
+		void *param, struct video_input_stats *stats)
+{
+	bool found = false;
+
+	if (!video || !callback || !stats)
+		return false;
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	size_t idx = video_get_input_idx(video, callback, param);
+	if (idx != DARRAY_INVALID) {
+		struct video_input *input = video->inputs.array[idx];
+
+		pthread_mutex_lock(&video->data_mutex);
+		stats->total_frames   = input->total_frames;
+		stats->lagged_frames  = input->lagged_frames;
+		stats->dropped_frames = input->dropped_frames;
+		pthread_mutex_unlock(&video->data_mutex);
+
+		found = true;
+	}
+
+	pthread_mutex_unlock(&video->input_mutex);
+
+	return found;
+}
+
+void video_output_get_cache_stats(video_t *video,
+		struct video_cache_stats *stats)
+{
+	if (!video || !stats)
+		return;
+
+	pthread_mutex_lock(&video->data_mutex);
+	stats->depth         = (uint32_t)cache_depth(video);
+	stats->high_water    = (uint32_t)video->high_water;
+	stats->allocated     = (uint32_t)video->num_buffers;
+	stats->limit         = (uint32_t)video->cache_limit;
+	stats->stalls        = video->stalls;
+	stats->last_stall_ns = video->last_stall_ns;
+	stats->max_stall_ns  = video->max_stall_ns;
+	pthread_mutex_unlock(&video->data_mutex);
 }
 
 bool video_output_active(const video_t *video)
@@ -436,12 +972,13 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 		locked = false;
 
 	} else {
-		if (video->available_frames != video->info.cache_size) {
-			if (++video->last_added == video->info.cache_size)
+		if (video->available_frames != video->cache_limit) {
+			if (++video->last_added == video->cache_limit)
 				video->last_added = 0;
 		}
 
 		cfi = &video->cache[video->last_added];
+		set_cache_buffer(cfi, get_frame_buffer(video));
 		cfi->frame.timestamp = timestamp;
 		cfi->count = count;
 		cfi->skipped = 0;
@@ -463,6 +1000,7 @@ void video_output_unlock_frame(video_t *video)
 	pthread_mutex_lock(&video->data_mutex);
 
 	video->available_frames--;
+	update_cache_stall(video);
 	os_sem_post(video->update_semaphore);
 
 	pthread_mutex_unlock(&video->data_mutex);
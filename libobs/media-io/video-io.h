@@ -82,6 +82,10 @@ struct video_output_info {
 
 	enum video_colorspace colorspace;
 	enum video_range_type range;
+
+	/* maximum memory the frame cache may grow to when the video thread
+	 * falls behind, 0 for the default */
+	uint64_t          cache_memory_limit;
 };
 
 static inline bool format_is_yuv(enum video_format format)
@@ -183,6 +187,40 @@ EXPORT void video_output_disconnect(video_t *video,
 		void (*callback)(void *param, struct video_data *frame),
 		void *param);
 
+/**
+ * Connects a video callback that is called from its own thread rather than
+ * from the video output thread, so that a slow callback does not delay
+ * other connections.  If the callback falls behind, frames are repeated
+ * for that connection only, rather than skipped for every connection.
+ */
+EXPORT bool video_output_connect_threaded(video_t *video,
+		const struct video_scale_info *conversion,
+		void (*callback)(void *param, struct video_data *frame),
+		void *param);
+
+struct video_input_stats {
+	uint32_t total_frames;
+	uint32_t lagged_frames;
+	uint32_t dropped_frames;
+};
+
+EXPORT bool video_output_get_input_stats(video_t *video,
+		void (*callback)(void *param, struct video_data *frame),
+		void *param, struct video_input_stats *stats);
+
+struct video_cache_stats {
+	uint32_t depth;
+	uint32_t high_water;
+	uint32_t allocated;
+	uint32_t limit;
+	uint32_t stalls;
+	uint64_t last_stall_ns;
+	uint64_t max_stall_ns;
+};
+
+EXPORT void video_output_get_cache_stats(video_t *video,
+		struct video_cache_stats *stats);
+
 EXPORT bool video_output_active(const video_t *video);
 
 EXPORT const struct video_output_info *video_output_get_info(
@@ -71,9 +71,16 @@ struct obs_volmeter {
 	DARRAY(struct meter_cb)callbacks;
 
 	unsigned int           update_ms;
+	enum obs_volmeter_update_mode update_mode;
+	enum obs_peak_meter_type peak_meter_type;
 
-	float                  vol_magnitude[MAX_AUDIO_CHANNELS];
+	/* accumulated since the last update */
+	size_t                 nr_frames;
+	float                  vol_sum_of_squares[MAX_AUDIO_CHANNELS];
 	float                  vol_peak[MAX_AUDIO_CHANNELS];
+
+	/* last samples of each channel, for the true peak between packets */
+	float                  prev_samples[MAX_AUDIO_CHANNELS][3];
 };
 
 static float cubic_def_to_db(const float def)
@@ -256,46 +263,93 @@ static void volmeter_source_destroyed(void *vptr, calldata_t *calldata)
 	obs_volmeter_detach_source(volmeter);
 }
 
+static float volmeter_true_peak(obs_volmeter_t *volmeter, int channel_nr,
+		const float *samples, size_t nr_samples)
+{
+	float *prev = volmeter->prev_samples[channel_nr];
+	size_t nr_edge = nr_samples < 3 ? nr_samples : 3;
+	float edge[6];
+	float peak;
+
+	// The intervals around the start of the packet need the last samples
+	// of the previous packet.
+	memcpy(edge, prev, 3 * sizeof(float));
+	memcpy(edge + 3, samples, nr_edge * sizeof(float));
+
+	peak = fmaxf(audio_true_peak(edge, 3 + nr_edge),
+			audio_true_peak(samples, nr_samples));
+
+	if (nr_samples >= 3)
+		memcpy(prev, samples + nr_samples - 3, 3 * sizeof(float));
+	else
+		memcpy(prev, edge + nr_edge, 3 * sizeof(float));
+
+	return peak;
+}
+
 static void volmeter_process_audio_data(obs_volmeter_t *volmeter,
 		const struct audio_data *data)
 {
-	int nr_samples = data->frames;
+	size_t nr_samples = data->frames;
 	int channel_nr = 0;
 
 	for (size_t plane_nr = 0; plane_nr < MAX_AV_PLANES; plane_nr++) {
 		float *samples = (float *)data->data[plane_nr];
+		float peak;
+
+		if (channel_nr >= MAX_AUDIO_CHANNELS)
+			break;
 		if (!samples) {
 			// This plane does not contain data.
 			continue;
 		}
 
-		// For each plane calculate:
-		// * peak = the maximum-absolute of the sample values.
-		// * magnitude = root-mean-square of the sample values.
+		// For each plane accumulate until the next update:
+		// * peak = the maximum-absolute of the sample values, or the
+		//	estimated inter-sample peak for true peak meters.
+		// * sum of squares, for the root-mean-square magnitude.
 		//      A VU meter needs to integrate over 300ms, but this will
 		//	be handled by the ballistics of the meter itself,
 		//	reality. Which makes this calculation independent of
 		//	sample rate or update rate.
-		float peak = 0.0;
-		float sum_of_squares = 0.0;
-		for (int sample_nr = 0; sample_nr < nr_samples; sample_nr++) {
-			float sample = samples[sample_nr];
+		peak = audio_peak_sum_sq(samples, nr_samples,
+				&volmeter->vol_sum_of_squares[channel_nr]);
 
-			peak = fmaxf(peak, fabsf(sample));
-			sum_of_squares += (sample * sample);
-		}
+		if (volmeter->peak_meter_type == TRUE_PEAK_METER)
+			peak = fmaxf(peak, volmeter_true_peak(volmeter,
+					channel_nr, samples, nr_samples));
 
-		volmeter->vol_magnitude[channel_nr] = sqrtf(sum_of_squares /
-			nr_samples);
-		volmeter->vol_peak[channel_nr] = peak;
+		volmeter->vol_peak[channel_nr] = fmaxf(
+				volmeter->vol_peak[channel_nr], peak);
 		channel_nr++;
 	}
 
-	// Clear audio channels that are not in use.
-	for (; channel_nr < MAX_AUDIO_CHANNELS; channel_nr++) {
-		volmeter->vol_magnitude[channel_nr] = 0.0;
-		volmeter->vol_peak[channel_nr] = 0.0;
-	}
+	volmeter->nr_frames += nr_samples;
+}
+
+static inline bool volmeter_update_due(obs_volmeter_t *volmeter)
+{
+	uint64_t update_frames;
+	audio_t *audio;
+
+	if (volmeter->update_mode == OBS_VOLMETER_UPDATE_PACKET)
+		return true;
+
+	audio = obs_get_audio();
+	if (!audio)
+		return true;
+
+	update_frames = (uint64_t)volmeter->update_ms *
+		audio_output_get_sample_rate(audio) / 1000;
+	return volmeter->nr_frames >= update_frames;
+}
+
+static inline void volmeter_reset_levels(obs_volmeter_t *volmeter)
+{
+	volmeter->nr_frames = 0;
+	memset(volmeter->vol_sum_of_squares, 0,
+			sizeof(volmeter->vol_sum_of_squares));
+	memset(volmeter->vol_peak, 0, sizeof(volmeter->vol_peak));
 }
 
 static void volmeter_source_data_received(void *vptr, obs_source_t *source,
@@ -311,13 +365,21 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 
 	volmeter_process_audio_data(volmeter, data);
 
+	if (!volmeter->nr_frames || !volmeter_update_due(volmeter)) {
+		pthread_mutex_unlock(&volmeter->mutex);
+		return;
+	}
+
 	// Adjust magnitude/peak based on the volume level set by the user.
 	// And convert to dB.
 	mul = muted ? 0.0f : db_to_mul(volmeter->cur_db);
 	for (int channel_nr = 0; channel_nr < MAX_AUDIO_CHANNELS;
 		channel_nr++) {
-		magnitude[channel_nr] = mul_to_db(
-			volmeter->vol_magnitude[channel_nr] * mul);
+		float vol_magnitude = sqrtf(
+			volmeter->vol_sum_of_squares[channel_nr] /
+			(float)volmeter->nr_frames);
+
+		magnitude[channel_nr] = mul_to_db(vol_magnitude * mul);
 		peak[channel_nr] = mul_to_db(
 			volmeter->vol_peak[channel_nr] * mul);
 		input_peak[channel_nr] = mul_to_db(
@@ -327,6 +389,8 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 	// The input-peak is NOT adjusted with volume, so that the user
 	// can check the input-gain.
 
+	volmeter_reset_levels(volmeter);
+
 	pthread_mutex_unlock(&volmeter->mutex);
 
 	signal_levels_updated(volmeter, magnitude, peak, input_peak);
@@ -610,6 +674,8 @@ bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 
 	volmeter->source = source;
 	volmeter->cur_db = mul_to_db(vol);
+	volmeter_reset_levels(volmeter);
+	memset(volmeter->prev_samples, 0, sizeof(volmeter->prev_samples));
 
 	pthread_mutex_unlock(&volmeter->mutex);
 
@@ -664,6 +730,41 @@ unsigned int obs_volmeter_get_update_interval(obs_volmeter_t *volmeter)
 	return interval;
 }
 
+void obs_volmeter_set_update_mode(obs_volmeter_t *volmeter,
+		enum obs_volmeter_update_mode mode)
+{
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_set_update_mode"))
+		return;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	volmeter->update_mode = mode;
+	pthread_mutex_unlock(&volmeter->mutex);
+}
+
+enum obs_volmeter_update_mode obs_volmeter_get_update_mode(
+		obs_volmeter_t *volmeter)
+{
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_get_update_mode"))
+		return OBS_VOLMETER_UPDATE_PACKET;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	const enum obs_volmeter_update_mode mode = volmeter->update_mode;
+	pthread_mutex_unlock(&volmeter->mutex);
+
+	return mode;
+}
+
+void obs_volmeter_set_peak_meter_type(obs_volmeter_t *volmeter,
+		enum obs_peak_meter_type peak_meter_type)
+{
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_set_peak_meter_type"))
+		return;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	volmeter->peak_meter_type = peak_meter_type;
+	pthread_mutex_unlock(&volmeter->mutex);
+}
+
 int obs_volmeter_get_nr_channels(obs_volmeter_t *volmeter)
 {
 	int source_nr_audio_channels;
@@ -206,17 +206,14 @@ EXPORT void obs_volmeter_detach_source(obs_volmeter_t *volmeter);
  * @param ms update interval in ms
  *
  * This sets the update interval in milliseconds that should be processed before
- * the resulting values are emitted by the levels_updated signal. The resulting
- * number of audio samples is rounded to an integer.
+ * the resulting values are emitted to the callbacks when the volume meter is in
+ * OBS_VOLMETER_UPDATE_INTERVAL mode. The resulting number of audio samples is
+ * rounded to an integer.
  *
  * Please note that due to way obs does receive audio data from the sources
- * this is no hard guarantee for the timing of the signal itself. When the
- * volume meter receives a chunk of data that is multiple the size of the sample
- * interval, all data will be sampled and the values updated accordingly, but
- * only the signal for the last segment is actually emitted.
- * On the other hand data might be received in a way that will cause the signal
- * to be emitted in shorter intervals than specified here under some
- * circumstances.
+ * this is no hard guarantee for the timing of the callbacks themselves. Levels
+ * are only emitted once a whole packet has been processed, so the data of an
+ * update usually spans slightly more than the interval.
  */
 EXPORT void obs_volmeter_set_update_interval(obs_volmeter_t *volmeter,
 		const unsigned int ms);
@@ -228,6 +225,56 @@ EXPORT void obs_volmeter_set_update_interval(obs_volmeter_t *volmeter,
  */
 EXPORT unsigned int obs_volmeter_get_update_interval(obs_volmeter_t *volmeter);
 
+enum obs_volmeter_update_mode {
+	/** Levels are emitted for every packet of audio data received */
+	OBS_VOLMETER_UPDATE_PACKET,
+
+	/**
+	 * Levels are accumulated over the update interval and emitted once
+	 * per interval
+	 */
+	OBS_VOLMETER_UPDATE_INTERVAL,
+};
+
+/**
+ * @brief Set the update mode of the volume meter
+ * @param volmeter pointer to the volume meter object
+ * @param mode the update mode
+ *
+ * The default mode is OBS_VOLMETER_UPDATE_PACKET.  Meters that are only
+ * redrawn at a fixed rate should use OBS_VOLMETER_UPDATE_INTERVAL, so that
+ * their callbacks are not called more often than they can be displayed.
+ */
+EXPORT void obs_volmeter_set_update_mode(obs_volmeter_t *volmeter,
+		enum obs_volmeter_update_mode mode);
+
+/**
+ * @brief Get the update mode currently used for the volume meter
+ * @param volmeter pointer to the volume meter object
+ * @return the update mode
+ */
+EXPORT enum obs_volmeter_update_mode obs_volmeter_get_update_mode(
+		obs_volmeter_t *volmeter);
+
+enum obs_peak_meter_type {
+	/** The peak is the maximum absolute sample value */
+	SAMPLE_PEAK_METER,
+
+	/**
+	 * The peak includes the peaks between samples, estimated with 4x
+	 * oversampling
+	 */
+	TRUE_PEAK_METER,
+};
+
+/**
+ * @brief Set the type of peak reported by the volume meter
+ * @param volmeter pointer to the volume meter object
+ * @param peak_meter_type the peak meter type, SAMPLE_PEAK_METER by default
+ */
+EXPORT void obs_volmeter_set_peak_meter_type(obs_volmeter_t *volmeter,
+		enum obs_peak_meter_type peak_meter_type);
+
 /**
  * @brief Get the number of channels which are configured for this source.
  * @param volmeter pointer to the volume meter object
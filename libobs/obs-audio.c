@@ -16,6 +16,7 @@
 ******************************************************************************/
 
 #include <inttypes.h>
+#include "media-io/audio-math.h"
 #include "obs-internal.h"
 
 struct ts_info {
@@ -35,7 +36,137 @@ static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 		da_push_back(audio->render_order, &source);
 	}
 
-	UNUSED_PARAMETER(parent);
+	if (parent) {
+		struct audio_tree_link link = {parent, source};
+		da_push_back(audio->render_links, &link);
+	}
+}
+
+/* a source has to be rendered after every source it mixes.  links are
+ * recorded children first, so levels settle in one pass unless the tree
+ * was changed while it was being enumerated */
+static void calc_render_levels(struct obs_core_audio *audio)
+{
+	size_t passes = 0;
+	bool changed;
+
+	do {
+		changed = false;
+
+		for (size_t i = 0; i < audio->render_links.num; i++) {
+			struct audio_tree_link *link =
+				audio->render_links.array + i;
+			size_t level = link->child->audio_render_level + 1;
+
+			if (link->parent->audio_render_level < level) {
+				link->parent->audio_render_level = level;
+				changed = true;
+			}
+		}
+	} while (changed && ++passes < audio->render_order.num);
+}
+
+/* groups the render order by level with a counting sort, keeping the order
+ * of the sources within each level */
+static void sort_render_levels(struct obs_core_audio *audio)
+{
+	size_t *ends;
+	size_t total = 0;
+
+	calc_render_levels(audio);
+
+	da_resize(audio->render_level_ends, 0);
+	da_resize(audio->render_levels, audio->render_order.num);
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		size_t level = audio->render_order.array[i]->audio_render_level;
+
+		if (level >= audio->render_level_ends.num)
+			da_resize(audio->render_level_ends, level + 1);
+		audio->render_level_ends.array[level]++;
+	}
+
+	/* counts to start offsets, advanced to the end offsets below */
+	ends = audio->render_level_ends.array;
+	for (size_t i = 0; i < audio->render_level_ends.num; i++) {
+		size_t count = ends[i];
+		ends[i] = total;
+		total += count;
+	}
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		audio->render_levels.array[ends[source->audio_render_level]++] =
+			source;
+	}
+}
+
+struct audio_render_job {
+	obs_source_t **sources;
+	uint32_t mixers;
+	size_t channels;
+	size_t sample_rate;
+	size_t size;
+};
+
+static void render_audio_task(void *param, size_t idx)
+{
+	struct audio_render_job *job = param;
+	obs_source_t *source = job->sources[idx];
+	const char *name = source->audio_render_profile_name;
+
+	if (!name) {
+		name = profile_store_name(obs_get_profiler_name_store(),
+				"audio_render(%s)", source->context.name);
+		source->audio_render_profile_name = name;
+	}
+
+	profile_start(name);
+	obs_source_audio_render(source, job->mixers, job->channels,
+			job->sample_rate, job->size);
+	profile_end(name);
+}
+
+/* rendering a source without a custom audio_render is only a copy of its
+ * buffered audio, so a level is only split across the render threads when
+ * it has more than one source that runs plugin rendering code */
+static bool split_render_level(obs_source_t **sources, size_t num)
+{
+	size_t custom = 0;
+
+	for (size_t i = 0; i < num; i++) {
+		if (sources[i]->info.audio_render && ++custom == 2)
+			return true;
+	}
+
+	return false;
+}
+
+static void render_audio_sources(struct obs_core_audio *audio,
+		uint32_t mixers, size_t channels, size_t sample_rate,
+		size_t size)
+{
+	struct audio_render_job job = {
+		.mixers      = mixers,
+		.channels    = channels,
+		.sample_rate = sample_rate,
+		.size        = size
+	};
+	size_t start = 0;
+
+	sort_render_levels(audio);
+
+	for (size_t i = 0; i < audio->render_level_ends.num; i++) {
+		size_t end = audio->render_level_ends.array[i];
+		size_t num = end - start;
+
+		job.sources = audio->render_levels.array + start;
+
+		os_task_pool_run(split_render_level(job.sources, num) ?
+				audio->render_pool : NULL,
+				render_audio_task, &job, num);
+		start = end;
+	}
 }
 
 static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
@@ -63,17 +194,16 @@ static inline void mix_audio(struct audio_output_data *mixes,
 	}
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
+		if ((source->audio_output_mask & (1 << mix_idx)) == 0)
+			continue;
 
-			mix += start_point;
-			end = aud + total_floats;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch] + start_point;
+			const float *aud = obs_source_audio_output(source,
+					mix_idx, ch);
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_mix_add_gain(mix, aud, source->audio_output_gain,
+					total_floats);
 		}
 	}
 }
@@ -360,8 +490,12 @@ static inline void calc_min_ts(struct obs_core_data *data,
 
 static inline void release_audio_sources(struct obs_core_audio *audio)
 {
-	for (size_t i = 0; i < audio->render_order.num; i++)
-		obs_source_release(audio->render_order.array[i]);
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+
+		source->audio_render_level = 0;
+		obs_source_release(source);
+	}
 }
 
 bool audio_callback(void *param,
@@ -379,6 +513,7 @@ bool audio_callback(void *param,
 
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
+	da_resize(audio->render_links, 0);
 
 	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
 	circlebuf_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
@@ -415,12 +550,8 @@ bool audio_callback(void *param,
 	pthread_mutex_unlock(&data->audio_sources_mutex);
 
 	/* ------------------------------------------------ */
-	/* render audio data */
-	for (size_t i = 0; i < audio->render_order.num; i++) {
-		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate,
-				audio_size);
-	}
+	/* render audio data, independent sources in parallel */
+	render_audio_sources(audio, mixers, channels, sample_rate, audio_size);
 
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
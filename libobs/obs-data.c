@@ -33,6 +33,7 @@ struct obs_data_item {
 	struct obs_data      *parent;
 	struct obs_data_item *next;
 	enum obs_data_type   type;
+	uint32_t             name_hash;
 	size_t               name_len;
 	size_t               data_len;
 	size_t               data_size;
@@ -46,6 +47,13 @@ struct obs_data {
 	volatile long        ref;
 	char                 *json;
 	struct obs_data_item *first_item;
+
+	/* hash index of the items, only created once the object has enough
+	 * items for it to be worth it.  the linked list remains the primary
+	 * storage and keeps the items ordered */
+	size_t               num_items;
+	struct obs_data_item **index;
+	size_t               index_size;
 };
 
 struct obs_data_array {
@@ -88,6 +96,18 @@ static inline char *get_item_name(struct obs_data_item *item)
 	return (char*)item + sizeof(struct obs_data_item);
 }
 
+static inline uint32_t get_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
 static inline void *get_data_ptr(obs_data_item_t *item)
 {
 	return (uint8_t*)get_item_name(item) + item->name_len;
@@ -277,9 +297,10 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	item = bzalloc(total_size);
 
 	item->capacity = total_size;
-	item->type     = type;
-	item->name_len = name_size;
-	item->ref      = 1;
+	item->type      = type;
+	item->name_hash = get_name_hash(name);
+	item->name_len  = name_size;
+	item->ref       = 1;
 
 	if (default_data) {
 		item->default_len = size;
@@ -300,6 +321,144 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	return item;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Item index (open addressing with linear probing) */
+
+#define INDEX_MIN_ITEMS 16
+
+static inline size_t index_mask(const struct obs_data *data)
+{
+	return data->index_size - 1;
+}
+
+static void index_insert(struct obs_data *data, struct obs_data_item *item)
+{
+	size_t mask = index_mask(data);
+	size_t i = item->name_hash & mask;
+
+	while (data->index[i])
+		i = (i + 1) & mask;
+
+	data->index[i] = item;
+}
+
+static void index_rebuild(struct obs_data *data)
+{
+	struct obs_data_item *item = data->first_item;
+	size_t size = INDEX_MIN_ITEMS * 2;
+
+	while (size < data->num_items * 2)
+		size *= 2;
+
+	bfree(data->index);
+	data->index = bzalloc(size * sizeof(struct obs_data_item*));
+	data->index_size = size;
+
+	while (item) {
+		index_insert(data, item);
+		item = item->next;
+	}
+}
+
+/* the hash is passed separately because the item may have already been
+ * reallocated */
+static size_t index_find_slot(struct obs_data *data,
+		struct obs_data_item *item, uint32_t hash)
+{
+	size_t mask = index_mask(data);
+	size_t i = hash & mask;
+
+	while (data->index[i]) {
+		if (data->index[i] == item)
+			return i;
+		i = (i + 1) & mask;
+	}
+
+	return DARRAY_INVALID;
+}
+
+static struct obs_data_item *index_find(struct obs_data *data,
+		const char *name)
+{
+	uint32_t hash = get_name_hash(name);
+	size_t mask = index_mask(data);
+	size_t i = hash & mask;
+	struct obs_data_item *item;
+
+	while ((item = data->index[i]) != NULL) {
+		if (item->name_hash == hash &&
+		    strcmp(get_item_name(item), name) == 0)
+			return item;
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static void index_remove(struct obs_data *data, struct obs_data_item *item)
+{
+	size_t mask = index_mask(data);
+	size_t i = index_find_slot(data, item, item->name_hash);
+	size_t j = i;
+
+	if (i == DARRAY_INVALID)
+		return;
+
+	data->index[i] = NULL;
+
+	/* shift back any following entries that can no longer be reached
+	 * through the emptied slot */
+	for (;;) {
+		size_t home;
+
+		j = (j + 1) & mask;
+		if (!data->index[j])
+			break;
+
+		home = data->index[j]->name_hash & mask;
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			data->index[i] = data->index[j];
+			data->index[j] = NULL;
+			i = j;
+		}
+	}
+}
+
+/* the index is only ever modified when items are added or removed, so
+ * lookups never write to the object */
+static inline void index_add_item(struct obs_data *data,
+		struct obs_data_item *item)
+{
+	data->num_items++;
+
+	if (data->index && data->num_items * 2 <= data->index_size)
+		index_insert(data, item);
+	else if (data->num_items >= INDEX_MIN_ITEMS)
+		index_rebuild(data);
+}
+
+static inline void index_remove_item(struct obs_data *data,
+		struct obs_data_item *item)
+{
+	data->num_items--;
+
+	if (data->index)
+		index_remove(data, item);
+}
+
+static inline void index_replace_item(struct obs_data *data,
+		struct obs_data_item *old_ptr, struct obs_data_item *new_ptr)
+{
+	if (data->index) {
+		size_t i = index_find_slot(data, old_ptr,
+				new_ptr->name_hash);
+		if (i != DARRAY_INVALID)
+			data->index[i] = new_ptr;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
 static struct obs_data_item **get_item_prev_next(struct obs_data *data,
 		struct obs_data_item *current)
 {
@@ -328,6 +487,8 @@ static inline void obs_data_item_detach(struct obs_data_item *item)
 	if (prev_next) {
 		*prev_next = item->next;
 		item->next = NULL;
+
+		index_remove_item(item->parent, item);
 	}
 }
 
@@ -337,8 +498,11 @@ static inline void obs_data_item_reattach(struct obs_data_item *old_ptr,
 	struct obs_data_item **prev_next = get_item_prev_next(new_ptr->parent,
 			old_ptr);
 
-	if (prev_next)
+	if (prev_next) {
 		*prev_next = new_ptr;
+
+		index_replace_item(new_ptr->parent, old_ptr, new_ptr);
+	}
 }
 
 static struct obs_data_item *obs_data_item_ensure_capacity(
@@ -711,6 +875,7 @@ static inline void obs_data_destroy(struct obs_data *data)
 
 	/* NOTE: don't use bfree for json text, allocated by json */
 	free(data->json);
+	bfree(data->index);
 	bfree(data);
 }
 
@@ -766,6 +931,9 @@ static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 {
 	if (!data) return NULL;
 
+	if (data->index)
+		return index_find(data, name);
+
 	struct obs_data_item *item = data->first_item;
 
 	while (item) {
@@ -811,6 +979,8 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 		if (!prev)
 			data->first_item = new_item;
 
+		index_add_item(data, new_item);
+
 		obs_data_item_release(&prev);
 		obs_data_item_release(&next);
 
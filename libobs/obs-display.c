@@ -48,6 +48,7 @@ bool obs_display_init(struct obs_display *display,
 
 	display->background_color = 0x4C4C4C;
 	display->enabled = true;
+	display->visible = true;
 	return true;
 }
 
@@ -181,7 +182,7 @@ void render_display(struct obs_display *display)
 	uint32_t cx, cy;
 	bool size_changed;
 
-	if (!display || !display->enabled) return;
+	if (!display || !display->enabled || !display->visible) return;
 
 	/* -------------------------------------------- */
 
@@ -225,6 +226,31 @@ bool obs_display_enabled(obs_display_t *display)
 	return display ? display->enabled : false;
 }
 
+void obs_display_set_visible(obs_display_t *display, bool visible)
+{
+	if (display)
+		display->visible = visible;
+}
+
+bool obs_display_visible(obs_display_t *display)
+{
+	return display ? display->visible : false;
+}
+
+void obs_display_set_max_fps(obs_display_t *display, uint32_t fps)
+{
+	if (display)
+		display->render_interval = fps ? 1000000000ULL / fps : 0;
+}
+
+uint32_t obs_display_get_max_fps(obs_display_t *display)
+{
+	if (!display || !display->render_interval)
+		return 0;
+
+	return (uint32_t)(1000000000ULL / display->render_interval);
+}
+
 void obs_display_set_background_color(obs_display_t *display, uint32_t color)
 {
 	if (display)
@@ -189,8 +189,8 @@ static void add_connection(struct obs_encoder *encoder)
 		struct video_scale_info info = {0};
 		get_video_info(encoder, &info);
 
-		video_output_connect(encoder->media, &info, receive_video,
-			encoder);
+		video_output_connect_threaded(encoder->media, &info,
+				receive_video, encoder);
 	}
 
 	set_encoder_active(encoder, true);
@@ -721,7 +721,6 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 		struct encoder_callback *cb, struct encoder_packet *packet)
 {
 	struct encoder_packet first_packet;
-	DARRAY(uint8_t)       data;
 	uint8_t               *sei;
 	size_t                size;
 
@@ -729,25 +728,23 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 	if (!packet->keyframe)
 		return;
 
-	da_init(data);
-
 	if (!get_sei(encoder, &sei, &size) || !sei || !size) {
 		cb->new_packet(cb->param, packet);
 		cb->sent_first_packet = true;
 		return;
 	}
 
-	da_push_back_array(data, sei, size);
-	da_push_back_array(data, packet->data, packet->size);
-
 	first_packet      = *packet;
-	first_packet.data = data.array;
-	first_packet.size = data.num;
+	first_packet.data = obs_packet_pool_alloc(size + packet->size);
+	first_packet.size = size + packet->size;
+
+	memcpy(first_packet.data, sei, size);
+	memcpy(first_packet.data + size, packet->data, packet->size);
 
 	cb->new_packet(cb->param, &first_packet);
 	cb->sent_first_packet = true;
 
-	da_free(data);
+	obs_encoder_packet_release(&first_packet);
 }
 
 static inline void send_packet(struct obs_encoder *encoder,
@@ -813,10 +810,19 @@ static inline void do_encode(struct obs_encoder *encoder,
 
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
-		for (size_t i = encoder->callbacks.num; i > 0; i--) {
-			struct encoder_callback *cb;
-			cb = encoder->callbacks.array+(i-1);
-			send_packet(encoder, cb, &pkt);
+		/* the packet data is copied into a single refcounted payload
+		 * that every output references rather than copies */
+		if (encoder->callbacks.num) {
+			struct encoder_packet shared_pkt;
+			obs_encoder_packet_create_instance(&shared_pkt, &pkt);
+
+			for (size_t i = encoder->callbacks.num; i > 0; i--) {
+				struct encoder_callback *cb;
+				cb = encoder->callbacks.array+(i-1);
+				send_packet(encoder, cb, &shared_pkt);
+			}
+
+			obs_encoder_packet_release(&shared_pkt);
 		}
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
@@ -1036,12 +1042,8 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 		const struct encoder_packet *src)
 {
-	long *p_refs;
-
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void*)(p_refs + 1);
-	*p_refs = 1;
+	dst->data = obs_packet_pool_alloc(src->size);
 	memcpy(dst->data, src->data, src->size);
 }
 
@@ -1077,8 +1079,14 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 
 	if (pkt->data) {
 		long *p_refs = ((long*)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
-			bfree(p_refs);
+		long refs = os_atomic_dec_long(p_refs);
+
+		if ((refs & ~OBS_PACKET_POOL_FLAG) == 0) {
+			if (refs & OBS_PACKET_POOL_FLAG)
+				obs_packet_pool_free(p_refs);
+			else
+				bfree(p_refs);
+		}
 	}
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
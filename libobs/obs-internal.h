@@ -24,6 +24,7 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/task-pool.h"
 #include "callback/signal.h"
 #include "callback/proc.h"
 
@@ -37,6 +38,7 @@
 #include "obs.h"
 
 #define NUM_TEXTURES 2
+#define MAX_READBACK_DEPTH 8
 #define MICROSECOND_DEN 1000000
 
 static inline int64_t packet_dts_usec(struct encoder_packet *packet)
@@ -201,6 +203,7 @@ extern void obs_view_free(struct obs_view *view);
 struct obs_display {
 	bool                            size_changed;
 	bool                            enabled;
+	bool                            visible;
 	uint32_t                        cx, cy;
 	uint32_t                        background_color;
 	gs_swapchain_t                  *swap;
@@ -208,6 +211,13 @@ struct obs_display {
 	pthread_mutex_t                 draw_info_mutex;
 	DARRAY(struct draw_callback)    draw_callbacks;
 
+	/* render scheduling, only used by the graphics thread apart from
+	 * render_interval */
+	uint64_t                        render_interval;
+	uint64_t                        next_render_time;
+	uint64_t                        last_render_time;
+	uint64_t                        render_cost;
+
 	struct obs_display              *next;
 	struct obs_display              **prev_next;
 };
@@ -225,15 +235,24 @@ struct obs_vframe_info {
 	int count;
 };
 
+struct source_tick {
+	struct obs_source *source;
+	float seconds;
+};
+
+struct fused_effect {
+	char                            *key;
+	gs_effect_t                     *effect;
+};
+
 struct obs_core_video {
 	graphics_t                      *graphics;
-	gs_stagesurf_t                  *copy_surfaces[NUM_TEXTURES];
+	gs_stagesurf_t                  *copy_surfaces[MAX_READBACK_DEPTH];
 	gs_texture_t                    *render_textures[NUM_TEXTURES];
 	gs_texture_t                    *output_textures[NUM_TEXTURES];
 	gs_texture_t                    *convert_textures[NUM_TEXTURES];
 	bool                            textures_rendered[NUM_TEXTURES];
 	bool                            textures_output[NUM_TEXTURES];
-	bool                            textures_copied[NUM_TEXTURES];
 	bool                            textures_converted[NUM_TEXTURES];
 	struct circlebuf                vframe_info_buffer;
 	gs_effect_t                     *default_effect;
@@ -249,6 +268,13 @@ struct obs_core_video {
 	gs_stagesurf_t                  *mapped_surface;
 	int                             cur_texture;
 
+	/* ring of copy_surfaces staged but not yet downloaded */
+	uint32_t                        readback_depth;
+	uint32_t                        num_copy_surfaces;
+	uint32_t                        copy_surface_head;
+	uint32_t                        copies_staged;
+	uint32_t                        readback_stalls;
+
 	uint64_t                        video_time;
 	uint64_t                        video_avg_frame_time_ns;
 	double                          video_fps;
@@ -264,6 +290,15 @@ struct obs_core_video {
 	uint32_t                        plane_offsets[3];
 	uint32_t                        plane_sizes[3];
 	uint32_t                        plane_linewidth[3];
+	os_task_pool_t                  *convert_pool;
+
+	os_task_pool_t                  *tick_pool;
+	DARRAY(struct source_tick)      parallel_ticks;
+	uint32_t                        tick_frame;
+
+	/* effects of runs of fused filters, by their filter types */
+	volatile bool                   filter_fusion;
+	DARRAY(struct fused_effect)     fused_effects;
 
 	uint32_t                        output_width;
 	uint32_t                        output_height;
@@ -288,12 +323,24 @@ struct obs_core_video {
 
 struct audio_monitor;
 
+struct audio_tree_link {
+	struct obs_source               *parent;
+	struct obs_source               *child;
+};
+
 struct obs_core_audio {
 	audio_t                         *audio;
 
 	DARRAY(struct obs_source*)      render_order;
 	DARRAY(struct obs_source*)      root_nodes;
 
+	/* render_order grouped by render level, sources of a level only
+	 * depend on sources of lower levels and are rendered in parallel */
+	DARRAY(struct audio_tree_link)  render_links;
+	DARRAY(struct obs_source*)      render_levels;
+	DARRAY(size_t)                  render_level_ends;
+	os_task_pool_t                  *render_pool;
+
 	uint64_t                        buffered_ts;
 	struct circlebuf                buffered_timestamps;
 	int                             buffering_wait_ticks;
@@ -523,9 +570,14 @@ struct obs_weak_source {
 	struct obs_source *source;
 };
 
+struct audio_cb_async;
+
 struct audio_cb_info {
 	obs_source_audio_capture_t callback;
 	void *param;
+
+	/* set for callbacks called on their own thread */
+	struct audio_cb_async *async;
 };
 
 struct obs_source {
@@ -543,6 +595,10 @@ struct obs_source {
 	/* signals to call the source update in the video thread */
 	bool                            defer_update;
 
+	/* incremented whenever the source's video may have changed outside
+	 * of its size, used by the scene composite cache */
+	volatile long                   video_generation;
+
 	/* ensures show/hide are only called once */
 	volatile long                   show_refs;
 
@@ -557,6 +613,11 @@ struct obs_source {
 	bool                            active;
 	bool                            showing;
 
+	/* tick scheduling: time not yet passed to the tick callback while the
+	 * source is idle, and the profiler name of the tick callback */
+	float                           pending_tick_seconds;
+	const char                      *tick_profile_name;
+
 	/* used to temporarily disable sources if needed */
 	bool                            enabled;
 
@@ -584,13 +645,38 @@ struct obs_source {
 	size_t                          last_audio_input_buf_size;
 	DARRAY(struct audio_action)     audio_actions;
 	float                           *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS];
+
+	/* mixes of the audio output that have data, other mixes are silent.
+	 * each mix with data is stored in audio_output_buf[audio_output_ref]
+	 * so mixes with identical data share one buffer, and the data still
+	 * has to be multiplied by audio_output_gain when read */
+	uint32_t                        audio_output_mask;
+	uint8_t                         audio_output_ref[MAX_AUDIO_MIXES];
+	float                           audio_output_gain;
+
+	/* the audio output multiplied by audio_output_gain for
+	 * obs_source_get_audio_mix, filled at most once per audio tick with
+	 * audio_buf_mutex held, laid out like audio_output_buf */
+	float                           *audio_mix_buf;
+	bool                            audio_mix_scaled;
+
+	/* audio thread only: one more than the highest render level of the
+	 * sources it mixes, and the profiler name of its audio render */
+	size_t                          audio_render_level;
+	const char                      *audio_render_profile_name;
 	struct resample_info            sample_info;
 	audio_resampler_t               *resampler;
 	pthread_mutex_t                 audio_actions_mutex;
 	pthread_mutex_t                 audio_buf_mutex;
 	pthread_mutex_t                 audio_mutex;
+
+	/* audio capture callbacks are copy-on-write: dispatch reads the
+	 * current list without locking, while changes are made to the other
+	 * list with audio_cb_mutex held and then published */
 	pthread_mutex_t                 audio_cb_mutex;
-	DARRAY(struct audio_cb_info)    audio_cb_list;
+	DARRAY(struct audio_cb_info)    audio_cb_lists[2];
+	volatile long                   audio_cb_cur;
+	volatile long                   audio_cb_readers[2];
 	struct obs_audio_data           audio_data;
 	size_t                          audio_storage_size;
 	uint32_t                        audio_mixers;
@@ -627,6 +713,7 @@ struct obs_source {
 	uint32_t                        async_cache_height;
 	uint32_t                        async_convert_width;
 	uint32_t                        async_convert_height;
+	uint32_t                        async_overflow_count;
 
 	/* async video deinterlacing */
 	uint64_t                        deinterlace_offset;
@@ -758,12 +845,28 @@ static inline enum gs_color_format convert_video_format(
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+extern bool obs_source_video_tick_state(obs_source_t *source);
+extern void obs_source_video_tick_callback(obs_source_t *source,
+		float seconds);
 extern float obs_source_get_target_volume(obs_source_t *source,
 		obs_source_t *target);
 
 extern void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 		size_t channels, size_t sample_rate, size_t size);
 
+/* returns the data of a channel of a mix of the source's audio output, or
+ * NULL if the mix is silent.  the data still has to be multiplied by
+ * audio_output_gain.  the audio output may be shared by several parents
+ * rendered in parallel, so it must not be modified by them */
+static inline const float *obs_source_audio_output(
+		const struct obs_source *source, size_t mix, size_t ch)
+{
+	if ((source->audio_output_mask & (1 << mix)) == 0)
+		return NULL;
+
+	return source->audio_output_buf[source->audio_output_ref[mix]][ch];
+}
+
 extern void add_alignment(struct vec2 *v, uint32_t align, int cx, int cy);
 
 extern struct obs_source_frame *filter_async_video(obs_source_t *source,
@@ -782,6 +885,17 @@ extern void deinterlace_process_last_frame(obs_source_t *source,
 extern void deinterlace_update_async_video(obs_source_t *source);
 extern void deinterlace_render(obs_source_t *s);
 
+extern bool filter_render_target(obs_source_t *filter, obs_source_t *target,
+		enum gs_color_format format,
+		enum obs_allow_direct_render allow_direct);
+extern void filter_draw_effect(obs_source_t *filter, obs_source_t *target,
+		gs_effect_t *effect, uint32_t width, uint32_t height,
+		const char *tech_name);
+extern void filter_skip_to_target(obs_source_t *target, obs_source_t *parent);
+
+extern bool fused_filters_render(obs_source_t *filter);
+extern void fused_effects_free(struct obs_core_video *video);
+
 
 /* ------------------------------------------------------------------------- */
 /* outputs  */
@@ -812,6 +926,9 @@ struct caption_text {
 	struct caption_text *next;
 };
 
+/* one interleaving queue for video, and one for each audio mix */
+#define INTERLEAVED_TRACKS (MAX_AUDIO_MIXES + 1)
+
 struct obs_output {
 	struct obs_context_data         context;
 	struct obs_output_info          info;
@@ -831,7 +948,7 @@ struct obs_output {
 	pthread_t                       end_data_capture_thread;
 	os_event_t                      *stopping_event;
 	pthread_mutex_t                 interleaved_mutex;
-	DARRAY(struct encoder_packet)   interleaved_packets;
+	struct circlebuf                interleaved_packets[INTERLEAVED_TRACKS];
 	int                             stop_code;
 
 	int                             reconnect_retry_sec;
@@ -1004,6 +1121,14 @@ extern void obs_encoder_remove_output(struct obs_encoder *encoder,
 
 void obs_encoder_destroy(obs_encoder_t *encoder);
 
+/* set in the reference count of packet payloads owned by the packet pool */
+#define OBS_PACKET_POOL_FLAG 0x40000000L
+
+extern uint8_t *obs_packet_pool_alloc(size_t size);
+extern void obs_packet_pool_free(long *p_refs);
+extern void obs_packet_pool_init(void);
+extern void obs_packet_pool_shutdown(void);
+
 /* ------------------------------------------------------------------------- */
 /* services */
 
@@ -164,9 +164,17 @@ fail:
 
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array+i);
-	da_free(output->interleaved_packets);
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		struct encoder_packet packet;
+
+		while (queue->size) {
+			circlebuf_pop_front(queue, &packet, sizeof(packet));
+			obs_encoder_packet_release(&packet);
+		}
+
+		circlebuf_free(queue);
+	}
 }
 
 void obs_output_destroy(obs_output_t *output)
@@ -681,6 +689,19 @@ uint64_t obs_output_get_total_bytes(const obs_output_t *output)
 	return output->info.get_total_bytes(output->context.data);
 }
 
+uint64_t obs_output_get_total_send_calls(const obs_output_t *output)
+{
+	if (!obs_output_valid(output, "obs_output_get_total_send_calls"))
+		return 0;
+	if (!output->info.get_total_send_calls)
+		return 0;
+
+	if (delay_active(output) && !delay_capturing(output))
+		return 0;
+
+	return output->info.get_total_send_calls(output->context.data);
+}
+
 int obs_output_get_frames_dropped(const obs_output_t *output)
 {
 	if (!obs_output_valid(output, "obs_output_get_frames_dropped"))
@@ -1010,17 +1031,89 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 }
 #endif
 
+/* ------------------------------------------------------------------------- */
+/* packet interleaving
+ *
+ *   Each track (video, and each audio mix) has its own queue of packets.
+ * Encoders always emit packets of a track in DTS order, so each queue is
+ * always sorted, and the interleaved order is produced by merging the heads
+ * of the queues.  Inserting a packet is an append, and changing the offsets of
+ * a track never requires re-sorting anything. */
+
+static inline struct circlebuf *get_packet_queue(struct obs_output *output,
+		enum obs_encoder_type type, size_t track_idx)
+{
+	return type == OBS_ENCODER_VIDEO ?
+		&output->interleaved_packets[0] :
+		&output->interleaved_packets[track_idx + 1];
+}
+
+static inline size_t queue_num_packets(const struct circlebuf *queue)
+{
+	return queue->size / sizeof(struct encoder_packet);
+}
+
+static inline struct encoder_packet *queue_packet(struct circlebuf *queue,
+		size_t idx)
+{
+	return circlebuf_data(queue, idx * sizeof(struct encoder_packet));
+}
+
+static inline struct encoder_packet *queue_first_packet(
+		struct circlebuf *queue)
+{
+	return queue->size ? queue_packet(queue, 0) : NULL;
+}
+
+static inline struct encoder_packet *queue_last_packet(
+		struct circlebuf *queue)
+{
+	size_t num = queue_num_packets(queue);
+	return num ? queue_packet(queue, num - 1) : NULL;
+}
+
+/* video packets go before audio packets of the same timestamp */
+static inline bool packet_precedes(const struct encoder_packet *a,
+		const struct encoder_packet *b)
+{
+	if (a->dts_usec != b->dts_usec)
+		return a->dts_usec < b->dts_usec;
+	return a->type == OBS_ENCODER_VIDEO && b->type != OBS_ENCODER_VIDEO;
+}
+
+static struct circlebuf *find_next_packet_queue(struct obs_output *output)
+{
+	struct circlebuf *next_queue = NULL;
+	struct encoder_packet *next = NULL;
+
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		struct encoder_packet *packet = queue_first_packet(queue);
+
+		if (packet && (!next || packet_precedes(packet, next))) {
+			next_queue = queue;
+			next = packet;
+		}
+	}
+
+	return next_queue;
+}
+
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct circlebuf *queue = find_next_packet_queue(output);
+	struct encoder_packet out;
+
+	if (!queue)
+		return;
 
 	/* do not send an interleaved packet if there's no packet of the
 	 * opposing type of a higher timestamp in the interleave buffer.
 	 * this ensures that the timestamps are monotonic */
-	if (!has_higher_opposing_ts(output, &out))
+	if (!has_higher_opposing_ts(output, queue_first_packet(queue)))
 		return;
 
-	da_erase(output->interleaved_packets, 0);
+	circlebuf_pop_front(queue, &out, sizeof(out));
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1065,196 +1158,167 @@ static inline void set_higher_ts(struct obs_output *output,
 	}
 }
 
-static inline struct encoder_packet *find_first_packet_type(
-		struct obs_output *output, enum obs_encoder_type type,
-		size_t audio_idx);
-static int find_first_packet_type_idx(struct obs_output *output,
-		enum obs_encoder_type type, size_t audio_idx);
+static inline bool packet_same_slot(const struct encoder_packet *a,
+		const struct encoder_packet *b)
+{
+	return a->dts_usec == b->dts_usec && a->type == b->type;
+}
+
+/* discards every packet that comes before the given packet, and if inclusive,
+ * the packets of the same type and timestamp as well.  packets of the same
+ * type and timestamp are always kept or discarded together, whatever track
+ * they are on, so that the tracks stay aligned. */
+static void discard_packets(struct obs_output *output,
+		const struct encoder_packet *start, bool inclusive)
+{
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		struct encoder_packet *packet;
+
+		while ((packet = queue_first_packet(queue)) != NULL &&
+		       (packet_precedes(packet, start) ||
+		        (inclusive && packet_same_slot(packet, start)))) {
+			obs_encoder_packet_release(packet);
+			circlebuf_pop_front(queue, NULL, sizeof(*packet));
+		}
+	}
+}
 
 /* gets the point where audio and video are closest together */
-static size_t get_interleaved_start_idx(struct obs_output *output)
+static bool get_interleaved_start_packet(struct obs_output *output,
+		struct encoder_packet *start)
 {
 	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
-	struct encoder_packet *first_video = find_first_packet_type(output,
-			OBS_ENCODER_VIDEO, 0);
-	size_t video_idx = DARRAY_INVALID;
-	size_t idx = 0;
-
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		int64_t diff;
-
-		if (packet->type != OBS_ENCODER_AUDIO) {
-			if (packet == first_video)
-				video_idx = i;
-			continue;
-		}
+	struct encoder_packet *first_video;
+	struct encoder_packet *closest_audio = NULL;
+
+	first_video = queue_first_packet(
+			get_packet_queue(output, OBS_ENCODER_VIDEO, 0));
+	if (!first_video)
+		return false;
 
-		diff = llabs(packet->dts_usec - first_video->dts_usec);
-		if (diff < closest_diff) {
-			closest_diff = diff;
-			idx = i;
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		struct circlebuf *queue = get_packet_queue(output,
+				OBS_ENCODER_AUDIO, i);
+		size_t num = queue_num_packets(queue);
+
+		for (size_t j = 0; j < num; j++) {
+			struct encoder_packet *packet = queue_packet(queue, j);
+			int64_t diff;
+
+			diff = llabs(packet->dts_usec - first_video->dts_usec);
+			if (diff < closest_diff ||
+			    (closest_audio && diff == closest_diff &&
+			     packet_precedes(packet, closest_audio))) {
+				closest_diff = diff;
+				closest_audio = packet;
+			}
 		}
 	}
 
-	return video_idx < idx ? video_idx : idx;
+	if (!closest_audio)
+		return false;
+
+	*start = packet_precedes(first_video, closest_audio) ?
+		*first_video : *closest_audio;
+	return true;
 }
 
 static int prune_premature_packets(struct obs_output *output)
 {
 	size_t audio_mixes = num_audio_mixes(output);
 	struct encoder_packet *video;
-	int video_idx;
-	int max_idx;
+	struct encoder_packet *last;
 	int64_t duration_usec;
 	int64_t max_diff = 0;
 	int64_t diff = 0;
 
-	video_idx = find_first_packet_type_idx(output, OBS_ENCODER_VIDEO, 0);
-	if (video_idx == -1) {
+	video = queue_first_packet(
+			get_packet_queue(output, OBS_ENCODER_VIDEO, 0));
+	if (!video) {
 		output->received_video = false;
 		return -1;
 	}
 
-	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	last = video;
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < audio_mixes; i++) {
-		struct encoder_packet *audio;
-		int audio_idx;
-
-		audio_idx = find_first_packet_type_idx(output,
+		struct circlebuf *queue = get_packet_queue(output,
 				OBS_ENCODER_AUDIO, i);
-		if (audio_idx == -1) {
+		struct encoder_packet *audio = queue_first_packet(queue);
+
+		if (!audio) {
 			output->received_audio = false;
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
-		if (audio_idx > max_idx)
-			max_idx = audio_idx;
+		if (packet_precedes(last, audio))
+			last = audio;
 
 		diff = audio->dts_usec - video->dts_usec;
 		if (diff > max_diff)
 			max_diff = diff;
 	}
 
-	return diff > duration_usec ? max_idx + 1 : 0;
-}
+	if (diff <= duration_usec)
+		return 0;
 
-static void discard_to_idx(struct obs_output *output, size_t idx)
-{
-	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		obs_encoder_packet_release(packet);
-	}
+	/* discard everything up to and including the latest of the first
+	 * packets of each track */
+	struct encoder_packet prune_to = *last;
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+	discard_packets(output, &prune_to, true);
+	return 1;
 }
 
 #define DEBUG_STARTING_PACKETS 0
 
 static bool prune_interleaved_packets(struct obs_output *output)
 {
-	size_t start_idx = 0;
-	int prune_start = prune_premature_packets(output);
+	struct encoder_packet start;
+	int prune_start;
 
 #if DEBUG_STARTING_PACKETS == 1
-	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
-				packet->type == OBS_ENCODER_AUDIO ?
-				"audio" : "video", (int)packet->track_idx,
-				packet->dts_usec,
-				(int)i < prune_start ? "true" : "false");
+	blog(LOG_DEBUG, "--------- Pruning! ---------");
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		size_t num = queue_num_packets(queue);
+
+		for (size_t j = 0; j < num; j++) {
+			struct encoder_packet *packet = queue_packet(queue, j);
+			blog(LOG_DEBUG, "packet: %s %d, ts: %lld",
+					packet->type == OBS_ENCODER_AUDIO ?
+					"audio" : "video",
+					(int)packet->track_idx,
+					packet->dts_usec);
+		}
 	}
 #endif
 
 	/* prunes the first video packet if it's too far away from audio */
+	prune_start = prune_premature_packets(output);
 	if (prune_start == -1)
 		return false;
-	else if (prune_start != 0)
-		start_idx = (size_t)prune_start;
-	else
-		start_idx = get_interleaved_start_idx(output);
 
-	if (start_idx)
-		discard_to_idx(output, start_idx);
+	if (prune_start == 0 && get_interleaved_start_packet(output, &start))
+		discard_packets(output, &start, false);
 
 	return true;
 }
 
-static int find_first_packet_type_idx(struct obs_output *output,
-		enum obs_encoder_type type, size_t audio_idx)
-{
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-
-		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
-				continue;
-			}
-
-			return (int)i;
-		}
-	}
-
-	return -1;
-}
-
-static int find_last_packet_type_idx(struct obs_output *output,
-		enum obs_encoder_type type, size_t audio_idx)
-{
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i - 1];
-
-		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
-				continue;
-			}
-
-			return (int)(i - 1);
-		}
-	}
-
-	return -1;
-}
-
-static inline struct encoder_packet *find_first_packet_type(
-		struct obs_output *output, enum obs_encoder_type type,
-		size_t audio_idx)
-{
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
-
-static inline struct encoder_packet *find_last_packet_type(
-		struct obs_output *output, enum obs_encoder_type type,
-		size_t audio_idx)
-{
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
-
 static bool get_audio_and_video_packets(struct obs_output *output,
 		struct encoder_packet **video,
 		struct encoder_packet **audio, size_t audio_mixes)
 {
-	*video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
+	*video = queue_first_packet(
+			get_packet_queue(output, OBS_ENCODER_VIDEO, 0));
 	if (!*video)
 		output->received_video = false;
 
 	for (size_t i = 0; i < audio_mixes; i++) {
-		audio[i] = find_first_packet_type(output, OBS_ENCODER_AUDIO, i);
+		audio[i] = queue_first_packet(
+				get_packet_queue(output, OBS_ENCODER_AUDIO, i));
 		if (!audio[i]) {
 			output->received_audio = false;
 			return false;
@@ -1273,15 +1337,15 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	struct encoder_packet *video;
 	struct encoder_packet *audio[MAX_AUDIO_MIXES];
 	struct encoder_packet *last_audio[MAX_AUDIO_MIXES];
+	struct encoder_packet start;
 	size_t audio_mixes = num_audio_mixes(output);
-	size_t start_idx;
 
 	if (!get_audio_and_video_packets(output, &video, audio, audio_mixes))
 		return false;
 
 	for (size_t i = 0; i < audio_mixes; i++)
-		last_audio[i] = find_last_packet_type(output, OBS_ENCODER_AUDIO,
-				i);
+		last_audio[i] = queue_last_packet(
+				get_packet_queue(output, OBS_ENCODER_AUDIO, i));
 
 	/* ensure that there is audio past the first video packet */
 	for (size_t i = 0; i < audio_mixes; i++) {
@@ -1292,9 +1356,8 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	}
 
 	/* clear out excess starting audio if it hasn't been already */
-	start_idx = get_interleaved_start_idx(output);
-	if (start_idx) {
-		discard_to_idx(output, start_idx);
+	if (get_interleaved_start_packet(output, &start)) {
+		discard_packets(output, &start, false);
 		if (!get_audio_and_video_packets(output, &video, audio,
 					audio_mixes))
 			return false;
@@ -1319,11 +1382,15 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	output->highest_audio_ts -= audio[0]->dts_usec;
 	output->highest_video_ts -= video->dts_usec;
 
-	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		apply_interleaved_packet_offset(output, packet);
+	/* apply new offsets to all existing packet DTS/PTS values.  the offset
+	 * is the same for every packet of a track, so the queues stay sorted */
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		size_t num = queue_num_packets(queue);
+
+		for (size_t j = 0; j < num; j++)
+			apply_interleaved_packet_offset(output,
+					queue_packet(queue, j));
 	}
 
 	return true;
@@ -1332,51 +1399,24 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 static inline void insert_interleaved_packet(struct obs_output *output,
 		struct encoder_packet *out)
 {
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		if (out->dts_usec == cur_packet->dts_usec &&
-		    out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
-}
-
-static void resort_interleaved_packets(struct obs_output *output)
-{
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0,
-			sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++)
-		insert_interleaved_packet(output, &old_array.array[i]);
-
-	da_free(old_array);
+	struct circlebuf *queue = get_packet_queue(output, out->type,
+			out->track_idx);
+	circlebuf_push_back(queue, out, sizeof(*out));
 }
 
 static void discard_unused_audio_packets(struct obs_output *output,
 		int64_t dts_usec)
 {
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p =
-			&output->interleaved_packets.array[idx];
+	for (size_t i = 0; i < INTERLEAVED_TRACKS; i++) {
+		struct circlebuf *queue = &output->interleaved_packets[i];
+		struct encoder_packet *packet;
 
-		if (p->dts_usec >= dts_usec)
-			break;
+		while ((packet = queue_first_packet(queue)) != NULL &&
+		       packet->dts_usec < dts_usec) {
+			obs_encoder_packet_release(packet);
+			circlebuf_pop_front(queue, NULL, sizeof(*packet));
+		}
 	}
-
-	if (idx)
-		discard_to_idx(output, idx);
 }
 
 static void interleave_packets(void *data, struct encoder_packet *packet)
@@ -1410,7 +1450,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	if (output->active_delay_ns)
 		out = *packet;
 	else
-		obs_encoder_packet_create_instance(&out, packet);
+		obs_encoder_packet_ref(&out, packet);
 
 	if (was_started)
 		apply_interleaved_packet_offset(output, &out);
@@ -1426,7 +1466,6 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 		if (!was_started) {
 			if (prune_interleaved_packets(output)) {
 				if (initialize_interleaved_packets(output)) {
-					resort_interleaved_packets(output);
 					send_interleaved(output);
 				}
 			}
@@ -71,6 +71,8 @@ struct obs_output_info {
 	/* only used with encoded outputs, separated with semicolon */
 	const char *encoded_video_codecs;
 	const char *encoded_audio_codecs;
+
+	uint64_t (*get_total_send_calls)(void *data);
 };
 
 EXPORT void obs_register_output_s(const struct obs_output_info *info,
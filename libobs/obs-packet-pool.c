@@ -0,0 +1,179 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/*
+ *   Encoded packet payloads are refcounted buffers with the reference count
+ * stored directly before the packet data.  Payloads allocated here are
+ * additionally prefixed with their size class and are recycled through
+ * per-size-class free lists instead of going back to the allocator, so that
+ * steady-state encoding does not allocate at all.
+ */
+
+#define POOL_MIN_SIZE_SHIFT   8  /* 256 bytes */
+#define POOL_NUM_CLASSES      15 /* up to 4 megabytes */
+#define POOL_MAX_FREE_BLOCKS  32
+#define POOL_MAX_CLASS_BYTES  (16 * 1024 * 1024)
+#define POOL_UNPOOLED         -1L
+
+/* both members are longs so that there is no padding between the reference
+ * count and the packet data on any platform */
+struct packet_block {
+	long                            size_class;
+	long                            refs;
+};
+
+struct packet_pool_class {
+	DARRAY(struct packet_block*)    free_blocks;
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct packet_pool_class pool_classes[POOL_NUM_CLASSES];
+
+static volatile long pool_hits = 0;
+static volatile long pool_misses = 0;
+
+/* set once the cached blocks have been freed, blocks released afterwards go
+ * straight back to the allocator */
+static bool pool_shutdown = false;
+
+static inline size_t class_size(long size_class)
+{
+	return (size_t)1 << (size_class + POOL_MIN_SIZE_SHIFT);
+}
+
+static inline long get_size_class(size_t size)
+{
+	for (long i = 0; i < POOL_NUM_CLASSES; i++) {
+		if (size <= class_size(i))
+			return i;
+	}
+
+	return POOL_UNPOOLED;
+}
+
+static inline size_t max_free_blocks(long size_class)
+{
+	size_t max_blocks = POOL_MAX_CLASS_BYTES / class_size(size_class);
+	return max_blocks < POOL_MAX_FREE_BLOCKS ?
+		max_blocks : POOL_MAX_FREE_BLOCKS;
+}
+
+static struct packet_block *pop_free_block(long size_class)
+{
+	struct packet_pool_class *pc = &pool_classes[size_class];
+	struct packet_block *block = NULL;
+
+	pthread_mutex_lock(&pool_mutex);
+	if (pc->free_blocks.num) {
+		block = pc->free_blocks.array[pc->free_blocks.num - 1];
+		da_pop_back(pc->free_blocks);
+	}
+	pthread_mutex_unlock(&pool_mutex);
+
+	return block;
+}
+
+static const char *pool_alloc_miss_name = "packet_pool_alloc(miss)";
+
+uint8_t *obs_packet_pool_alloc(size_t size)
+{
+	long size_class = get_size_class(size);
+	struct packet_block *block = NULL;
+
+	if (size_class != POOL_UNPOOLED)
+		block = pop_free_block(size_class);
+
+	if (block) {
+		os_atomic_inc_long(&pool_hits);
+	} else {
+		size_t alloc_size = size_class == POOL_UNPOOLED ?
+			size : class_size(size_class);
+
+		profile_start(pool_alloc_miss_name);
+		block = bmalloc(sizeof(*block) + alloc_size);
+		block->size_class = size_class;
+		profile_end(pool_alloc_miss_name);
+
+		os_atomic_inc_long(&pool_misses);
+	}
+
+	block->refs = 1 | OBS_PACKET_POOL_FLAG;
+	return (uint8_t*)(block + 1);
+}
+
+void obs_packet_pool_free(long *p_refs)
+{
+	struct packet_block *block = (struct packet_block*)(p_refs - 1);
+	long size_class = block->size_class;
+	bool cached = false;
+
+	if (size_class != POOL_UNPOOLED) {
+		struct packet_pool_class *pc = &pool_classes[size_class];
+
+		pthread_mutex_lock(&pool_mutex);
+		if (!pool_shutdown &&
+		    pc->free_blocks.num < max_free_blocks(size_class)) {
+			da_push_back(pc->free_blocks, &block);
+			cached = true;
+		}
+		pthread_mutex_unlock(&pool_mutex);
+	}
+
+	if (!cached)
+		bfree(block);
+}
+
+void obs_packet_pool_init(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	pool_shutdown = false;
+	pthread_mutex_unlock(&pool_mutex);
+
+	os_atomic_set_long(&pool_hits, 0);
+	os_atomic_set_long(&pool_misses, 0);
+}
+
+void obs_packet_pool_shutdown(void)
+{
+	long hits = os_atomic_load_long(&pool_hits);
+	long misses = os_atomic_load_long(&pool_misses);
+
+	pthread_mutex_lock(&pool_mutex);
+	pool_shutdown = true;
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		struct packet_pool_class *pc = &pool_classes[i];
+
+		for (size_t j = 0; j < pc->free_blocks.num; j++)
+			bfree(pc->free_blocks.array[j]);
+		da_free(pc->free_blocks);
+	}
+	pthread_mutex_unlock(&pool_mutex);
+
+	if (hits || misses)
+		blog(LOG_INFO, "Encoder packet pool: %ld hits, %ld misses",
+				hits, misses);
+}
+
+void obs_get_packet_pool_stats(long *hits, long *misses)
+{
+	if (hits)
+		*hits = os_atomic_load_long(&pool_hits);
+	if (misses)
+		*misses = os_atomic_load_long(&pool_misses);
+}
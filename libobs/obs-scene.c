@@ -18,6 +18,7 @@
 
 #include "util/threading.h"
 #include "graphics/math-defs.h"
+#include "media-io/audio-math.h"
 #include "obs-scene.h"
 
 /* NOTE: For proper mutex lock order (preventing mutual cross-locks), never
@@ -64,7 +65,7 @@ static const char *scene_getname(void *unused)
 static void *scene_create(obs_data_t *settings, struct obs_source *source)
 {
 	pthread_mutexattr_t attr;
-	struct obs_scene *scene = bmalloc(sizeof(struct obs_scene));
+	struct obs_scene *scene = bzalloc(sizeof(struct obs_scene));
 	scene->source     = source;
 	scene->first_item = NULL;
 
@@ -151,12 +152,27 @@ static void remove_all_items(struct obs_scene *scene)
 	da_free(items);
 }
 
+static void free_cache_layers(struct obs_scene *scene, size_t first)
+{
+	for (size_t i = first; i < SCENE_CACHE_MAX_LAYERS; i++) {
+		struct scene_cache_layer *layer = &scene->cache_layers[i];
+
+		gs_texrender_destroy(layer->texrender);
+		layer->texrender = NULL;
+		layer->key = 0;
+	}
+}
+
 static void scene_destroy(void *data)
 {
 	struct obs_scene *scene = data;
 
 	remove_all_items(scene);
 
+	obs_enter_graphics();
+	free_cache_layers(scene, 0);
+	obs_leave_graphics();
+
 	pthread_mutex_destroy(&scene->video_mutex);
 	pthread_mutex_destroy(&scene->audio_mutex);
 	bfree(scene);
@@ -504,6 +520,213 @@ static inline void render_item(struct obs_scene_item *item)
 	gs_matrix_pop();
 }
 
+/* ------------------------------------------------------------------------- */
+/* composite cache
+ *
+ *   Consecutive visible items whose sources only change on update (see
+ * OBS_SOURCE_STATIC_VIDEO) and which have not changed for a while are
+ * rendered once into a cached layer, which is then drawn with a single quad
+ * every frame until one of the items changes.  Non-static items in between
+ * split the cached items into separate layers so draw order is kept. */
+
+/* ticks an item must stay unchanged before it is cached */
+#define CACHE_MIN_STATIC_FRAMES 30
+
+#define CACHE_HASH_INIT  0xcbf29ce484222325ULL
+#define CACHE_HASH_PRIME 0x100000001b3ULL
+
+static inline uint64_t cache_hash(uint64_t hash, const void *data,
+		size_t size)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= CACHE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static uint64_t item_cache_sig(const struct obs_scene_item *item)
+{
+	long generation = os_atomic_load_long(&item->source->video_generation);
+	uint64_t sig = CACHE_HASH_INIT;
+
+	sig = cache_hash(sig, &item->id, sizeof(item->id));
+	sig = cache_hash(sig, &generation, sizeof(generation));
+	sig = cache_hash(sig, &item->draw_transform,
+			sizeof(item->draw_transform));
+	sig = cache_hash(sig, &item->crop, sizeof(item->crop));
+	sig = cache_hash(sig, &item->scale_filter, sizeof(item->scale_filter));
+	sig = cache_hash(sig, &item->last_width, sizeof(item->last_width));
+	sig = cache_hash(sig, &item->last_height, sizeof(item->last_height));
+	return sig;
+}
+
+static bool source_video_static(obs_source_t *source)
+{
+	uint32_t flags = source->info.output_flags;
+	bool is_static = true;
+
+	if ((flags & OBS_SOURCE_STATIC_VIDEO) == 0 ||
+	    (flags & (OBS_SOURCE_ASYNC | OBS_SOURCE_COMPOSITE)) != 0)
+		return false;
+
+	pthread_mutex_lock(&source->filter_mutex);
+
+	for (size_t i = 0; i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+
+		if (filter->enabled &&
+		    (filter->info.output_flags & OBS_SOURCE_STATIC_VIDEO) == 0) {
+			is_static = false;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&source->filter_mutex);
+	return is_static;
+}
+
+static void update_item_cache_state(struct obs_scene_item *item)
+{
+	uint64_t sig;
+
+	if (!item->user_visible || !source_video_static(item->source)) {
+		item->static_frames = 0;
+		return;
+	}
+
+	sig = item_cache_sig(item);
+	if (sig != item->cache_sig) {
+		item->cache_sig = sig;
+		item->static_frames = 0;
+
+	} else if (item->static_frames < CACHE_MIN_STATIC_FRAMES) {
+		item->static_frames++;
+	}
+}
+
+static inline bool item_cacheable(const struct obs_scene_item *item)
+{
+	return item->static_frames >= CACHE_MIN_STATIC_FRAMES &&
+		item_cache_sig(item) == item->cache_sig;
+}
+
+static void render_cache_layer(struct scene_cache_layer *layer, uint64_t key,
+		struct obs_scene_item *first, struct obs_scene_item *last)
+{
+	uint32_t cx = obs->video.base_width;
+	uint32_t cy = obs->video.base_height;
+	gs_effect_t *effect = obs->video.default_effect;
+	gs_texture_t *tex;
+
+	if (!layer->texrender)
+		layer->texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	key = cache_hash(key, &cx, sizeof(cx));
+	key = cache_hash(key, &cy, sizeof(cy));
+
+	if (layer->key != key) {
+		gs_texrender_reset(layer->texrender);
+
+		if (gs_texrender_begin(layer->texrender, cx, cy)) {
+			struct obs_scene_item *item = first;
+			struct vec4 clear_color;
+
+			vec4_zero(&clear_color);
+			gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+			gs_ortho(0.0f, (float)cx, 0.0f, (float)cy,
+					-100.0f, 100.0f);
+
+			/* accumulate premultiplied color so the layer can be
+			 * drawn over the target like the items would be */
+			gs_blend_state_push();
+			gs_blend_function_separate(
+					GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA,
+					GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+			while (item) {
+				if (item->user_visible)
+					render_item(item);
+				if (item == last)
+					break;
+				item = item->next;
+			}
+
+			gs_blend_state_pop();
+			gs_texrender_end(layer->texrender);
+			layer->key = key;
+		} else {
+			layer->key = 0;
+		}
+	}
+
+	tex = gs_texrender_get_texture(layer->texrender);
+	if (!tex)
+		return;
+
+	gs_blend_state_push();
+	gs_blend_function_separate(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA,
+			GS_BLEND_ONE, GS_BLEND_ONE);
+
+	while (gs_effect_loop(effect, "Draw"))
+		obs_source_draw(tex, 0, 0, 0, 0, false);
+
+	gs_blend_state_pop();
+}
+
+struct cache_run {
+	struct obs_scene_item *first;
+	struct obs_scene_item *last;
+	size_t                count;
+	uint64_t              key;
+};
+
+static void flush_cache_run(struct obs_scene *scene, struct cache_run *run,
+		size_t *layers_used)
+{
+	struct obs_scene_item *item = run->first;
+
+	if (!run->count)
+		return;
+
+	/* a single item is cheaper to draw directly than through a layer */
+	if (run->count > 1 && *layers_used < SCENE_CACHE_MAX_LAYERS) {
+		struct scene_cache_layer *layer =
+			&scene->cache_layers[(*layers_used)++];
+		render_cache_layer(layer, run->key, run->first, run->last);
+
+	} else {
+		while (item) {
+			if (item->user_visible)
+				render_item(item);
+			if (item == run->last)
+				break;
+			item = item->next;
+		}
+	}
+
+	memset(run, 0, sizeof(*run));
+}
+
+static inline void add_to_cache_run(struct cache_run *run,
+		struct obs_scene_item *item)
+{
+	if (!run->count) {
+		run->first = item;
+		run->key = CACHE_HASH_INIT;
+	}
+
+	run->last = item;
+	run->key = cache_hash(run->key, &item->cache_sig,
+			sizeof(item->cache_sig));
+	run->count++;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void scene_video_tick(void *data, float seconds)
 {
 	struct obs_scene *scene = data;
@@ -514,6 +737,8 @@ static void scene_video_tick(void *data, float seconds)
 	while (item) {
 		if (item->item_render)
 			gs_texrender_reset(item->item_render);
+		if (scene->composite_cache)
+			update_item_cache_state(item);
 		item = item->next;
 	}
 	video_unlock(scene);
@@ -526,6 +751,8 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 	DARRAY(struct obs_scene_item*) remove_items;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
+	struct cache_run run = {0};
+	size_t layers_used = 0;
 
 	da_init(remove_items);
 
@@ -548,12 +775,24 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 		if (source_size_changed(item))
 			update_item_transform(item);
 
-		if (item->user_visible)
+		if (!item->user_visible) {
+			item = item->next;
+			continue;
+		}
+
+		if (scene->composite_cache && item_cacheable(item)) {
+			add_to_cache_run(&run, item);
+		} else {
+			flush_cache_run(scene, &run, &layers_used);
 			render_item(item);
+		}
 
 		item = item->next;
 	}
 
+	flush_cache_run(scene, &run, &layers_used);
+	free_cache_layers(scene, layers_used);
+
 	gs_blend_state_pop();
 
 	video_unlock(scene);
@@ -697,6 +936,9 @@ static void scene_load(void *data, obs_data_t *settings)
 	if (obs_data_has_user_value(settings, "id_counter"))
 		scene->id_counter = obs_data_get_int(settings, "id_counter");
 
+	obs_scene_set_composite_cache(scene,
+			obs_data_get_bool(settings, "composite_cache"));
+
 	obs_data_array_release(items);
 }
 
@@ -758,6 +1000,7 @@ static void scene_save(void *data, obs_data_t *settings)
 	}
 
 	obs_data_set_int(settings, "id_counter", scene->id_counter);
+	obs_data_set_bool(settings, "composite_cache", scene->composite_cache);
 
 	full_unlock(scene);
 
@@ -870,28 +1113,6 @@ static void process_all_audio_actions(struct obs_scene_item *item,
 	while (apply_scene_item_volume(item, NULL, 0, sample_rate));
 }
 
-static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
-		size_t pos, size_t count)
-{
-	register float *out = p_out;
-	register float *buf = buf_in + pos;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++) * *(buf++);
-}
-
-static inline void mix_audio(float *p_out, float *p_in,
-		size_t pos, size_t count)
-{
-	register float *out = p_out;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
-}
 
 static bool scene_audio_render(void *data, uint64_t *ts_out,
 		struct obs_source_audio_mix *audio_output, uint32_t mixers,
@@ -899,7 +1120,7 @@ static bool scene_audio_render(void *data, uint64_t *ts_out,
 {
 	uint64_t timestamp = 0;
 	float *buf = NULL;
-	struct obs_source_audio_mix child_audio;
+	float gain;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
 
@@ -960,20 +1181,27 @@ static bool scene_audio_render(void *data, uint64_t *ts_out,
 			continue;
 		}
 
-		obs_source_get_audio_mix(item->source, &child_audio);
+		/* silent mixes of the child are skipped, and its volume
+		 * is applied while mixing */
+		gain = item->source->audio_output_gain;
 		for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
 			if ((mixers & (1 << mix)) == 0)
 				continue;
 
 			for (size_t ch = 0; ch < channels; ch++) {
 				float *out = audio_output->output[mix].data[ch];
-				float *in = child_audio.output[mix].data[ch];
+				const float *in = obs_source_audio_output(
+						item->source, mix, ch);
+
+				if (!in)
+					break;
 
 				if (apply_buf)
-					mix_audio_with_buf(out, in, buf, pos,
-							count);
+					audio_mix_add_vol(out, in + pos,
+							buf + pos, gain, count);
 				else
-					mix_audio(out, in, pos, count);
+					audio_mix_add_gain(out, in + pos, gain,
+							count);
 			}
 		}
 
@@ -1095,6 +1323,8 @@ obs_scene_t *obs_scene_duplicate(obs_scene_t *scene, const char *name,
 	new_scene = make_private ?
 		obs_scene_create_private(name) : obs_scene_create(name);
 
+	obs_scene_set_composite_cache(new_scene, scene->composite_cache);
+
 	obs_source_copy_filters(new_scene->source, scene->source);
 
 	obs_data_apply(new_scene->source->private_settings,
@@ -1182,6 +1412,32 @@ obs_scene_t *obs_scene_from_source(const obs_source_t *source)
 	return source->context.data;
 }
 
+void obs_scene_set_composite_cache(obs_scene_t *scene, bool enable)
+{
+	struct obs_scene_item *item;
+
+	if (!obs_ptr_valid(scene, "obs_scene_set_composite_cache"))
+		return;
+
+	video_lock(scene);
+
+	scene->composite_cache = enable;
+
+	item = scene->first_item;
+	while (item) {
+		item->static_frames = 0;
+		item = item->next;
+	}
+
+	video_unlock(scene);
+}
+
+bool obs_scene_composite_cache_enabled(const obs_scene_t *scene)
+{
+	return obs_ptr_valid(scene, "obs_scene_composite_cache_enabled") ?
+		scene->composite_cache : false;
+}
+
 obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene, const char *name)
 {
 	struct obs_scene_item *item;
@@ -28,6 +28,14 @@ struct item_action {
 	uint64_t timestamp;
 };
 
+/* max number of cached layers of static items per scene */
+#define SCENE_CACHE_MAX_LAYERS 4
+
+struct scene_cache_layer {
+	gs_texrender_t        *texrender;
+	uint64_t              key;
+};
+
 struct obs_scene_item {
 	volatile long         ref;
 	volatile bool         removed;
@@ -70,6 +78,11 @@ struct obs_scene_item {
 
 	obs_data_t            *private_settings;
 
+	/* composite cache state: signature of everything that affects how
+	 * the item is drawn, and the number of ticks it has been unchanged */
+	uint64_t              cache_sig;
+	uint32_t              static_frames;
+
 	pthread_mutex_t       actions_mutex;
 	DARRAY(struct item_action) audio_actions;
 
@@ -86,4 +99,7 @@ struct obs_scene {
 	pthread_mutex_t       video_mutex;
 	pthread_mutex_t       audio_mutex;
 	struct obs_scene_item *first_item;
+
+	bool                  composite_cache;
+	struct scene_cache_layer cache_layers[SCENE_CACHE_MAX_LAYERS];
 };
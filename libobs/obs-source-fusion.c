@@ -0,0 +1,297 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "util/dstr.h"
+#include "obs-internal.h"
+
+/*
+ *   Runs of consecutive per-pixel filters are drawn with a single generated
+ * effect: the target of the last filter of the run is rendered once, and the
+ * code of each filter is applied to the pixel in turn, instead of every
+ * filter rendering the previous one to a texture.
+ */
+
+#define MAX_FUSED_FILTERS 8
+
+struct fused_run {
+	obs_source_t *filters[MAX_FUSED_FILTERS];
+	const char   *code[MAX_FUSED_FILTERS];
+	size_t       num;
+
+	/* the last filter samples the target itself */
+	bool         sample;
+
+	/* what the last filter of the run is applied to */
+	obs_source_t *target;
+};
+
+static const char *fused_effect_head =
+"uniform float4x4 ViewProj;\n"
+"uniform texture2d image;\n"
+"\n"
+"sampler_state fused_sampler {\n"
+"	Filter   = Linear;\n"
+"	AddressU = Clamp;\n"
+"	AddressV = Clamp;\n"
+"};\n"
+"\n"
+"struct VertData {\n"
+"	float4 pos : POSITION;\n"
+"	float2 uv  : TEXCOORD0;\n"
+"};\n"
+"\n"
+"VertData VSDefault(VertData v_in)\n"
+"{\n"
+"	VertData vert_out;\n"
+"	vert_out.pos = mul(float4(v_in.pos.xyz, 1.0), ViewProj);\n"
+"	vert_out.uv  = v_in.uv;\n"
+"	return vert_out;\n"
+"}\n"
+"\n";
+
+static const char *fused_effect_tail =
+"	return rgba;\n"
+"}\n"
+"\n"
+"technique Draw\n"
+"{\n"
+"	pass\n"
+"	{\n"
+"		vertex_shader = VSDefault(v_in);\n"
+"		pixel_shader  = PSFused(v_in);\n"
+"	}\n"
+"}\n";
+
+static inline void get_prefix(char *prefix, size_t size, size_t idx)
+{
+	snprintf(prefix, size, "f%u_", (unsigned int)idx);
+}
+
+/* filters that are disabled or that do not render video only render their
+ * target, so they do not break a run */
+static inline bool filter_transparent(const obs_source_t *filter)
+{
+	return !filter->enabled || !filter->context.data ||
+		!filter->info.video_render;
+}
+
+static inline const char *get_fused_code(obs_source_t *filter)
+{
+	if (!filter->info.get_fused_code || !filter->info.fused_render)
+		return NULL;
+
+	return filter->info.get_fused_code(filter->context.data);
+}
+
+static void get_fused_run(obs_source_t *filter, struct fused_run *run)
+{
+	obs_source_t *parent = filter->filter_parent;
+	obs_source_t *cur = filter;
+
+	run->num = 0;
+	run->sample = false;
+
+	while (cur && cur != parent && run->num < MAX_FUSED_FILTERS) {
+		const char *code;
+
+		if (filter_transparent(cur)) {
+			cur = cur->filter_target;
+			continue;
+		}
+
+		code = get_fused_code(cur);
+		if (!code)
+			break;
+
+		run->filters[run->num] = cur;
+		run->code[run->num++] = code;
+		cur = cur->filter_target;
+
+		if (strstr(code, "$sample(")) {
+			run->sample = true;
+			break;
+		}
+	}
+
+	run->target = cur;
+}
+
+/* keys are the ids of the filters of the run, each followed by ';' */
+static bool key_matches(const char *key, const struct fused_run *run)
+{
+	for (size_t i = 0; i < run->num; i++) {
+		const char *id = run->filters[i]->info.id;
+		size_t len = strlen(id);
+
+		if (strncmp(key, id, len) != 0 || key[len] != ';')
+			return false;
+
+		key += len + 1;
+	}
+
+	return *key == 0;
+}
+
+static void build_fused_code(struct dstr *code, const struct fused_run *run)
+{
+	struct dstr stage = {0};
+	char prefix[16];
+
+	dstr_copy(code, fused_effect_head);
+
+	for (size_t i = run->num; i > 0; i--) {
+		get_prefix(prefix, sizeof(prefix), i - 1);
+
+		dstr_copy(&stage, run->code[i - 1]);
+		dstr_replace(&stage, "$", prefix);
+		dstr_cat_dstr(code, &stage);
+		dstr_cat(code, "\n\n");
+	}
+
+	dstr_cat(code, "float4 PSFused(VertData v_in) : TARGET\n{\n");
+
+	/* filters are applied from the last one to the first one */
+	for (size_t i = run->num; i > 0; i--) {
+		get_prefix(prefix, sizeof(prefix), i - 1);
+
+		if (i == run->num && run->sample)
+			dstr_catf(code, "\tfloat4 rgba = %ssample(v_in.uv);\n",
+					prefix);
+		else if (i == run->num)
+			dstr_cat(code, "\tfloat4 rgba = "
+					"image.Sample(fused_sampler, "
+					"v_in.uv);\n\trgba = ");
+		else
+			dstr_cat(code, "\trgba = ");
+
+		if (i != run->num || !run->sample)
+			dstr_catf(code, "%scolor(rgba);\n", prefix);
+	}
+
+	dstr_cat(code, fused_effect_tail);
+	dstr_free(&stage);
+}
+
+static gs_effect_t *get_fused_effect(const struct fused_run *run)
+{
+	struct obs_core_video *video = &obs->video;
+	struct fused_effect fused = {0};
+	struct dstr key = {0};
+	struct dstr code = {0};
+	char *errors = NULL;
+
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		struct fused_effect *cached = video->fused_effects.array + i;
+		if (key_matches(cached->key, run))
+			return cached->effect;
+	}
+
+	for (size_t i = 0; i < run->num; i++)
+		dstr_catf(&key, "%s;", run->filters[i]->info.id);
+
+	build_fused_code(&code, run);
+
+	fused.key = key.array;
+	fused.effect = gs_effect_create(code.array, NULL, &errors);
+
+	/* failures are cached as well, so the filters of the run just keep
+	 * being rendered on their own */
+	if (!fused.effect)
+		blog(LOG_WARNING, "Failed to create fused filter effect for "
+				"'%s', filters will be rendered separately:\n"
+				"%s", key.array, errors ? errors : "");
+
+	da_push_back(video->fused_effects, &fused);
+
+	bfree(errors);
+	dstr_free(&code);
+	return fused.effect;
+}
+
+bool fused_filters_render(obs_source_t *filter)
+{
+	struct fused_run run;
+	gs_effect_t *effect;
+	char prefix[16];
+
+	if (!obs->video.filter_fusion)
+		return false;
+
+	get_fused_run(filter, &run);
+	if (run.num < 2 || !run.target)
+		return false;
+
+	effect = get_fused_effect(&run);
+	if (!effect)
+		return false;
+
+	/* sampling filters can transform coordinates, so their target is
+	 * never drawn directly with the fused effect */
+	if (!filter_render_target(filter, run.target, GS_RGBA,
+				run.sample ? OBS_NO_DIRECT_RENDERING :
+				OBS_ALLOW_DIRECT_RENDERING))
+		return true;
+
+	for (size_t i = 0; i < run.num; i++) {
+		obs_source_t *cur = run.filters[i];
+
+		get_prefix(prefix, sizeof(prefix), i);
+		cur->info.fused_render(cur->context.data, effect, prefix);
+	}
+
+	filter_draw_effect(filter, run.target, effect,
+			obs_source_get_width(filter),
+			obs_source_get_height(filter), "Draw");
+	return true;
+}
+
+void fused_effects_free(struct obs_core_video *video)
+{
+	for (size_t i = 0; i < video->fused_effects.num; i++) {
+		struct fused_effect *fused = video->fused_effects.array + i;
+
+		gs_effect_destroy(fused->effect);
+		bfree(fused->key);
+	}
+
+	da_free(video->fused_effects);
+}
+
+void obs_set_filter_fusion(bool enable)
+{
+	if (!obs)
+		return;
+
+	obs->video.filter_fusion = enable;
+}
+
+bool obs_filter_fusion_enabled(void)
+{
+	return obs ? obs->video.filter_fusion : false;
+}
+
+gs_eparam_t *obs_fused_effect_get_param(gs_effect_t *effect,
+		const char *prefix, const char *name)
+{
+	char full_name[128];
+
+	if (!obs_ptr_valid(effect, "obs_fused_effect_get_param"))
+		return NULL;
+
+	snprintf(full_name, sizeof(full_name), "%s%s", prefix, name);
+	return gs_effect_get_param_by_name(effect, full_name);
+}
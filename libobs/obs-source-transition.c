@@ -15,6 +15,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include "media-io/audio-math.h"
 #include "obs-internal.h"
 
 #define lock_transition(transition) \
@@ -814,15 +815,15 @@ static inline float get_sample_time(obs_source_t *transition,
 	return calc_time(transition, i_ts);
 }
 
-static inline void mix_child(obs_source_t *transition, float *out, float *in,
-		size_t count, size_t sample_rate, uint64_t ts,
-		obs_transition_audio_mix_callback_t mix)
+static inline void mix_child(obs_source_t *transition, float *out,
+		const float *in, float gain, size_t count, size_t sample_rate,
+		uint64_t ts, obs_transition_audio_mix_callback_t mix)
 {
 	void *context_data = transition->context.data;
 
 	for (size_t i = 0; i < count; i++) {
 		float t = get_sample_time(transition, sample_rate, i, ts);
-		out[i] += in[i] * mix(context_data, t);
+		out[i] += in[i] * gain * mix(context_data, t);
 	}
 }
 
@@ -832,7 +833,6 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 		obs_transition_audio_mix_callback_t mix)
 {
 	bool valid = child && !child->audio_pending;
-	struct obs_source_audio_mix child_audio;
 	uint64_t ts;
 	size_t pos;
 
@@ -840,7 +840,6 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 		return;
 
 	ts = child->audio_ts;
-	obs_source_get_audio_mix(child, &child_audio);
 	pos = (size_t)ns_to_audio_frames(sample_rate, ts - min_ts);
 
 	if (pos > AUDIO_OUTPUT_FRAMES)
@@ -848,22 +847,49 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_output_data *output = &audio->output[mix_idx];
-		struct audio_output_data *input = &child_audio.output[mix_idx];
 
 		if ((mixers & (1 << mix_idx)) == 0)
 			continue;
 
 		for (size_t ch = 0; ch < channels; ch++) {
 			float *out = output->data[ch];
-			float *in = input->data[ch];
+			const float *in = obs_source_audio_output(child,
+					mix_idx, ch);
+
+			if (!in)
+				break;
 
 			mix_child(transition, out + pos, in,
+					child->audio_output_gain,
 					AUDIO_OUTPUT_FRAMES - pos,
 					sample_rate, ts, mix);
 		}
 	}
 }
 
+static void copy_audio(obs_source_t *child, struct obs_source_audio_mix *audio,
+		uint32_t mixers, size_t channels)
+{
+	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+		if ((mixers & (1 << mix_idx)) == 0)
+			continue;
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *out = audio->output[mix_idx].data[ch];
+			const float *in = obs_source_audio_output(child,
+					mix_idx, ch);
+
+			if (in)
+				audio_copy_gain(out, in,
+						child->audio_output_gain,
+						AUDIO_OUTPUT_FRAMES);
+			else
+				memset(out, 0, AUDIO_OUTPUT_FRAMES *
+						sizeof(float));
+		}
+	}
+}
+
 static inline uint64_t calc_min_ts(obs_source_t *sources[2])
 {
 	uint64_t min_ts = 0;
@@ -941,9 +967,7 @@ bool obs_transition_audio_render(obs_source_t *transition,
 						min_ts, mixers, channels,
 						sample_rate, mix_b);
 		} else if (state.s[0]) {
-			memcpy(audio->output[0].data[0],
-					state.s[0]->audio_output_buf[0][0],
-					TOTAL_AUDIO_SIZE);
+			copy_audio(state.s[0], audio, mixers, channels);
 		}
 
 		obs_source_release(state.s[0]);
@@ -20,6 +20,7 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-math.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "callback/calldata.h"
@@ -175,6 +176,7 @@ bool obs_source_init(struct obs_source *source)
 	source->deinterlace_top_first = true;
 	source->control->source = source;
 	source->audio_mixers = 0xFF;
+	source->audio_output_gain = 1.0f;
 
 	if (is_audio_source(source)) {
 		pthread_mutex_lock(&obs->data.audio_sources_mutex);
@@ -504,6 +506,8 @@ static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 
 static bool obs_source_filter_remove_refless(obs_source_t *source,
 		obs_source_t *filter);
+static void audio_cb_lists_stop(obs_source_t *source);
+static void audio_cb_lists_free(obs_source_t *source);
 
 void obs_source_destroy(struct obs_source *source)
 {
@@ -536,6 +540,10 @@ void obs_source_destroy(struct obs_source *source)
 			source->context.private ? "private " : "",
 			source->context.name);
 
+	/* asynchronous audio capture callbacks could otherwise still be
+	 * called with a source that is partly destroyed */
+	audio_cb_lists_stop(source);
+
 	obs_source_dosignal(source, "source_destroy", "destroy");
 
 	if (source->context.data) {
@@ -571,6 +579,7 @@ void obs_source_destroy(struct obs_source *source)
 		circlebuf_free(&source->audio_input_buf[i]);
 	audio_resampler_destroy(source->resampler);
 	bfree(source->audio_output_buf[0][0]);
+	bfree(source->audio_mix_buf);
 
 	obs_source_frame_destroy(source->async_preload_frame);
 
@@ -578,7 +587,7 @@ void obs_source_destroy(struct obs_source *source)
 		obs_transition_free(source);
 
 	da_free(source->audio_actions);
-	da_free(source->audio_cb_list);
+	audio_cb_lists_free(source);
 	da_free(source->async_cache);
 	da_free(source->async_frames);
 	da_free(source->filters);
@@ -786,6 +795,7 @@ static void obs_source_deferred_update(obs_source_t *source)
 				source->context.settings);
 
 	source->defer_update = false;
+	obs_source_video_changed(source);
 }
 
 void obs_source_update(obs_source_t *source, obs_data_t *settings)
@@ -804,6 +814,18 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 	}
 }
 
+void obs_source_video_changed(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_video_changed"))
+		return;
+
+	os_atomic_inc_long(&source->video_generation);
+
+	/* filters are cached as part of the source they are attached to */
+	if (source->filter_parent)
+		os_atomic_inc_long(&source->filter_parent->video_generation);
+}
+
 void obs_source_update_properties(obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_update_properties"))
@@ -1009,13 +1031,12 @@ static void async_tick(obs_source_t *source)
 				source->cur_async_frame);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+/* updates the per-frame state of the source, and returns whether the source
+ * has a tick callback that still needs to be called */
+bool obs_source_video_tick_state(obs_source_t *source)
 {
 	bool now_showing, now_active;
 
-	if (!obs_source_valid(source, "obs_source_video_tick"))
-		return;
-
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source);
 
@@ -1053,11 +1074,36 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
-		source->info.video_tick(source->context.data, seconds);
-
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
+
+	return source->context.data && source->info.video_tick;
+}
+
+/* may be called from a tick worker thread for sources with the
+ * OBS_SOURCE_PARALLEL_TICK flag */
+void obs_source_video_tick_callback(obs_source_t *source, float seconds)
+{
+	const char *name = source->tick_profile_name;
+
+	if (!name) {
+		name = profile_store_name(obs_get_profiler_name_store(),
+				"video_tick(%s)", source->context.name);
+		source->tick_profile_name = name;
+	}
+
+	profile_start(name);
+	source->info.video_tick(source->context.data, seconds);
+	profile_end(name);
+}
+
+void obs_source_video_tick(obs_source_t *source, float seconds)
+{
+	if (!obs_source_valid(source, "obs_source_video_tick"))
+		return;
+
+	if (obs_source_video_tick_state(source))
+		obs_source_video_tick_callback(source, seconds);
 }
 
 /* unless the value is 3+ hours worth of frames, this won't overflow */
@@ -1115,17 +1161,37 @@ static void handle_ts_jump(obs_source_t *source, uint64_t expected,
 	pthread_mutex_unlock(&source->audio_buf_mutex);
 }
 
+static void audio_cb_async_push(struct audio_cb_async *async,
+		const struct audio_data *in, bool muted);
+
 static void source_signal_audio_data(obs_source_t *source,
 		const struct audio_data *in, bool muted)
 {
-	pthread_mutex_lock(&source->audio_cb_mutex);
+	long idx;
+
+	/* the list may only be read if it is still current after marking
+	 * ourselves as a reader of it, otherwise it could be modified */
+	for (;;) {
+		idx = os_atomic_load_long(&source->audio_cb_cur);
+		os_atomic_inc_long(&source->audio_cb_readers[idx]);
+
+		if (os_atomic_load_long(&source->audio_cb_cur) == idx)
+			break;
 
-	for (size_t i = source->audio_cb_list.num; i > 0; i--) {
-		struct audio_cb_info info = source->audio_cb_list.array[i - 1];
-		info.callback(info.param, source, in, muted);
+		os_atomic_dec_long(&source->audio_cb_readers[idx]);
 	}
 
-	pthread_mutex_unlock(&source->audio_cb_mutex);
+	for (size_t i = source->audio_cb_lists[idx].num; i > 0; i--) {
+		struct audio_cb_info info =
+			source->audio_cb_lists[idx].array[i - 1];
+
+		if (info.async)
+			audio_cb_async_push(info.async, in, muted);
+		else
+			info.callback(info.param, source, in, muted);
+	}
+
+	os_atomic_dec_long(&source->audio_cb_readers[idx]);
 }
 
 static inline uint64_t uint64_diff(uint64_t ts1, uint64_t ts2)
@@ -1510,17 +1576,20 @@ static const char *select_conversion_technique(enum video_format format)
 	return NULL;
 }
 
-static inline void set_eparam(gs_effect_t *effect, const char *name, float val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_float(param, val);
-}
+/* each call site keeps its own parameter cache */
+#define set_eparam(effect, name, val) \
+	do { \
+		static struct gs_eparam_cache cache = {0}; \
+		gs_effect_set_float(gs_effect_get_param_cached(effect, name, \
+					&cache), val); \
+	} while (false)
 
-static inline void set_eparami(gs_effect_t *effect, const char *name, int val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_int(param, val);
-}
+#define set_eparami(effect, name, val) \
+	do { \
+		static struct gs_eparam_cache cache = {0}; \
+		gs_effect_set_int(gs_effect_get_param_cached(effect, name, \
+					&cache), val); \
+	} while (false)
 
 static bool update_async_texrender(struct obs_source *source,
 		const struct obs_source_frame *frame,
@@ -1781,6 +1850,9 @@ static inline void render_video(obs_source_t *source)
 		return;
 	}
 
+	if (source->filter_parent && fused_filters_render(source))
+		return;
+
 	if (source->filters.num && !source->rendering_filter)
 		obs_source_render_filters(source);
 
@@ -1965,6 +2037,8 @@ void obs_source_filter_add(obs_source_t *source, obs_source_t *filter)
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_video_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2000,6 +2074,8 @@ static bool obs_source_filter_remove_refless(obs_source_t *source,
 
 	pthread_mutex_unlock(&source->filter_mutex);
 
+	obs_source_video_changed(source);
+
 	calldata_init_fixed(&cd, stack, sizeof(stack));
 	calldata_set_ptr(&cd, "source", source);
 	calldata_set_ptr(&cd, "filter", filter);
@@ -2126,8 +2202,10 @@ void obs_source_filter_set_order(obs_source_t *source, obs_source_t *filter,
 	success = move_filter_dir(source, filter, movement);
 	pthread_mutex_unlock(&source->filter_mutex);
 
-	if (success)
+	if (success) {
+		obs_source_video_changed(source);
 		obs_source_dosignal(source, NULL, "reorder_filters");
+	}
 }
 
 obs_data_t *obs_source_get_settings(const obs_source_t *source)
@@ -2312,27 +2390,14 @@ static void clean_cache(obs_source_t *source)
 
 #define MAX_ASYNC_FRAMES 30
 
-static inline struct obs_source_frame *cache_video(struct obs_source *source,
-		const struct obs_source_frame *frame)
+/* takes an unused frame from the cache (or allocates a new one) and marks it
+ * as used.  the returned frame has an extra reference owned by the caller.
+ * must be called with async_mutex locked */
+static struct obs_source_frame *get_cached_frame(struct obs_source *source,
+		enum video_format format, uint32_t width, uint32_t height)
 {
 	struct obs_source_frame *new_frame = NULL;
 
-	pthread_mutex_lock(&source->async_mutex);
-
-	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
-		free_async_cache(source);
-		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
-	}
-
-	if (async_texture_changed(source, frame)) {
-		free_async_cache(source);
-		source->async_cache_width  = frame->width;
-		source->async_cache_height = frame->height;
-		source->async_cache_format = frame->format;
-	}
-
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
 		if (!af->used) {
@@ -2347,13 +2412,11 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source,
 
 	if (!new_frame) {
 		struct async_frame new_af;
-		enum video_format format = frame->format;
 
 		if (format == VIDEO_FORMAT_Y800)
 			format = VIDEO_FORMAT_BGRX;
 
-		new_frame = obs_source_frame_create(format,
-				frame->width, frame->height);
+		new_frame = obs_source_frame_create(format, width, height);
 		new_af.frame = new_frame;
 		new_af.used = true;
 		new_af.unused_count = 0;
@@ -2363,6 +2426,49 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source,
 	}
 
 	os_atomic_inc_long(&new_frame->refs);
+	return new_frame;
+}
+
+/* queues a frame for rendering.  if the render thread is not keeping up,
+ * the oldest queued frame is dropped rather than discarding the entire
+ * cache; timing is only reset if the queue has stayed full for a whole
+ * queue's worth of frames.  must be called with async_mutex locked */
+static void push_async_frame(struct obs_source *source,
+		struct obs_source_frame *frame)
+{
+	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
+		struct obs_source_frame *oldest = source->async_frames.array[0];
+
+		da_erase(source->async_frames, 0);
+		remove_async_frame(source, oldest);
+
+		if (++source->async_overflow_count >= MAX_ASYNC_FRAMES) {
+			source->async_overflow_count = 0;
+			source->last_frame_ts = 0;
+		}
+	} else {
+		source->async_overflow_count = 0;
+	}
+
+	da_push_back(source->async_frames, &frame);
+}
+
+static inline struct obs_source_frame *cache_video(struct obs_source *source,
+		const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (async_texture_changed(source, frame)) {
+		free_async_cache(source);
+		source->async_cache_width  = frame->width;
+		source->async_cache_height = frame->height;
+		source->async_cache_format = frame->format;
+	}
+
+	new_frame = get_cached_frame(source, frame->format,
+			frame->width, frame->height);
 
 	pthread_mutex_unlock(&source->async_mutex);
 
@@ -2394,12 +2500,86 @@ void obs_source_output_video(obs_source_t *source,
 
 	if (output) {
 		pthread_mutex_lock(&source->async_mutex);
-		da_push_back(source->async_frames, &output);
+		push_async_frame(source, output);
 		pthread_mutex_unlock(&source->async_mutex);
 		source->async_active = true;
 	}
 }
 
+struct obs_source_frame *obs_source_get_pooled_frame(obs_source_t *source,
+		enum video_format format, uint32_t width, uint32_t height)
+{
+	struct obs_source_frame *frame;
+
+	if (!obs_source_valid(source, "obs_source_get_pooled_frame"))
+		return NULL;
+	if (format == VIDEO_FORMAT_NONE || format == VIDEO_FORMAT_Y800)
+		return NULL;
+	if (!width || !height)
+		return NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	/* pooled frames are written directly by the source, so the pool
+	 * must match the exact format rather than just the conversion type */
+	if (source->async_cache_width  != width  ||
+	    source->async_cache_height != height ||
+	    source->async_cache_format != format) {
+		free_async_cache(source);
+		source->async_cache_width  = width;
+		source->async_cache_height = height;
+		source->async_cache_format = format;
+	}
+
+	frame = get_cached_frame(source, format, width, height);
+
+	pthread_mutex_unlock(&source->async_mutex);
+
+	return frame;
+}
+
+static bool release_pooled_frame(obs_source_t *source,
+		struct obs_source_frame *frame)
+{
+	if (os_atomic_dec_long(&frame->refs) == 0) {
+		/* the pool was reset while the frame was borrowed */
+		obs_source_frame_destroy(frame);
+		return false;
+	}
+
+	return true;
+}
+
+void obs_source_output_pooled_frame(obs_source_t *source,
+		struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_output_pooled_frame"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_output_pooled_frame"))
+		return;
+
+	pthread_mutex_lock(&source->async_mutex);
+	if (release_pooled_frame(source, frame)) {
+		push_async_frame(source, frame);
+		source->async_active = true;
+	}
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
+void obs_source_discard_pooled_frame(obs_source_t *source,
+		struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_discard_pooled_frame"))
+		return;
+	if (!obs_ptr_valid(frame, "obs_source_discard_pooled_frame"))
+		return;
+
+	pthread_mutex_lock(&source->async_mutex);
+	if (release_pooled_frame(source, frame))
+		remove_async_frame(source, frame);
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
 static inline bool preload_frame_changed(obs_source_t *source,
 		const struct obs_source_frame *in)
 {
@@ -2815,6 +2995,8 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 		struct calldata data;
 		char *prev_name = bstrdup(source->context.name);
 		obs_context_data_setname(&source->context, name);
+		source->tick_profile_name = NULL;
+		source->audio_render_profile_name = NULL;
 
 		calldata_init(&data);
 		calldata_set_ptr(&data, "source", source);
@@ -2884,34 +3066,18 @@ static inline bool can_bypass(obs_source_t *target, obs_source_t *parent,
 		((parent_flags & OBS_SOURCE_ASYNC) == 0);
 }
 
-bool obs_source_process_filter_begin(obs_source_t *filter,
+/* renders the target of a filter in to the filter's texrender, unless the
+ * target can be drawn directly with the filter effect.  the target is
+ * usually the filter's own target, but fused filters render the target of
+ * the last filter of the fused run instead */
+bool filter_render_target(obs_source_t *filter, obs_source_t *target,
 		enum gs_color_format format,
 		enum obs_allow_direct_render allow_direct)
 {
-	obs_source_t *target, *parent;
-	uint32_t     parent_flags;
-	int          cx, cy;
-
-	if (!obs_ptr_valid(filter, "obs_source_process_filter_begin"))
-		return false;
-
-	target       = obs_filter_get_target(filter);
-	parent       = obs_filter_get_parent(filter);
-
-	if (!target) {
-		blog(LOG_INFO, "filter '%s' being processed with no target!",
-				filter->context.name);
-		return false;
-	}
-	if (!parent) {
-		blog(LOG_INFO, "filter '%s' being processed with no parent!",
-				filter->context.name);
-		return false;
-	}
-
-	parent_flags = parent->info.output_flags;
-	cx           = get_base_width(target);
-	cy           = get_base_height(target);
+	obs_source_t *parent = filter->filter_parent;
+	uint32_t     parent_flags = parent->info.output_flags;
+	int          cx = get_base_width(target);
+	int          cy = get_base_height(target);
 
 	filter->allow_direct = allow_direct;
 
@@ -2924,7 +3090,7 @@ bool obs_source_process_filter_begin(obs_source_t *filter,
 	}
 
 	if (!cx || !cy) {
-		obs_source_skip_video_filter(filter);
+		filter_skip_to_target(target, parent);
 		return false;
 	}
 
@@ -2956,12 +3122,55 @@ bool obs_source_process_filter_begin(obs_source_t *filter,
 	return true;
 }
 
+/* draws the result of filter_render_target with the filter effect */
+void filter_draw_effect(obs_source_t *filter, obs_source_t *target,
+		gs_effect_t *effect, uint32_t width, uint32_t height,
+		const char *tech_name)
+{
+	obs_source_t *parent = filter->filter_parent;
+	uint32_t     parent_flags = parent->info.output_flags;
+	gs_texture_t *texture;
+
+	if (can_bypass(target, parent, parent_flags, filter->allow_direct)) {
+		render_filter_bypass(target, effect, tech_name);
+	} else {
+		texture = gs_texrender_get_texture(filter->filter_texrender);
+		if (texture)
+			render_filter_tex(texture, effect, width, height,
+					tech_name);
+	}
+}
+
+bool obs_source_process_filter_begin(obs_source_t *filter,
+		enum gs_color_format format,
+		enum obs_allow_direct_render allow_direct)
+{
+	obs_source_t *target, *parent;
+
+	if (!obs_ptr_valid(filter, "obs_source_process_filter_begin"))
+		return false;
+
+	target       = obs_filter_get_target(filter);
+	parent       = obs_filter_get_parent(filter);
+
+	if (!target) {
+		blog(LOG_INFO, "filter '%s' being processed with no target!",
+				filter->context.name);
+		return false;
+	}
+	if (!parent) {
+		blog(LOG_INFO, "filter '%s' being processed with no parent!",
+				filter->context.name);
+		return false;
+	}
+
+	return filter_render_target(filter, target, format, allow_direct);
+}
+
 void obs_source_process_filter_tech_end(obs_source_t *filter, gs_effect_t *effect,
 		uint32_t width, uint32_t height, const char *tech_name)
 {
 	obs_source_t *target, *parent;
-	gs_texture_t *texture;
-	uint32_t     parent_flags;
 
 	if (!filter) return;
 
@@ -2971,57 +3180,26 @@ void obs_source_process_filter_tech_end(obs_source_t *filter, gs_effect_t *effec
 	if (!target || !parent)
 		return;
 
-	parent_flags = parent->info.output_flags;
-
-	const char *tech = tech_name ? tech_name : "Draw";
-
-	if (can_bypass(target, parent, parent_flags, filter->allow_direct)) {
-		render_filter_bypass(target, effect, tech);
-	} else {
-		texture = gs_texrender_get_texture(filter->filter_texrender);
-		render_filter_tex(texture, effect, width, height, tech);
-	}
+	filter_draw_effect(filter, target, effect, width, height,
+			tech_name ? tech_name : "Draw");
 }
 
 
 void obs_source_process_filter_end(obs_source_t *filter, gs_effect_t *effect,
 		uint32_t width, uint32_t height)
 {
-	obs_source_t *target, *parent;
-	gs_texture_t *texture;
-	uint32_t     parent_flags;
-
 	if (!obs_ptr_valid(filter, "obs_source_process_filter_end"))
 		return;
 
-	target       = obs_filter_get_target(filter);
-	parent       = obs_filter_get_parent(filter);
-	parent_flags = parent->info.output_flags;
-
-	if (can_bypass(target, parent, parent_flags, filter->allow_direct)) {
-		render_filter_bypass(target, effect, "Draw");
-	} else {
-		texture = gs_texrender_get_texture(filter->filter_texrender);
-		if (texture)
-			render_filter_tex(texture, effect, width, height,
-					"Draw");
-	}
+	filter_draw_effect(filter, obs_filter_get_target(filter), effect,
+			width, height, "Draw");
 }
 
-void obs_source_skip_video_filter(obs_source_t *filter)
+void filter_skip_to_target(obs_source_t *target, obs_source_t *parent)
 {
-	obs_source_t *target, *parent;
-	bool custom_draw, async;
-	uint32_t parent_flags;
-
-	if (!obs_ptr_valid(filter, "obs_source_skip_video_filter"))
-		return;
-
-	target = obs_filter_get_target(filter);
-	parent = obs_filter_get_parent(filter);
-	parent_flags = parent->info.output_flags;
-	custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
-	async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
+	uint32_t parent_flags = parent->info.output_flags;
+	bool custom_draw = (parent_flags & OBS_SOURCE_CUSTOM_DRAW) != 0;
+	bool async = (parent_flags & OBS_SOURCE_ASYNC) != 0;
 
 	if (target == parent) {
 		if (!custom_draw && !async)
@@ -3038,6 +3216,15 @@ void obs_source_skip_video_filter(obs_source_t *filter)
 	}
 }
 
+void obs_source_skip_video_filter(obs_source_t *filter)
+{
+	if (!obs_ptr_valid(filter, "obs_source_skip_video_filter"))
+		return;
+
+	filter_skip_to_target(obs_filter_get_target(filter),
+			obs_filter_get_parent(filter));
+}
+
 signal_handler_t *obs_source_get_signal_handler(const obs_source_t *source)
 {
 	return obs_source_valid(source, "obs_source_get_signal_handler") ?
@@ -3537,6 +3724,7 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 		return;
 
 	source->enabled = enabled;
+	obs_source_video_changed(source);
 
 	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "source", source);
@@ -3752,14 +3940,17 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 	return source->volume;
 }
 
-static inline void multiply_output_audio(obs_source_t *source, size_t mix,
-		size_t channels, float vol)
+/* buffers of audio_output_buf that hold the data of at least one mix */
+static inline uint32_t audio_output_stores(const obs_source_t *source)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
+	uint32_t stores = 0;
 
-	while (out < end)
-		*(out++) *= vol;
+	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
+		if ((source->audio_output_mask & (1 << mix)) != 0)
+			stores |= 1 << source->audio_output_ref[mix];
+	}
+
+	return stores;
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix,
@@ -3796,6 +3987,7 @@ static void apply_audio_actions(obs_source_t *source, size_t channels,
 	float *vol_data = malloc(sizeof(float) * AUDIO_OUTPUT_FRAMES);
 	float cur_vol = get_source_volume(source, source->audio_ts);
 	size_t frame_num = 0;
+	uint32_t stores;
 
 	pthread_mutex_lock(&source->audio_actions_mutex);
 
@@ -3830,8 +4022,10 @@ static void apply_audio_actions(obs_source_t *source, size_t channels,
 
 	pthread_mutex_unlock(&source->audio_actions_mutex);
 
+	stores = audio_output_stores(source);
+
 	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-		if ((source->audio_mixers & (1 << mix)) != 0)
+		if ((stores & (1 << mix)) != 0)
 			multiply_vol_data(source, mix, channels, vol_data);
 	}
 
@@ -3864,28 +4058,22 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
 	}
 
 	vol = get_source_volume(source, source->audio_ts);
-	if (vol == 1.0f)
-		return;
 
-	if (vol == 0.0f || mixers == 0) {
-		memset(source->audio_output_buf[0][0], 0,
-				AUDIO_OUTPUT_FRAMES * sizeof(float) *
-				MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
-		return;
-	}
+	/* the volume is applied by whatever reads the output, usually while
+	 * mixing it, rather than multiplying every buffer here */
+	if (vol == 0.0f || mixers == 0)
+		source->audio_output_mask = 0;
+	else
+		source->audio_output_gain = vol;
 
-	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-		uint32_t mix_and_val = (1 << mix);
-		if ((source->audio_mixers & mix_and_val) != 0 &&
-		    (mixers & mix_and_val) != 0)
-			multiply_output_audio(source, mix, channels, vol);
-	}
+	UNUSED_PARAMETER(channels);
 }
 
 static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 		size_t channels, size_t sample_rate)
 {
 	struct obs_source_audio_mix audio_data;
+	uint32_t routed = source->audio_mixers & mixers;
 	bool success;
 	uint64_t ts;
 
@@ -3895,13 +4083,20 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 				source->audio_output_buf[mix][ch];
 		}
 
-		if ((source->audio_mixers & mixers & (1 << mix)) != 0) {
-			memset(source->audio_output_buf[mix][0], 0,
-					sizeof(float) * AUDIO_OUTPUT_FRAMES *
-					channels);
+		if ((routed & (1 << mix)) != 0) {
+			for (size_t ch = 0; ch < channels; ch++)
+				memset(source->audio_output_buf[mix][ch], 0,
+						sizeof(float) *
+						AUDIO_OUTPUT_FRAMES);
 		}
+
+		source->audio_output_ref[mix] = (uint8_t)mix;
 	}
 
+	source->audio_output_mask = 0;
+	source->audio_output_gain = 1.0f;
+	source->audio_mix_scaled = false;
+
 	success = source->info.audio_render(source->context.data, &ts,
 			&audio_data, mixers, channels, sample_rate);
 	source->audio_ts = success ? ts : 0;
@@ -3910,18 +4105,8 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 	if (!success || !source->audio_ts || !mixers)
 		return;
 
-	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-		uint32_t mix_bit = 1 << mix;
-
-		if ((mixers & mix_bit) == 0)
-			continue;
-
-		if ((source->audio_mixers & mix_bit) == 0) {
-			memset(source->audio_output_buf[mix][0], 0,
-					sizeof(float) * AUDIO_OUTPUT_FRAMES *
-					channels);
-		}
-	}
+	/* mixes that are not routed are left silent */
+	source->audio_output_mask = routed;
 
 	apply_audio_volume(source, mixers, channels, sample_rate);
 }
@@ -3930,6 +4115,8 @@ static inline void process_audio_source_tick(obs_source_t *source,
 		uint32_t mixers, size_t channels, size_t sample_rate,
 		size_t size)
 {
+	uint32_t routed = source->audio_mixers & mixers;
+
 	pthread_mutex_lock(&source->audio_buf_mutex);
 
 	if (source->audio_input_buf[0].size < size) {
@@ -3938,31 +4125,21 @@ static inline void process_audio_source_tick(obs_source_t *source,
 		return;
 	}
 
-	for (size_t ch = 0; ch < channels; ch++)
-		circlebuf_peek_front(&source->audio_input_buf[ch],
-				source->audio_output_buf[0][ch],
-				size);
-
-	pthread_mutex_unlock(&source->audio_buf_mutex);
-
-	for (size_t mix = 1; mix < MAX_AUDIO_MIXES; mix++) {
-		uint32_t mix_and_val = (1 << mix);
-
-		if ((source->audio_mixers & mix_and_val) == 0 ||
-		    (mixers & mix_and_val) == 0) {
-			memset(source->audio_output_buf[mix][0],
-					0, size * channels);
-			continue;
-		}
-
+	/* all routed mixes share the first buffer, unrouted mixes are
+	 * silent and are not touched at all */
+	if (routed) {
 		for (size_t ch = 0; ch < channels; ch++)
-			memcpy(source->audio_output_buf[mix][ch],
-					source->audio_output_buf[0][ch], size);
+			circlebuf_peek_front(&source->audio_input_buf[ch],
+					source->audio_output_buf[0][ch],
+					size);
 	}
 
-	if ((source->audio_mixers & 1) == 0 || (mixers & 1) == 0)
-		memset(source->audio_output_buf[0][0], 0,
-				size * channels);
+	pthread_mutex_unlock(&source->audio_buf_mutex);
+
+	memset(source->audio_output_ref, 0, sizeof(source->audio_output_ref));
+	source->audio_output_mask = routed;
+	source->audio_output_gain = 1.0f;
+	source->audio_mix_scaled = false;
 
 	apply_audio_volume(source, mixers, channels, sample_rate);
 	source->audio_pending = false;
@@ -4004,46 +4181,396 @@ uint64_t obs_source_get_audio_timestamp(const obs_source_t *source)
 		source->audio_ts : 0;
 }
 
+static float silent_audio[AUDIO_OUTPUT_FRAMES] = {0};
+
+static inline float *audio_mix_data(const obs_source_t *source, size_t mix,
+		size_t ch)
+{
+	return source->audio_mix_buf +
+		(mix * MAX_AUDIO_CHANNELS + ch) * AUDIO_OUTPUT_FRAMES;
+}
+
+static void scale_audio_mix(obs_source_t *source, size_t channels)
+{
+	uint32_t stores = audio_output_stores(source);
+
+	if (!source->audio_mix_buf)
+		source->audio_mix_buf = bzalloc(sizeof(float) *
+				AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS *
+				MAX_AUDIO_MIXES);
+
+	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
+		if ((stores & (1 << mix)) == 0)
+			continue;
+
+		for (size_t ch = 0; ch < channels; ch++)
+			audio_copy_gain(audio_mix_data(source, mix, ch),
+					source->audio_output_buf[mix][ch],
+					source->audio_output_gain,
+					AUDIO_OUTPUT_FRAMES);
+	}
+
+	source->audio_mix_scaled = true;
+}
+
 void obs_source_get_audio_mix(const obs_source_t *source,
 		struct obs_source_audio_mix *audio)
 {
+	obs_source_t *s = (obs_source_t*)source;
+	bool scaled;
+
 	if (!obs_source_valid(source, "obs_source_get_audio_mix"))
 		return;
 	if (!obs_ptr_valid(audio, "audio"))
 		return;
 
+	/* callers expect the final data, so the volume has to be applied.
+	 * parents of the same render level can be rendered in parallel and
+	 * read the audio output and gain of this source directly, so the
+	 * output is left as it is and the scaled data is copied once to a
+	 * separate buffer instead */
+	scaled = source->audio_output_gain != 1.0f;
+	if (scaled) {
+		pthread_mutex_lock(&s->audio_buf_mutex);
+		if (!s->audio_mix_scaled)
+			scale_audio_mix(s,
+				audio_output_get_channels(obs->audio.audio));
+		pthread_mutex_unlock(&s->audio_buf_mutex);
+	}
+
 	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
 		for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++) {
+			const float *data = obs_source_audio_output(source,
+					mix, ch);
+
+			if (data && scaled)
+				data = audio_mix_data(source,
+						source->audio_output_ref[mix],
+						ch);
+
 			audio->output[mix].data[ch] =
-				source->audio_output_buf[mix][ch];
+				data ? (float*)data : silent_audio;
 		}
 	}
 }
 
+#define DEFAULT_ASYNC_AUDIO_CB_PACKETS 16
+
+struct audio_cb_packet {
+	struct audio_data          data;
+	bool                       muted;
+};
+
+struct audio_cb_async {
+	obs_source_t               *source;
+	obs_source_audio_capture_t callback;
+	void                       *param;
+
+	pthread_mutex_t            mutex;
+	struct circlebuf           packets;
+	size_t                     max_packets;
+	uint64_t                   dropped;
+
+	os_sem_t                   *packet_sem;
+	pthread_t                  thread;
+	bool                       thread_active;
+	volatile bool              stop;
+
+	/* removed from within its own callback, the thread frees it */
+	bool                       detached;
+};
+
+static void audio_cb_async_free(struct audio_cb_async *async);
+
+static void *audio_cb_async_thread(void *data)
+{
+	struct audio_cb_async *async = data;
+
+	os_set_thread_name("obs-core: audio capture callback");
+
+	while (os_sem_wait(async->packet_sem) == 0) {
+		struct audio_cb_packet packet;
+
+		if (os_atomic_load_bool(&async->stop))
+			break;
+
+		pthread_mutex_lock(&async->mutex);
+		if (!async->packets.size) {
+			pthread_mutex_unlock(&async->mutex);
+			continue;
+		}
+		circlebuf_pop_front(&async->packets, &packet, sizeof(packet));
+		pthread_mutex_unlock(&async->mutex);
+
+		async->callback(async->param, async->source, &packet.data,
+				packet.muted);
+		bfree(packet.data.data[0]);
+
+		if (os_atomic_load_bool(&async->stop))
+			break;
+	}
+
+	if (async->detached)
+		audio_cb_async_free(async);
+	return NULL;
+}
+
+/* called on the audio thread of the source: the packet is copied, and if the
+ * listener has fallen behind, its oldest packet is dropped rather than
+ * waiting for it */
+static void audio_cb_async_push(struct audio_cb_async *async,
+		const struct audio_data *in, bool muted)
+{
+	struct audio_cb_packet packet = {0};
+	size_t size = in->frames * sizeof(float);
+	size_t planes = 0;
+	bool dropped = false;
+
+	if (os_atomic_load_bool(&async->stop))
+		return;
+
+	while (planes < MAX_AV_PLANES && in->data[planes])
+		planes++;
+	if (!planes)
+		return;
+
+	packet.data.data[0] = bmalloc(size * planes);
+	for (size_t i = 0; i < planes; i++) {
+		packet.data.data[i] = packet.data.data[0] + size * i;
+		memcpy(packet.data.data[i], in->data[i], size);
+	}
+
+	packet.data.frames = in->frames;
+	packet.data.timestamp = in->timestamp;
+	packet.muted = muted;
+
+	pthread_mutex_lock(&async->mutex);
+
+	if (async->packets.size == async->max_packets * sizeof(packet)) {
+		struct audio_cb_packet old;
+
+		circlebuf_pop_front(&async->packets, &old, sizeof(old));
+		bfree(old.data.data[0]);
+		async->dropped++;
+		dropped = true;
+	}
+
+	circlebuf_push_back(&async->packets, &packet, sizeof(packet));
+
+	pthread_mutex_unlock(&async->mutex);
+
+	if (!dropped)
+		os_sem_post(async->packet_sem);
+}
+
+static inline bool audio_cb_async_own_thread(struct audio_cb_async *async)
+{
+	return async->thread_active &&
+		pthread_equal(pthread_self(), async->thread);
+}
+
+/* once this returns, the callback is no longer being called, unless this is
+ * called from the callback itself */
+static void audio_cb_async_stop(struct audio_cb_async *async)
+{
+	if (!async || !async->thread_active)
+		return;
+
+	os_atomic_set_bool(&async->stop, true);
+
+	if (audio_cb_async_own_thread(async))
+		return;
+
+	os_sem_post(async->packet_sem);
+	pthread_join(async->thread, NULL);
+	async->thread_active = false;
+}
+
+static void audio_cb_async_free(struct audio_cb_async *async)
+{
+	while (async->packets.size) {
+		struct audio_cb_packet packet;
+
+		circlebuf_pop_front(&async->packets, &packet, sizeof(packet));
+		bfree(packet.data.data[0]);
+	}
+
+	circlebuf_free(&async->packets);
+	os_sem_destroy(async->packet_sem);
+	pthread_mutex_destroy(&async->mutex);
+	bfree(async);
+}
+
+static void audio_cb_async_destroy(struct audio_cb_async *async)
+{
+	if (!async)
+		return;
+
+	if (async->dropped)
+		blog(LOG_DEBUG, "Asynchronous audio capture callback of "
+				"source '%s' dropped %"PRIu64" packets",
+				async->source->context.name, async->dropped);
+
+	/* the thread cannot join itself, so when removed from within the
+	 * callback it is detached and frees everything once the callback
+	 * returns */
+	if (audio_cb_async_own_thread(async)) {
+		os_atomic_set_bool(&async->stop, true);
+		async->detached = true;
+		pthread_detach(async->thread);
+		return;
+	}
+
+	audio_cb_async_stop(async);
+	audio_cb_async_free(async);
+}
+
+static struct audio_cb_async *audio_cb_async_create(obs_source_t *source,
+		obs_source_audio_capture_t callback, void *param,
+		size_t max_packets)
+{
+	struct audio_cb_async *async = bzalloc(sizeof(*async));
+
+	async->source = source;
+	async->callback = callback;
+	async->param = param;
+	async->max_packets = max_packets ?
+		max_packets : DEFAULT_ASYNC_AUDIO_CB_PACKETS;
+
+	pthread_mutex_init_value(&async->mutex);
+	if (pthread_mutex_init(&async->mutex, NULL) != 0)
+		goto fail;
+	if (os_sem_init(&async->packet_sem, 0) != 0)
+		goto fail;
+	if (pthread_create(&async->thread, NULL, audio_cb_async_thread,
+				async) != 0)
+		goto fail;
+
+	async->thread_active = true;
+	return async;
+
+fail:
+	audio_cb_async_destroy(async);
+	return NULL;
+}
+
+static inline void wait_audio_cb_readers(obs_source_t *source, long idx)
+{
+	while (os_atomic_load_long(&source->audio_cb_readers[idx]) > 0)
+		os_sleep_ms(1);
+}
+
+/* must be called with audio_cb_mutex held, returns the index of a copy of the
+ * current list that can be modified */
+static long audio_cb_list_begin(obs_source_t *source)
+{
+	long next = os_atomic_load_long(&source->audio_cb_cur) ^ 1;
+
+	wait_audio_cb_readers(source, next);
+	da_copy(source->audio_cb_lists[next],
+			source->audio_cb_lists[next ^ 1]);
+	return next;
+}
+
+/* once this returns, no callback of the previous list is being called */
+static void audio_cb_list_commit(obs_source_t *source, long next)
+{
+	os_atomic_set_long(&source->audio_cb_cur, next);
+	wait_audio_cb_readers(source, next ^ 1);
+}
+
+static void audio_cb_lists_stop(obs_source_t *source)
+{
+	long cur = os_atomic_load_long(&source->audio_cb_cur);
+
+	for (size_t i = 0; i < source->audio_cb_lists[cur].num; i++)
+		audio_cb_async_stop(source->audio_cb_lists[cur].array[i].async);
+}
+
+static void audio_cb_lists_free(obs_source_t *source)
+{
+	long cur = os_atomic_load_long(&source->audio_cb_cur);
+
+	for (size_t i = 0; i < source->audio_cb_lists[cur].num; i++)
+		audio_cb_async_destroy(
+				source->audio_cb_lists[cur].array[i].async);
+
+	da_free(source->audio_cb_lists[0]);
+	da_free(source->audio_cb_lists[1]);
+}
+
+static void add_audio_capture_callback(obs_source_t *source,
+		const struct audio_cb_info *info)
+{
+	long idx;
+
+	pthread_mutex_lock(&source->audio_cb_mutex);
+	idx = audio_cb_list_begin(source);
+	da_push_back(source->audio_cb_lists[idx], info);
+	audio_cb_list_commit(source, idx);
+	pthread_mutex_unlock(&source->audio_cb_mutex);
+}
+
 void obs_source_add_audio_capture_callback(obs_source_t *source,
 		obs_source_audio_capture_t callback, void *param)
 {
-	struct audio_cb_info info = {callback, param};
+	struct audio_cb_info info = {callback, param, NULL};
 
 	if (!obs_source_valid(source, "obs_source_add_audio_capture_callback"))
 		return;
 
-	pthread_mutex_lock(&source->audio_cb_mutex);
-	da_push_back(source->audio_cb_list, &info);
-	pthread_mutex_unlock(&source->audio_cb_mutex);
+	add_audio_capture_callback(source, &info);
+}
+
+void obs_source_add_audio_capture_callback_async(obs_source_t *source,
+		obs_source_audio_capture_t callback, void *param,
+		size_t max_packets)
+{
+	struct audio_cb_info info = {callback, param, NULL};
+
+	if (!obs_source_valid(source,
+				"obs_source_add_audio_capture_callback_async"))
+		return;
+
+	info.async = audio_cb_async_create(source, callback, param,
+			max_packets);
+	if (!info.async) {
+		blog(LOG_WARNING, "Failed to create asynchronous audio "
+				"capture callback for source '%s'",
+				source->context.name);
+		return;
+	}
+
+	add_audio_capture_callback(source, &info);
 }
 
 void obs_source_remove_audio_capture_callback(obs_source_t *source,
 		obs_source_audio_capture_t callback, void *param)
 {
-	struct audio_cb_info info = {callback, param};
+	struct audio_cb_async *async = NULL;
+	long idx;
 
 	if (!obs_source_valid(source, "obs_source_remove_audio_capture_callback"))
 		return;
 
 	pthread_mutex_lock(&source->audio_cb_mutex);
-	da_erase_item(source->audio_cb_list, &info);
+	idx = audio_cb_list_begin(source);
+
+	for (size_t i = 0; i < source->audio_cb_lists[idx].num; i++) {
+		struct audio_cb_info *info =
+			source->audio_cb_lists[idx].array + i;
+
+		if (info->callback == callback && info->param == param) {
+			async = info->async;
+			da_erase(source->audio_cb_lists[idx], i);
+			break;
+		}
+	}
+
+	audio_cb_list_commit(source, idx);
 	pthread_mutex_unlock(&source->audio_cb_mutex);
+
+	audio_cb_async_destroy(async);
 }
 
 void obs_source_set_monitoring_type(obs_source_t *source,
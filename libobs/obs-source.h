@@ -135,6 +135,26 @@ enum obs_source_type {
  */
 #define OBS_SOURCE_CAP_DISABLED (1<<10)
 
+/**
+ * Source's video_tick callback can be called in parallel with other sources
+ *
+ * The video_tick callback is called on a worker thread, after the tick
+ * callbacks of sources without this flag.  It must only touch the source's
+ * own data and must not enter the graphics context or call functions that
+ * lock the global source list, such as obs_get_source_by_name.
+ */
+#define OBS_SOURCE_PARALLEL_TICK (1<<11)
+
+/**
+ * Source video only changes when its settings are updated or its size
+ * changes, or when it calls obs_source_video_changed.
+ *
+ * Scenes with the composite cache enabled can then render the source into
+ * a cached layer instead of rendering it every frame.  Filters need this
+ * flag as well for a filtered source to be cached.
+ */
+#define OBS_SOURCE_STATIC_VIDEO (1<<12)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -452,6 +472,39 @@ struct obs_source_info {
 	 * @return          The properties data
 	 */
 	obs_properties_t *(*get_properties2)(void *data, void *type_data);
+
+	/**
+	 * Per-pixel video filters only: gets the effect code of the filter, so
+	 * that consecutive per-pixel filters can be drawn in a single pass
+	 * instead of rendering each of them to a texture.
+	 *
+	 * The code defines either "float4 $color(float4 rgba)", which
+	 * transforms one pixel, or "float4 $sample(float2 uv)", which samples
+	 * the "image" texture itself.  A sampling filter is only fused when it
+	 * is the first filter of the run to be applied.  Every global name of
+	 * the code must start with "$", which is replaced with a prefix that
+	 * is unique within the fused effect.
+	 *
+	 * The code must be the same for every filter of this type, as it is
+	 * only compiled once for each combination of filter types.
+	 *
+	 * @param  data  Filter data
+	 * @return       The effect code, or NULL if the filter cannot be fused
+	 *               right now and has to be rendered on its own
+	 */
+	const char *(*get_fused_code)(void *data);
+
+	/**
+	 * Called instead of video_render when the filter is drawn as part of
+	 * a fused effect, to set the parameters of its code.  Parameters are
+	 * found with obs_fused_effect_get_param.
+	 *
+	 * @param  data    Filter data
+	 * @param  effect  Fused effect
+	 * @param  prefix  Prefix that replaced "$" in the filter's code
+	 */
+	void (*fused_render)(void *data, gs_effect_t *effect,
+			const char *prefix);
 };
 
 EXPORT void obs_register_source_s(const struct obs_source_info *info,
@@ -24,12 +24,78 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 
+/* sources that are neither showing nor active only have their tick called
+ * every few frames, staggered by their position in the source list */
+#define IDLE_TICK_INTERVAL 10
+
+static inline bool source_tick_idle(const struct obs_source *source)
+{
+	if (source->defer_update)
+		return false;
+
+	/* filters never get show/activate refs of their own, so they are
+	 * idle when the source they are attached to is.  filters are detached
+	 * before their parent leaves the source list, which is locked here,
+	 * so the parent stays valid */
+	if (source->info.type == OBS_SOURCE_TYPE_FILTER) {
+		source = source->filter_parent;
+		if (!source)
+			return true;
+	}
+
+	return !source->showing && !source->active &&
+	       !source->show_refs && !source->activate_refs &&
+	       !source->defer_update &&
+	       source->info.type != OBS_SOURCE_TYPE_TRANSITION &&
+	       (source->info.output_flags & OBS_SOURCE_ASYNC) == 0;
+}
+
+static const char *parallel_tick_name = "tick_sources(parallel)";
+
+static void parallel_tick_task(void *param, size_t idx)
+{
+	struct source_tick *tick = (struct source_tick*)param + idx;
+
+	profile_reenable_thread();
+
+	profile_start(parallel_tick_name);
+	obs_source_video_tick_callback(tick->source, tick->seconds);
+	profile_end(parallel_tick_name);
+}
+
+static void tick_source(struct obs_core_video *video,
+		struct obs_source *source, size_t idx, float seconds)
+{
+	float tick_seconds;
+
+	source->pending_tick_seconds += seconds;
+
+	if (source_tick_idle(source) &&
+	    (video->tick_frame + idx) % IDLE_TICK_INTERVAL != 0)
+		return;
+
+	tick_seconds = source->pending_tick_seconds;
+	source->pending_tick_seconds = 0.0f;
+
+	if (!obs_source_video_tick_state(source))
+		return;
+
+	if (source->info.output_flags & OBS_SOURCE_PARALLEL_TICK) {
+		struct source_tick tick = {source, tick_seconds};
+		da_push_back(video->parallel_ticks, &tick);
+	} else {
+		obs_source_video_tick_callback(source, tick_seconds);
+	}
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
+	struct obs_core_video *video = &obs->video;
 	struct obs_source    *source;
 	uint64_t             delta_time;
 	float                seconds;
+	size_t               idx = 0;
 
 	if (!last_time)
 		last_time = cur_time -
@@ -56,23 +122,68 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 
 	pthread_mutex_lock(&data->sources_mutex);
 
+	da_resize(video->parallel_ticks, 0);
+
 	source = data->first_source;
 	while (source) {
-		obs_source_video_tick(source, seconds);
+		tick_source(video, source, idx++, seconds);
 		source = (struct obs_source*)source->context.next;
 	}
 
+	/* sources are still locked, so none of them can be destroyed while
+	 * the workers are ticking them */
+	os_task_pool_run(video->parallel_ticks.num > 1 ?
+			video->tick_pool : NULL,
+			parallel_tick_task, video->parallel_ticks.array,
+			video->parallel_ticks.num);
+
 	pthread_mutex_unlock(&data->sources_mutex);
 
+	video->tick_frame++;
+
 	return cur_time;
 }
 
 /* in obs-display.c */
 extern void render_display(struct obs_display *display);
 
-static inline void render_displays(void)
+/* displays are skipped when rendering them would make the graphics thread
+ * miss its next frame, unless they haven't been rendered for this long */
+#define MAX_DISPLAY_DELAY_NS 250000000ULL
+
+static bool display_render_due(struct obs_display *display,
+		uint64_t video_time, uint64_t frame_start, uint64_t interval)
+{
+	uint64_t render_interval = display->render_interval;
+	uint64_t now = os_gettime_ns();
+
+	if (!display->enabled || !display->visible)
+		return false;
+
+	/* allow half a frame of leeway so that e.g. 30 fps on a 60 fps
+	 * canvas renders every other frame despite rounding */
+	if (render_interval > interval &&
+	    video_time + interval / 2 < display->next_render_time)
+		return false;
+
+	if (now - display->last_render_time < MAX_DISPLAY_DELAY_NS &&
+	    now - frame_start + display->render_cost > interval)
+		return false;
+
+	if (render_interval > interval) {
+		display->next_render_time += render_interval;
+		if (display->next_render_time + interval / 2 < video_time)
+			display->next_render_time = video_time +
+				render_interval;
+	}
+
+	return true;
+}
+
+static inline void render_displays(uint64_t frame_start, uint64_t interval)
 {
 	struct obs_display *display;
+	uint64_t video_time = obs->video.video_time;
 
 	if (!obs->data.valid)
 		return;
@@ -84,7 +195,17 @@ static inline void render_displays(void)
 
 	display = obs->data.first_display;
 	while (display) {
-		render_display(display);
+		if (display_render_due(display, video_time, frame_start,
+					interval)) {
+			uint64_t start = os_gettime_ns();
+
+			render_display(display);
+
+			display->last_render_time = os_gettime_ns();
+			display->render_cost =
+				display->last_render_time - start;
+		}
+
 		display = display->next;
 	}
 
@@ -243,11 +364,13 @@ end:
 	profile_end(render_output_texture_name);
 }
 
-static inline void set_eparam(gs_effect_t *effect, const char *name, float val)
-{
-	gs_eparam_t *param = gs_effect_get_param_by_name(effect, name);
-	gs_effect_set_float(param, val);
-}
+/* each call site keeps its own parameter cache */
+#define set_eparam(effect, name, val) \
+	do { \
+		static struct gs_eparam_cache cache = {0}; \
+		gs_effect_set_float(gs_effect_get_param_cached(effect, name, \
+					&cache), val); \
+	} while (false)
 
 static const char *render_convert_texture_name = "render_convert_texture";
 static void render_convert_texture(struct obs_core_video *video,
@@ -305,13 +428,14 @@ end:
 
 static const char *stage_output_texture_name = "stage_output_texture";
 static inline void stage_output_texture(struct obs_core_video *video,
-		int cur_texture, int prev_texture)
+		int prev_texture)
 {
 	profile_start(stage_output_texture_name);
 
 	gs_texture_t   *texture;
 	bool        texture_ready;
-	gs_stagesurf_t *copy = video->copy_surfaces[cur_texture];
+	gs_stagesurf_t *copy;
+	uint32_t       idx;
 
 	if (video->gpu_conversion) {
 		texture = video->convert_textures[prev_texture];
@@ -326,9 +450,14 @@ static inline void stage_output_texture(struct obs_core_video *video,
 	if (!texture_ready)
 		goto end;
 
+	/* download_frame always leaves at least one surface free */
+	idx = (video->copy_surface_head + video->copies_staged) %
+		video->num_copy_surfaces;
+	copy = video->copy_surfaces[idx];
+
 	gs_stage_texture(copy, texture);
 
-	video->textures_copied[cur_texture] = true;
+	video->copies_staged++;
 
 end:
 	profile_end(stage_output_texture_name);
@@ -347,7 +476,7 @@ static inline void render_video(struct obs_core_video *video, int cur_texture,
 	if (video->gpu_conversion)
 		render_convert_texture(video, cur_texture, prev_texture);
 
-	stage_output_texture(video, cur_texture, prev_texture);
+	stage_output_texture(video, prev_texture);
 
 	gs_set_render_target(NULL, NULL);
 	gs_enable_blending(true);
@@ -355,19 +484,42 @@ static inline void render_video(struct obs_core_video *video, int cur_texture,
 	gs_end_scene();
 }
 
+static const char *download_frame_stall_name = "readback_stall";
+
+/* downloads the oldest staged frame once its copy has completed, and only
+ * waits for the GPU when every copy surface is in flight */
 static inline bool download_frame(struct obs_core_video *video,
-		int prev_texture, struct video_data *frame)
+		struct video_data *frame)
 {
-	gs_stagesurf_t *surface = video->copy_surfaces[prev_texture];
+	gs_stagesurf_t *surface;
+	bool success;
 
-	if (!video->textures_copied[prev_texture])
+	if (!video->copies_staged)
 		return false;
 
-	if (!gs_stagesurface_map(surface, &frame->data[0], &frame->linesize[0]))
-		return false;
+	surface = video->copy_surfaces[video->copy_surface_head];
+	success = gs_stagesurface_try_map(surface,
+			&frame->data[0], &frame->linesize[0]);
 
-	video->mapped_surface = surface;
-	return true;
+	if (!success) {
+		if (video->copies_staged < video->num_copy_surfaces)
+			return false;
+
+		video->readback_stalls++;
+
+		profile_start(download_frame_stall_name);
+		success = gs_stagesurface_map(surface,
+				&frame->data[0], &frame->linesize[0]);
+		profile_end(download_frame_stall_name);
+	}
+
+	video->copy_surface_head = (video->copy_surface_head + 1) %
+		video->num_copy_surfaces;
+	video->copies_staged--;
+
+	if (success)
+		video->mapped_surface = surface;
+	return success;
 }
 
 static inline uint32_t calc_linesize(uint32_t pos, uint32_t linesize)
@@ -450,52 +602,127 @@ static void set_gpu_converted_data(struct obs_core_video *video,
 	}
 }
 
-static void convert_frame(
+struct frame_band_job {
+	struct video_frame                *output;
+	const struct video_data           *input;
+	const struct video_output_info    *info;
+	uint32_t                          band_height;
+};
+
+static inline size_t init_frame_band_job(struct frame_band_job *job,
 		struct video_frame *output, const struct video_data *input,
-		const struct video_output_info *info)
+		const struct video_output_info *info, size_t num_bands)
+{
+	uint32_t band_height = (uint32_t)
+		((info->height + num_bands - 1) / num_bands);
+
+	/* keep bands on even lines so 4:2:0 chroma rows are never split */
+	band_height = (band_height + 1) & ~1;
+
+	job->output      = output;
+	job->input       = input;
+	job->info        = info;
+	job->band_height = band_height;
+
+	return (info->height + band_height - 1) / band_height;
+}
+
+static inline void get_band_lines(const struct frame_band_job *job,
+		size_t idx, uint32_t *start_y, uint32_t *end_y)
 {
-	if (info->format == VIDEO_FORMAT_I420) {
+	*start_y = (uint32_t)idx * job->band_height;
+	*end_y   = *start_y + job->band_height;
+
+	if (*end_y > job->info->height)
+		*end_y = job->info->height;
+}
+
+static void convert_frame_band(void *param, size_t idx)
+{
+	struct frame_band_job *job = param;
+	struct video_frame *output = job->output;
+	const struct video_data *input = job->input;
+	uint32_t start_y, end_y;
+
+	get_band_lines(job, idx, &start_y, &end_y);
+
+	if (job->info->format == VIDEO_FORMAT_I420) {
 		compress_uyvx_to_i420(
 				input->data[0], input->linesize[0],
-				0, info->height,
+				start_y, end_y,
 				output->data, output->linesize);
 
-	} else if (info->format == VIDEO_FORMAT_NV12) {
+	} else if (job->info->format == VIDEO_FORMAT_NV12) {
 		compress_uyvx_to_nv12(
 				input->data[0], input->linesize[0],
-				0, info->height,
+				start_y, end_y,
 				output->data, output->linesize);
 
-	} else if (info->format == VIDEO_FORMAT_I444) {
+	} else {
 		convert_uyvx_to_i444(
 				input->data[0], input->linesize[0],
-				0, info->height,
+				start_y, end_y,
 				output->data, output->linesize);
-
-	} else {
-		blog(LOG_ERROR, "convert_frame: unsupported texture format");
 	}
 }
 
-static inline void copy_rgbx_frame(
+static void convert_frame(struct obs_core_video *video,
 		struct video_frame *output, const struct video_data *input,
 		const struct video_output_info *info)
 {
-	uint8_t *in_ptr = input->data[0];
-	uint8_t *out_ptr = output->data[0];
+	struct frame_band_job job;
+	size_t num_bands;
+
+	if (info->format != VIDEO_FORMAT_I420 &&
+	    info->format != VIDEO_FORMAT_NV12 &&
+	    info->format != VIDEO_FORMAT_I444) {
+		blog(LOG_ERROR, "convert_frame: unsupported texture format");
+		return;
+	}
+
+	num_bands = init_frame_band_job(&job, output, input, info,
+			os_task_pool_concurrency(video->convert_pool));
+	os_task_pool_run(video->convert_pool, convert_frame_band, &job,
+			num_bands);
+}
+
+static void copy_rgbx_frame_band(void *param, size_t idx)
+{
+	struct frame_band_job *job = param;
+	uint32_t in_linesize  = job->input->linesize[0];
+	uint32_t out_linesize = job->output->linesize[0];
+	uint32_t start_y, end_y;
+
+	get_band_lines(job, idx, &start_y, &end_y);
+
+	uint8_t *in_ptr  = job->input->data[0] + start_y * in_linesize;
+	uint8_t *out_ptr = job->output->data[0] + start_y * out_linesize;
 
 	/* if the line sizes match, do a single copy */
-	if (input->linesize[0] == output->linesize[0]) {
-		memcpy(out_ptr, in_ptr, input->linesize[0] * info->height);
+	if (in_linesize == out_linesize) {
+		memcpy(out_ptr, in_ptr, in_linesize * (end_y - start_y));
 	} else {
-		for (size_t y = 0; y < info->height; y++) {
-			memcpy(out_ptr, in_ptr, info->width * 4);
-			in_ptr += input->linesize[0];
-			out_ptr += output->linesize[0];
+		for (uint32_t y = start_y; y < end_y; y++) {
+			memcpy(out_ptr, in_ptr, job->info->width * 4);
+			in_ptr += in_linesize;
+			out_ptr += out_linesize;
 		}
 	}
 }
 
+static inline void copy_rgbx_frame(struct obs_core_video *video,
+		struct video_frame *output, const struct video_data *input,
+		const struct video_output_info *info)
+{
+	struct frame_band_job job;
+	size_t num_bands;
+
+	num_bands = init_frame_band_job(&job, output, input, info,
+			os_task_pool_concurrency(video->convert_pool));
+	os_task_pool_run(video->convert_pool, copy_rgbx_frame_band, &job,
+			num_bands);
+}
+
 static inline void output_video_data(struct obs_core_video *video,
 		struct video_data *input_frame, int count)
 {
@@ -513,9 +740,11 @@ static inline void output_video_data(struct obs_core_video *video,
 					input_frame, info);
 
 		} else if (format_is_yuv(info->format)) {
-			convert_frame(&output_frame, input_frame, info);
+			convert_frame(video, &output_frame, input_frame,
+					info);
 		} else {
-			copy_rgbx_frame(&output_frame, input_frame, info);
+			copy_rgbx_frame(video, &output_frame, input_frame,
+					info);
 		}
 
 		video_output_unlock_frame(video->video);
@@ -570,7 +799,7 @@ static inline void output_frame(void)
 	profile_end(output_frame_render_video_name);
 
 	profile_start(output_frame_download_frame_name);
-	frame_ready = download_frame(video, prev_texture, &frame);
+	frame_ready = download_frame(video, &frame);
 	profile_end(output_frame_download_frame_name);
 
 	profile_start(output_frame_gs_flush_name);
@@ -634,7 +863,7 @@ void *obs_graphics_thread(void *param)
 		profile_end(output_frame_name);
 
 		profile_start(render_displays_name);
-		render_displays();
+		render_displays(frame_start, interval);
 		profile_end(render_displays_name);
 
 		frame_time_ns = os_gettime_ns() - frame_start;
@@ -40,6 +40,7 @@ static inline void make_video_info(struct video_output_info *vi,
 	vi->range   = ovi->range;
 	vi->colorspace = ovi->colorspace;
 	vi->cache_size = 6;
+	vi->cache_memory_limit = 0;
 }
 
 #define PIXEL_SIZE 4
@@ -190,13 +191,18 @@ static bool obs_init_textures(struct obs_video_info *ovi)
 		video->conversion_height : ovi->output_height;
 	size_t i;
 
-	for (i = 0; i < NUM_TEXTURES; i++) {
+	video->num_copy_surfaces = video->readback_depth ?
+		video->readback_depth : NUM_TEXTURES;
+
+	for (i = 0; i < video->num_copy_surfaces; i++) {
 		video->copy_surfaces[i] = gs_stagesurface_create(
 				ovi->output_width, output_height, GS_RGBA);
 
 		if (!video->copy_surfaces[i])
 			return false;
+	}
 
+	for (i = 0; i < NUM_TEXTURES; i++) {
 		video->render_textures[i] = gs_texture_create(
 				ovi->base_width, ovi->base_height,
 				GS_RGBA, 1, NULL, GS_RENDER_TARGET);
@@ -250,6 +256,8 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 
 	gs_enter_context(video->graphics);
 
+	video->filter_fusion = true;
+
 	char *filename = find_libobs_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename,
 			NULL);
@@ -347,6 +355,22 @@ static inline void set_video_matrix(struct obs_core_video *video,
 	memcpy(video->color_matrix, &mat, sizeof(float) * 16);
 }
 
+#define MAX_CONVERT_THREADS 4
+#define MAX_TICK_THREADS 4
+#define MAX_AUDIO_RENDER_THREADS 4
+
+/* CPU conversion, parallel source ticks and audio rendering are split across
+ * a few threads; the calling thread does one share of the work itself */
+static size_t get_worker_count(int max_threads)
+{
+	int threads = os_get_logical_cores() / 2;
+
+	if (threads > max_threads)
+		threads = max_threads;
+
+	return threads > 1 ? (size_t)(threads - 1) : 0;
+}
+
 static int obs_init_video(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -384,6 +408,14 @@ static int obs_init_video(struct obs_video_info *ovi)
 
 	gs_leave_context();
 
+	if (!video->gpu_conversion)
+		video->convert_pool = os_task_pool_create(
+				"libobs: frame conversion",
+				get_worker_count(MAX_CONVERT_THREADS));
+
+	video->tick_pool = os_task_pool_create("libobs: source tick",
+			get_worker_count(MAX_TICK_THREADS));
+
 	errorcode = pthread_create(&video->video_thread, NULL,
 			obs_graphics_thread, obs);
 	if (errorcode != 0)
@@ -417,6 +449,13 @@ static void obs_free_video(void)
 		video_output_close(video->video);
 		video->video = NULL;
 
+		os_task_pool_destroy(video->convert_pool);
+		video->convert_pool = NULL;
+
+		os_task_pool_destroy(video->tick_pool);
+		video->tick_pool = NULL;
+		da_free(video->parallel_ticks);
+
 		if (!video->graphics)
 			return;
 
@@ -427,13 +466,16 @@ static void obs_free_video(void)
 			video->mapped_surface = NULL;
 		}
 
-		for (size_t i = 0; i < NUM_TEXTURES; i++) {
+		for (size_t i = 0; i < video->num_copy_surfaces; i++) {
 			gs_stagesurface_destroy(video->copy_surfaces[i]);
+			video->copy_surfaces[i] = NULL;
+		}
+
+		for (size_t i = 0; i < NUM_TEXTURES; i++) {
 			gs_texture_destroy(video->render_textures[i]);
 			gs_texture_destroy(video->convert_textures[i]);
 			gs_texture_destroy(video->output_textures[i]);
 
-			video->copy_surfaces[i]    = NULL;
 			video->render_textures[i]  = NULL;
 			video->convert_textures[i] = NULL;
 			video->output_textures[i]  = NULL;
@@ -447,12 +489,13 @@ static void obs_free_video(void)
 				sizeof(video->textures_rendered));
 		memset(&video->textures_output, 0,
 				sizeof(video->textures_output));
-		memset(&video->textures_copied, 0,
-				sizeof(video->textures_copied));
 		memset(&video->textures_converted, 0,
 				sizeof(video->textures_converted));
 
 		video->cur_texture = 0;
+		video->num_copy_surfaces = 0;
+		video->copy_surface_head = 0;
+		video->copies_staged = 0;
 	}
 }
 
@@ -475,6 +518,7 @@ static void obs_free_graphics(void)
 		gs_effect_destroy(video->bicubic_effect);
 		gs_effect_destroy(video->lanczos_effect);
 		gs_effect_destroy(video->bilinear_lowres_effect);
+		fused_effects_free(video);
 		video->default_effect = NULL;
 
 		gs_leave_context();
@@ -502,6 +546,10 @@ static bool obs_init_audio(struct audio_output_info *ai)
 
 	audio->user_volume    = 1.0f;
 
+	/* must exist before the audio thread starts calling audio_callback */
+	audio->render_pool = os_task_pool_create("libobs: audio render",
+			get_worker_count(MAX_AUDIO_RENDER_THREADS));
+
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
 
@@ -525,6 +573,11 @@ static void obs_free_audio(void)
 	circlebuf_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
+	da_free(audio->render_links);
+	da_free(audio->render_levels);
+	da_free(audio->render_level_ends);
+
+	os_task_pool_destroy(audio->render_pool);
 
 	da_free(audio->monitors);
 	bfree(audio->monitoring_device_name);
@@ -759,6 +812,7 @@ static bool obs_init(const char *locale, const char *module_config_path,
 	}
 
 	log_system_info();
+	obs_packet_pool_init();
 
 	if (!obs_init_data())
 		return false;
@@ -846,6 +900,7 @@ void obs_shutdown(void)
 	obs_free_video();
 	obs_free_hotkeys();
 	obs_free_graphics();
+	obs_packet_pool_shutdown();
 	proc_handler_destroy(obs->procs);
 	signal_handler_destroy(obs->signals);
 	obs->procs = NULL;
@@ -2054,3 +2109,20 @@ uint32_t obs_get_lagged_frames(void)
 {
 	return obs ? obs->video.lagged_frames : 0;
 }
+
+void obs_set_video_readback_depth(uint32_t depth)
+{
+	if (!obs) return;
+
+	if (depth && depth < 2)
+		depth = 2;
+	else if (depth > MAX_READBACK_DEPTH)
+		depth = MAX_READBACK_DEPTH;
+
+	obs->video.readback_depth = depth;
+}
+
+uint32_t obs_get_video_readback_stalls(void)
+{
+	return obs ? obs->video.readback_stalls : 0;
+}
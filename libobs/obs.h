@@ -151,7 +151,8 @@ struct obs_transform_info {
 struct obs_video_info {
 #ifndef SWIG
 	/**
-	 * Graphics module to use (usually "libobs-opengl" or "libobs-d3d11")
+	 * Graphics module to use (usually "libobs-opengl" or "libobs-d3d11",
+	 * or "libobs-null" to run without a GPU)
 	 */
 	const char          *graphics_module;
 #endif
@@ -658,6 +659,17 @@ EXPORT uint64_t obs_get_average_frame_time_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/**
+ * Sets how many output frames can be in flight between being copied from the
+ * GPU and being downloaded (2 to 8, 0 for the default of 2).  Deeper
+ * pipelines add latency but let the GPU fall further behind before the
+ * graphics thread has to wait for it.  Takes effect on the next video reset.
+ */
+EXPORT void obs_set_video_readback_depth(uint32_t depth);
+
+/** Gets how many times the graphics thread had to wait for a frame copy */
+EXPORT uint32_t obs_get_video_readback_stalls(void);
+
 
 /* ------------------------------------------------------------------------- */
 /* Display context */
@@ -699,6 +711,20 @@ EXPORT void obs_display_remove_draw_callback(obs_display_t *display,
 EXPORT void obs_display_set_enabled(obs_display_t *display, bool enable);
 EXPORT bool obs_display_enabled(obs_display_t *display);
 
+/**
+ * Sets whether the window of the display can currently be seen.  Displays
+ * that are not visible (minimized or occluded windows) are not rendered.
+ */
+EXPORT void obs_display_set_visible(obs_display_t *display, bool visible);
+EXPORT bool obs_display_visible(obs_display_t *display);
+
+/**
+ * Limits how often the display is rendered, 0 to render it every frame.
+ * Displays are never rendered more often than the video frame rate.
+ */
+EXPORT void obs_display_set_max_fps(obs_display_t *display, uint32_t fps);
+EXPORT uint32_t obs_display_get_max_fps(obs_display_t *display);
+
 EXPORT void obs_display_set_background_color(obs_display_t *display,
 		uint32_t color);
 
@@ -936,6 +962,9 @@ typedef void (*obs_source_audio_capture_t)(void *param, obs_source_t *source,
 
 EXPORT void obs_source_add_audio_capture_callback(obs_source_t *source,
 		obs_source_audio_capture_t callback, void *param);
+EXPORT void obs_source_add_audio_capture_callback_async(obs_source_t *source,
+		obs_source_audio_capture_t callback, void *param,
+		size_t max_packets);
 EXPORT void obs_source_remove_audio_capture_callback(obs_source_t *source,
 		obs_source_audio_capture_t callback, void *param);
 
@@ -1020,6 +1049,26 @@ EXPORT void obs_source_draw(gs_texture_t *image, int x, int y,
 EXPORT void obs_source_output_video(obs_source_t *source,
 		const struct obs_source_frame *frame);
 
+/**
+ * Borrows a frame from the source's async frame pool so that video can be
+ * written directly into it rather than copied by obs_source_output_video.
+ * The frame must be handed back with either obs_source_output_pooled_frame
+ * or obs_source_discard_pooled_frame.  Y800 is not supported.
+ *
+ * @return  The pooled frame, or NULL if the format is not supported
+ */
+EXPORT struct obs_source_frame *obs_source_get_pooled_frame(
+		obs_source_t *source, enum video_format format,
+		uint32_t width, uint32_t height);
+
+/** Outputs a frame obtained from obs_source_get_pooled_frame without copying */
+EXPORT void obs_source_output_pooled_frame(obs_source_t *source,
+		struct obs_source_frame *frame);
+
+/** Returns an unused frame obtained from obs_source_get_pooled_frame */
+EXPORT void obs_source_discard_pooled_frame(obs_source_t *source,
+		struct obs_source_frame *frame);
+
 /** Preloads asynchronous video data to allow instantaneous playback */
 EXPORT void obs_source_preload_video(obs_source_t *source,
 		const struct obs_source_frame *frame);
@@ -1034,6 +1083,12 @@ EXPORT void obs_source_output_audio(obs_source_t *source,
 /** Signal an update to any currently used properties via 'update_properties' */
 EXPORT void obs_source_update_properties(obs_source_t *source);
 
+/**
+ * Signals that the video of a source with the OBS_SOURCE_STATIC_VIDEO flag
+ * has changed outside of an update
+ */
+EXPORT void obs_source_video_changed(obs_source_t *source);
+
 /** Gets the current async video frame */
 EXPORT struct obs_source_frame *obs_source_get_frame(obs_source_t *source);
 
@@ -1080,6 +1135,20 @@ EXPORT void obs_source_process_filter_tech_end(obs_source_t *filter,
 /** Skips the filter if the filter is invalid and cannot be rendered */
 EXPORT void obs_source_skip_video_filter(obs_source_t *filter);
 
+/**
+ * Enables or disables drawing runs of consecutive per-pixel filters (see
+ * obs_source_info.get_fused_code) in a single pass.  Enabled by default.
+ */
+EXPORT void obs_set_filter_fusion(bool enable);
+EXPORT bool obs_filter_fusion_enabled(void);
+
+/**
+ * Gets a parameter of a filter's code within a fused effect, where prefix is
+ * the prefix passed to obs_source_info.fused_render
+ */
+EXPORT gs_eparam_t *obs_fused_effect_get_param(gs_effect_t *effect,
+		const char *prefix, const char *name);
+
 /**
  * Adds an active child source.  Must be called by parent sources on child
  * sources when the child is added and active.  This ensures that the source is
@@ -1130,6 +1199,12 @@ EXPORT uint32_t obs_source_get_base_height(obs_source_t *source);
 
 EXPORT bool obs_source_audio_pending(const obs_source_t *source);
 EXPORT uint64_t obs_source_get_audio_timestamp(const obs_source_t *source);
+
+/**
+ * Gets the audio output of the source.  Mixes that share the same data may
+ * point to the same buffers, and mixes the source is not routed to point to
+ * a shared silent buffer, so the data must not be modified.
+ */
 EXPORT void obs_source_get_audio_mix(const obs_source_t *source,
 		struct obs_source_audio_mix *audio);
 
@@ -1260,6 +1335,14 @@ EXPORT obs_source_t *obs_scene_get_source(const obs_scene_t *scene);
 /** Gets the scene from its source, or NULL if not a scene */
 EXPORT obs_scene_t *obs_scene_from_source(const obs_source_t *source);
 
+/**
+ * Enables/disables caching of unchanging scene items.  Consecutive items of
+ * sources with the OBS_SOURCE_STATIC_VIDEO flag that have not changed for a
+ * while are rendered once into a cached layer.
+ */
+EXPORT void obs_scene_set_composite_cache(obs_scene_t *scene, bool enable);
+EXPORT bool obs_scene_composite_cache_enabled(const obs_scene_t *scene);
+
 /** Determines whether a source is within a scene */
 EXPORT obs_sceneitem_t *obs_scene_find_source(obs_scene_t *scene,
 		const char *name);
@@ -1535,6 +1618,7 @@ EXPORT void obs_output_set_reconnect_settings(obs_output_t *output,
 		int retry_count, int retry_sec);
 
 EXPORT uint64_t obs_output_get_total_bytes(const obs_output_t *output);
+EXPORT uint64_t obs_output_get_total_send_calls(const obs_output_t *output);
 EXPORT int obs_output_get_frames_dropped(const obs_output_t *output);
 EXPORT int obs_output_get_total_frames(const obs_output_t *output);
 
@@ -1781,6 +1865,12 @@ EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst,
 		struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/**
+ * Gets how many encoder packet payloads were reused from the packet pool
+ * (hits) and how many had to be allocated (misses) since startup.
+ */
+EXPORT void obs_get_packet_pool_stats(long *hits, long *misses);
+
 
 /* ------------------------------------------------------------------------- */
 /* Stream Services */
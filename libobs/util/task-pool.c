@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "task-pool.h"
+#include "threading.h"
+#include "bmem.h"
+
+struct os_task_pool {
+	pthread_t          *threads;
+	size_t             num_threads;
+	char               *name;
+
+	/* serializes os_task_pool_run calls from different threads */
+	pthread_mutex_t    run_mutex;
+
+	os_sem_t           *start_sem;
+	os_event_t         *done_event;
+	bool               stop;
+
+	os_task_func_t     func;
+	void               *param;
+	long               num_tasks;
+	volatile long      next_task;
+	volatile long      active_workers;
+};
+
+static void run_tasks(struct os_task_pool *pool)
+{
+	long idx;
+
+	while ((idx = os_atomic_inc_long(&pool->next_task) - 1) <
+			pool->num_tasks)
+		pool->func(pool->param, (size_t)idx);
+}
+
+static void *task_pool_thread(void *data)
+{
+	struct os_task_pool *pool = data;
+
+	os_set_thread_name(pool->name);
+
+	while (os_sem_wait(pool->start_sem) == 0) {
+		if (pool->stop)
+			break;
+
+		run_tasks(pool);
+
+		if (os_atomic_dec_long(&pool->active_workers) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+os_task_pool_t *os_task_pool_create(const char *name, size_t num_threads)
+{
+	struct os_task_pool *pool = bzalloc(sizeof(struct os_task_pool));
+
+	pool->name = bstrdup(name ? name : "task pool");
+	pthread_mutex_init_value(&pool->run_mutex);
+
+	if (pthread_mutex_init(&pool->run_mutex, NULL) != 0)
+		goto fail;
+	if (os_sem_init(&pool->start_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	pool->threads = bzalloc(sizeof(pthread_t) * (num_threads + 1));
+
+	for (size_t i = 0; i < num_threads; i++) {
+		if (pthread_create(&pool->threads[i], NULL, task_pool_thread,
+					pool) != 0)
+			break;
+		pool->num_threads++;
+	}
+
+	return pool;
+
+fail:
+	os_task_pool_destroy(pool);
+	return NULL;
+}
+
+void os_task_pool_destroy(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	pool->stop = true;
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->start_sem);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	os_event_destroy(pool->done_event);
+	os_sem_destroy(pool->start_sem);
+	pthread_mutex_destroy(&pool->run_mutex);
+	bfree(pool->threads);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_task_pool_concurrency(const os_task_pool_t *pool)
+{
+	return pool ? pool->num_threads + 1 : 1;
+}
+
+void os_task_pool_run(os_task_pool_t *pool, os_task_func_t func,
+		void *param, size_t num_tasks)
+{
+	size_t num_workers;
+
+	if (!num_tasks)
+		return;
+
+	if (!pool || !pool->num_threads || num_tasks == 1) {
+		for (size_t i = 0; i < num_tasks; i++)
+			func(param, i);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->run_mutex);
+
+	num_workers = num_tasks - 1;
+	if (num_workers > pool->num_threads)
+		num_workers = pool->num_threads;
+
+	pool->func      = func;
+	pool->param     = param;
+	pool->num_tasks = (long)num_tasks;
+	os_atomic_set_long(&pool->next_task, 0);
+	os_atomic_set_long(&pool->active_workers, (long)num_workers);
+
+	for (size_t i = 0; i < num_workers; i++)
+		os_sem_post(pool->start_sem);
+
+	run_tasks(pool);
+
+	/* workers that were woken must all check in before the job state can
+	 * be reused, otherwise a late worker could pick up the next job's
+	 * task index with this job's function */
+	os_event_wait(pool->done_event);
+
+	pthread_mutex_unlock(&pool->run_mutex);
+}
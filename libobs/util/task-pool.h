@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2018 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *   Small persistent pool of worker threads used to split a single job (for
+ * example a frame conversion) in to a number of independent tasks that are
+ * executed in parallel.  The calling thread takes part in the work as well,
+ * and os_task_pool_run does not return until every task has finished.
+ *
+ *   A pool created with zero threads (or a NULL pool) simply runs every task
+ * on the calling thread.
+ */
+
+struct os_task_pool;
+typedef struct os_task_pool os_task_pool_t;
+
+typedef void (*os_task_func_t)(void *param, size_t idx);
+
+EXPORT os_task_pool_t *os_task_pool_create(const char *name,
+		size_t num_threads);
+EXPORT void os_task_pool_destroy(os_task_pool_t *pool);
+
+/** Returns the number of tasks that can run at once (including the caller) */
+EXPORT size_t os_task_pool_concurrency(const os_task_pool_t *pool);
+
+/** Calls func(param, idx) for each idx in [0, num_tasks) and waits for all */
+EXPORT void os_task_pool_run(os_task_pool_t *pool, os_task_func_t func,
+		void *param, size_t num_tasks);
+
+#ifdef __cplusplus
+}
+#endif
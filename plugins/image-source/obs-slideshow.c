@@ -25,6 +25,8 @@
 #define S_MODE                         "slide_mode"
 #define S_MODE_AUTO                    "mode_auto"
 #define S_MODE_MANUAL                  "mode_manual"
+#define S_PRELOAD                      "preload_all"
+#define S_MEMORY_LIMIT                 "memory_limit"
 
 #define TR_CUT                         "cut"
 #define TR_FADE                        "fade"
@@ -48,6 +50,8 @@
 #define T_MODE                         T_("SlideMode")
 #define T_MODE_AUTO                    T_("SlideMode.Auto")
 #define T_MODE_MANUAL                  T_("SlideMode.Manual")
+#define T_PRELOAD                      T_("PreloadAll")
+#define T_MEMORY_LIMIT                 T_("MemoryLimit")
 
 #define T_TR_(text) obs_module_text("SlideShow.Transition." text)
 #define T_TR_CUT                       T_TR_("Cut")
@@ -57,9 +61,17 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* when not preloading, only the previous, current and next slides are kept
+ * loaded, plus as many recently shown slides as fit in the memory limit */
+#define MIN_MEMORY_LIMIT_MB            16
+#define MAX_MEMORY_LIMIT_MB            16384
+#define DEFAULT_MEMORY_LIMIT_MB        256
+
 struct image_file_data {
 	char *path;
 	obs_source_t *source;
+	uint64_t last_used;
+	bool load_failed;
 };
 
 enum behavior {
@@ -88,12 +100,25 @@ struct slideshow {
 
 	float elapsed;
 	size_t cur_item;
+	size_t next_item;
+	size_t next_item_base;
+	bool transition_pending;
 
 	uint32_t cx;
 	uint32_t cy;
 
 	pthread_mutex_t mutex;
 	DARRAY(struct image_file_data) files;
+	uint64_t files_id;
+	uint64_t use_count;
+
+	bool preload;
+	uint64_t memory_limit;
+
+	pthread_t load_thread;
+	os_sem_t *load_sem;
+	volatile bool stop_loading;
+	bool load_thread_active;
 
 	enum behavior behavior;
 
@@ -167,6 +192,259 @@ static inline size_t random_file(struct slideshow *ss)
 	return (size_t)rand() % ss->files.num;
 }
 
+static inline size_t prev_file(struct slideshow *ss, size_t idx)
+{
+	return idx == 0 ? ss->files.num - 1 : idx - 1;
+}
+
+static inline bool file_failed(struct slideshow *ss, size_t idx)
+{
+	bool failed;
+
+	pthread_mutex_lock(&ss->mutex);
+	failed = idx < ss->files.num && ss->files.array[idx].load_failed;
+	pthread_mutex_unlock(&ss->mutex);
+
+	return failed;
+}
+
+/* files that failed to load are kept in the list when not preloading, so
+ * they are skipped when moving to another slide.  returns idx if all other
+ * files failed to load */
+static size_t step_file(struct slideshow *ss, size_t idx, bool forward)
+{
+	size_t num = ss->files.num;
+	size_t next = idx;
+
+	pthread_mutex_lock(&ss->mutex);
+	for (size_t i = 1; i < num; i++) {
+		size_t other = forward ?
+			(idx + i) % num : (idx + num - i) % num;
+
+		if (!ss->files.array[other].load_failed) {
+			next = other;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&ss->mutex);
+
+	return next;
+}
+
+static inline bool last_slide(struct slideshow *ss)
+{
+	return step_file(ss, ss->cur_item, true) <= ss->cur_item;
+}
+
+/* the next slide is picked ahead of time (even when randomizing) so that it
+ * can be loaded in the background before it is needed */
+static void update_next_item(struct slideshow *ss)
+{
+	if (ss->next_item_base == ss->cur_item &&
+	    ss->next_item < ss->files.num &&
+	    !file_failed(ss, ss->next_item))
+		return;
+
+	if (ss->randomize && ss->files.num > 1) {
+		size_t next = random_file(ss);
+		if (next == ss->cur_item || file_failed(ss, next))
+			next = step_file(ss, next, true);
+		ss->next_item = next;
+
+	} else {
+		ss->next_item = step_file(ss, ss->cur_item, true);
+	}
+
+	ss->next_item_base = ss->cur_item;
+}
+
+static obs_source_t *get_slide_source(struct slideshow *ss, size_t idx,
+		bool *loading)
+{
+	obs_source_t *source = NULL;
+
+	pthread_mutex_lock(&ss->mutex);
+	if (idx < ss->files.num) {
+		struct image_file_data *file = &ss->files.array[idx];
+
+		source = file->source;
+		obs_source_addref(source);
+		file->last_used = ++ss->use_count;
+
+		if (loading)
+			*loading = !source && !file->load_failed;
+	}
+	pthread_mutex_unlock(&ss->mutex);
+
+	return source;
+}
+
+/* ------------------------------------------------------------------------- */
+/* background loading                                                        */
+
+static inline bool slide_wanted(struct slideshow *ss, size_t idx)
+{
+	return idx == ss->cur_item || idx == ss->next_item ||
+		idx == prev_file(ss, ss->cur_item);
+}
+
+static size_t find_unloaded_slide(struct slideshow *ss)
+{
+	size_t wanted[3];
+
+	if (ss->preload || !ss->files.num)
+		return DARRAY_INVALID;
+
+	wanted[0] = ss->cur_item;
+	wanted[1] = ss->next_item;
+	wanted[2] = prev_file(ss, ss->cur_item);
+
+	for (size_t i = 0; i < 3; i++) {
+		size_t idx = wanted[i];
+		struct image_file_data *file;
+
+		if (idx >= ss->files.num)
+			continue;
+
+		file = &ss->files.array[idx];
+		if (!file->source && !file->load_failed)
+			return idx;
+	}
+
+	return DARRAY_INVALID;
+}
+
+static bool load_next_slide(struct slideshow *ss)
+{
+	obs_source_t *source;
+	uint64_t files_id = 0;
+	char *path = NULL;
+	size_t idx;
+
+	pthread_mutex_lock(&ss->mutex);
+	idx = find_unloaded_slide(ss);
+	if (idx != DARRAY_INVALID) {
+		path = bstrdup(ss->files.array[idx].path);
+		files_id = ss->files_id;
+	}
+	pthread_mutex_unlock(&ss->mutex);
+
+	if (!path)
+		return false;
+
+	source = create_source_from_file(path);
+
+	/* the file list may have been replaced while decoding */
+	pthread_mutex_lock(&ss->mutex);
+	if (files_id == ss->files_id) {
+		struct image_file_data *file = &ss->files.array[idx];
+
+		if (!source) {
+			file->load_failed = true;
+		} else if (!file->source) {
+			file->source = source;
+			source = NULL;
+		}
+	}
+	pthread_mutex_unlock(&ss->mutex);
+
+	obs_source_release(source);
+	bfree(path);
+	return true;
+}
+
+static inline uint64_t slide_memory_usage(obs_source_t *source)
+{
+	return (uint64_t)obs_source_get_width(source) *
+		(uint64_t)obs_source_get_height(source) * 4;
+}
+
+static void release_unused_slides(struct slideshow *ss)
+{
+	DARRAY(obs_source_t*) released;
+	uint64_t total = 0;
+
+	da_init(released);
+
+	pthread_mutex_lock(&ss->mutex);
+
+	if (ss->preload)
+		goto unlock;
+
+	for (size_t i = 0; i < ss->files.num; i++) {
+		obs_source_t *source = ss->files.array[i].source;
+		if (source)
+			total += slide_memory_usage(source);
+	}
+
+	/* release the least recently shown slides first, but never the
+	 * previous, current or next slide */
+	while (total > ss->memory_limit) {
+		struct image_file_data *oldest = NULL;
+
+		for (size_t i = 0; i < ss->files.num; i++) {
+			struct image_file_data *file = &ss->files.array[i];
+
+			if (!file->source || slide_wanted(ss, i))
+				continue;
+			if (!oldest || file->last_used < oldest->last_used)
+				oldest = file;
+		}
+
+		if (!oldest)
+			break;
+
+		total -= slide_memory_usage(oldest->source);
+		da_push_back(released, &oldest->source);
+		oldest->source = NULL;
+	}
+
+unlock:
+	pthread_mutex_unlock(&ss->mutex);
+
+	for (size_t i = 0; i < released.num; i++)
+		obs_source_release(released.array[i]);
+	da_free(released);
+}
+
+static void *load_thread(void *data)
+{
+	struct slideshow *ss = data;
+
+	os_set_thread_name("slideshow: load_thread");
+
+	while (os_sem_wait(ss->load_sem) == 0) {
+		if (os_atomic_load_bool(&ss->stop_loading))
+			break;
+
+		while (load_next_slide(ss));
+		release_unused_slides(ss);
+	}
+
+	return NULL;
+}
+
+static inline void request_slides(struct slideshow *ss)
+{
+	if (!ss->preload && ss->load_thread_active)
+		os_sem_post(ss->load_sem);
+}
+
+/* moves on to the next slide if the current one failed to load.  returns
+ * false if there is no other slide left to try */
+static bool skip_failed_slide(struct slideshow *ss)
+{
+	size_t next = step_file(ss, ss->cur_item, true);
+
+	if (next == ss->cur_item)
+		return false;
+
+	ss->cur_item = next;
+	update_next_item(ss);
+	request_slides(ss);
+	return true;
+}
+
 /* ------------------------------------------------------------------------- */
 
 static const char *ss_getname(void *unused)
@@ -190,6 +468,20 @@ static void add_file(struct slideshow *ss, struct darray *array,
 
 	if (!new_source)
 		new_source = get_source(&new_files.da, path);
+
+	/* slides that are not preloaded are loaded by the load thread once
+	 * they are about to be shown */
+	if (!ss->preload) {
+		data.path = bstrdup(path);
+		data.source = new_source;
+		data.last_used = 0;
+		data.load_failed = false;
+		da_push_back(new_files, &data);
+
+		*array = new_files.da;
+		return;
+	}
+
 	if (!new_source)
 		new_source = create_source_from_file(path);
 
@@ -199,6 +491,8 @@ static void add_file(struct slideshow *ss, struct darray *array,
 
 		data.path = bstrdup(path);
 		data.source = new_source;
+		data.last_used = 0;
+		data.load_failed = false;
 		da_push_back(new_files, &data);
 
 		if (new_cx > *cx) *cx = new_cx;
@@ -229,22 +523,40 @@ static void do_transition(void *data, bool to_null)
 {
 	struct slideshow *ss = data;
 	bool valid = item_valid(ss);
+	obs_source_t *source = NULL;
+
+	if (valid && (ss->use_cut || !to_null)) {
+		bool loading = false;
+
+		update_next_item(ss);
+		source = get_slide_source(ss, ss->cur_item, &loading);
+		request_slides(ss);
+
+		/* retried from the video tick once the slide is loaded */
+		if (loading || (!source && skip_failed_slide(ss))) {
+			ss->transition_pending = true;
+			return;
+		}
+	}
+
+	ss->transition_pending = false;
 
 	if (valid && ss->use_cut)
-		obs_transition_set(ss->transition,
-				ss->files.array[ss->cur_item].source);
+		obs_transition_set(ss->transition, source);
 
 	else if (valid && !to_null)
 		obs_transition_start(ss->transition,
 				OBS_TRANSITION_MODE_AUTO,
 				ss->tr_speed,
-				ss->files.array[ss->cur_item].source);
+				source);
 
 	else
 		obs_transition_start(ss->transition,
 				OBS_TRANSITION_MODE_AUTO,
 				ss->tr_speed,
 				NULL);
+
+	obs_source_release(source);
 }
 
 static void ss_update(void *data, obs_data_t *settings)
@@ -263,6 +575,7 @@ static void ss_update(void *data, obs_data_t *settings)
 	size_t count;
 	const char *behavior;
 	const char *mode;
+	long long memory_limit;
 
 	/* ------------------------------------- */
 	/* get settings data */
@@ -296,6 +609,15 @@ static void ss_update(void *data, obs_data_t *settings)
 	ss->loop = obs_data_get_bool(settings, S_LOOP);
 	ss->hide = obs_data_get_bool(settings, S_HIDE);
 
+	memory_limit = obs_data_get_int(settings, S_MEMORY_LIMIT);
+	if (memory_limit < MIN_MEMORY_LIMIT_MB)
+		memory_limit = MIN_MEMORY_LIMIT_MB;
+
+	pthread_mutex_lock(&ss->mutex);
+	ss->preload = obs_data_get_bool(settings, S_PRELOAD);
+	ss->memory_limit = (uint64_t)memory_limit * 1024 * 1024;
+	pthread_mutex_unlock(&ss->mutex);
+
 	if (!ss->tr_name || strcmp(tr_name, ss->tr_name) != 0)
 		new_tr = obs_source_create_private(tr_name, NULL, NULL);
 
@@ -353,6 +675,8 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	old_files.da = ss->files.da;
 	ss->files.da = new_files.da;
+	ss->files_id++;
+	ss->next_item = DARRAY_INVALID;
 	if (new_tr) {
 		old_tr = ss->transition;
 		ss->transition = new_tr;
@@ -378,6 +702,17 @@ static void ss_update(void *data, obs_data_t *settings)
 
 	/* ------------------------- */
 
+	/* images are not loaded up front, so there is no image size to go
+	 * by; use the canvas size instead */
+	if (!ss->preload) {
+		struct obs_video_info ovi;
+
+		if (obs_get_video_info(&ovi)) {
+			cx = ovi.base_width;
+			cy = ovi.base_height;
+		}
+	}
+
 	const char *res_str = obs_data_get_string(settings, S_CUSTOM_SIZE);
 	bool aspect_only = false, use_auto = true;
 	int cx_in = 0, cy_in = 0;
@@ -449,11 +784,24 @@ static void ss_restart(void *data)
 {
 	struct slideshow *ss = data;
 
+	obs_source_t *source;
+	bool loading = false;
+
 	ss->elapsed = 0.0f;
 	ss->cur_item = 0;
 
-	obs_transition_set(ss->transition,
-			ss->files.array[ss->cur_item].source);
+	update_next_item(ss);
+	source = get_slide_source(ss, ss->cur_item, &loading);
+	request_slides(ss);
+
+	if (loading || (!source && skip_failed_slide(ss))) {
+		ss->transition_pending = true;
+	} else {
+		obs_transition_set(ss->transition, source);
+		ss->transition_pending = false;
+	}
+
+	obs_source_release(source);
 
 	ss->stop = false;
 	ss->paused = false;
@@ -478,9 +826,7 @@ static void ss_next_slide(void *data)
 	if (!ss->files.num)
 		return;
 
-	if (++ss->cur_item >= ss->files.num)
-		ss->cur_item = 0;
-
+	ss->cur_item = step_file(ss, ss->cur_item, true);
 	do_transition(ss, false);
 }
 
@@ -491,11 +837,7 @@ static void ss_previous_slide(void *data)
 	if (!ss->files.num)
 		return;
 
-	if (ss->cur_item == 0)
-		ss->cur_item = ss->files.num - 1;
-	else
-		--ss->cur_item;
-
+	ss->cur_item = step_file(ss, ss->cur_item, false);
 	do_transition(ss, false);
 }
 
@@ -569,6 +911,13 @@ static void ss_destroy(void *data)
 {
 	struct slideshow *ss = data;
 
+	if (ss->load_thread_active) {
+		os_atomic_set_bool(&ss->stop_loading, true);
+		os_sem_post(ss->load_sem);
+		pthread_join(ss->load_thread, NULL);
+	}
+
+	os_sem_destroy(ss->load_sem);
 	obs_source_release(ss->transition);
 	free_files(&ss->files.da);
 	pthread_mutex_destroy(&ss->mutex);
@@ -613,6 +962,12 @@ static void *ss_create(obs_data_t *settings, obs_source_t *source)
 	pthread_mutex_init_value(&ss->mutex);
 	if (pthread_mutex_init(&ss->mutex, NULL) != 0)
 		goto error;
+	if (os_sem_init(&ss->load_sem, 0) != 0)
+		goto error;
+	if (pthread_create(&ss->load_thread, NULL, load_thread, ss) != 0)
+		goto error;
+
+	ss->load_thread_active = true;
 
 	obs_source_update(source, NULL);
 
@@ -644,6 +999,13 @@ static void ss_video_tick(void *data, float seconds)
 	if (!ss->transition || !ss->slide_time)
 		return;
 
+	/* hold the current slide until the next one has been loaded */
+	if (ss->transition_pending) {
+		do_transition(ss, false);
+		if (ss->transition_pending)
+			return;
+	}
+
 	if (ss->restart_on_activate && !ss->randomize && ss->use_cut) {
 		ss->elapsed = 0.0f;
 		ss->cur_item = 0;
@@ -676,7 +1038,7 @@ static void ss_video_tick(void *data, float seconds)
 	if (ss->elapsed > ss->slide_time) {
 		ss->elapsed -= ss->slide_time;
 
-		if (!ss->loop && ss->cur_item == ss->files.num - 1) {
+		if (!ss->loop && ss->files.num && last_slide(ss)) {
 			if (ss->hide)
 				do_transition(ss, true);
 			else
@@ -686,15 +1048,11 @@ static void ss_video_tick(void *data, float seconds)
 		}
 
 		if (ss->randomize) {
-			size_t next = ss->cur_item;
-			if (ss->files.num > 1) {
-				while (next == ss->cur_item)
-					next = random_file(ss);
-			}
-			ss->cur_item = next;
+			update_next_item(ss);
+			ss->cur_item = ss->next_item;
 
-		} else if (++ss->cur_item >= ss->files.num) {
-			ss->cur_item = 0;
+		} else {
+			ss->cur_item = step_file(ss, ss->cur_item, true);
 		}
 
 		if (ss->files.num)
@@ -786,6 +1144,9 @@ static void ss_defaults(obs_data_t *settings)
 			S_BEHAVIOR_ALWAYS_PLAY);
 	obs_data_set_default_string(settings, S_MODE, S_MODE_AUTO);
 	obs_data_set_default_bool(settings, S_LOOP, true);
+	obs_data_set_default_bool(settings, S_PRELOAD, true);
+	obs_data_set_default_int(settings, S_MEMORY_LIMIT,
+			DEFAULT_MEMORY_LIMIT_MB);
 }
 
 static const char *file_filter =
@@ -800,6 +1161,17 @@ static const char *aspects[] = {
 
 #define NUM_ASPECTS (sizeof(aspects) / sizeof(const char *))
 
+static bool preload_modified(obs_properties_t *ppts, obs_property_t *p,
+		obs_data_t *settings)
+{
+	bool preload = obs_data_get_bool(settings, S_PRELOAD);
+
+	p = obs_properties_get(ppts, S_MEMORY_LIMIT);
+	obs_property_set_visible(p, !preload);
+
+	return true;
+}
+
 static obs_properties_t *ss_properties(void *data)
 {
 	obs_properties_t *ppts = obs_properties_create();
@@ -847,6 +1219,11 @@ static obs_properties_t *ss_properties(void *data)
 	obs_properties_add_bool(ppts, S_HIDE, T_HIDE);
 	obs_properties_add_bool(ppts, S_RANDOMIZE, T_RANDOMIZE);
 
+	p = obs_properties_add_bool(ppts, S_PRELOAD, T_PRELOAD);
+	obs_property_set_modified_callback(p, preload_modified);
+	obs_properties_add_int(ppts, S_MEMORY_LIMIT, T_MEMORY_LIMIT,
+			MIN_MEMORY_LIMIT_MB, MAX_MEMORY_LIMIT_MB, 16);
+
 	p = obs_properties_add_list(ppts, S_CUSTOM_SIZE, T_CUSTOM_SIZE,
 			OBS_COMBO_TYPE_EDITABLE, OBS_COMBO_FORMAT_STRING);
 
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <obs-module.h>
 #include <graphics/matrix4.h>
 #include <graphics/quat.h>
+#include <util/platform.h>
 
 
 #define SETTING_GAMMA                  "gamma"
@@ -42,6 +43,7 @@ struct color_correction_filter_data {
 
 	gs_eparam_t                    *gamma_param;
 	gs_eparam_t                    *final_matrix_param;
+	char                           *fused_code;
 
 	struct vec3                     gamma;
 	float                           contrast;
@@ -251,6 +253,7 @@ static void color_correction_filter_destroy(void *data)
 		obs_leave_graphics();
 	}
 
+	bfree(filter->fused_code);
 	bfree(data);
 }
 
@@ -303,6 +306,11 @@ static void *color_correction_filter_create(obs_data_t *settings,
 
 	bfree(effect_path);
 
+	/* Per-pixel code used when drawn together with other filters. */
+	effect_path = obs_module_file("fused/color_correction.effect");
+	filter->fused_code = os_quick_read_utf8_file(effect_path);
+	bfree(effect_path);
+
 	/*
 	 * If the filter has been removed/deactivated, destroy the filter
 	 * and exit out so we don't crash OBS by telling it to update
@@ -340,6 +348,24 @@ static void color_correction_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static const char *color_correction_filter_fused_code(void *data)
+{
+	struct color_correction_filter_data *filter = data;
+	return filter->fused_code;
+}
+
+/* Same as the render function, but for the fused effect's parameters. */
+static void color_correction_filter_fused_render(void *data,
+		gs_effect_t *effect, const char *prefix)
+{
+	struct color_correction_filter_data *filter = data;
+
+	gs_effect_set_vec3(obs_fused_effect_get_param(effect, prefix,
+				"gamma"), &filter->gamma);
+	gs_effect_set_matrix4(obs_fused_effect_get_param(effect, prefix,
+				"color_matrix"), &filter->final_matrix);
+}
+
 /*
  * This function sets the interface. the types (add_*_Slider), the type of
  * data collected (int), the internal name, user-facing name, minimum,
@@ -402,12 +428,14 @@ static void color_correction_filter_defaults(obs_data_t *settings)
 struct obs_source_info color_filter = {
 	.id = "color_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = color_correction_filter_name,
 	.create = color_correction_filter_create,
 	.destroy = color_correction_filter_destroy,
 	.video_render = color_correction_filter_render,
 	.update = color_correction_filter_update,
 	.get_properties = color_correction_filter_properties,
-	.get_defaults = color_correction_filter_defaults
+	.get_defaults = color_correction_filter_defaults,
+	.get_fused_code = color_correction_filter_fused_code,
+	.fused_render = color_correction_filter_fused_render
 };
@@ -1,6 +1,7 @@
 #include <obs-module.h>
 #include <graphics/image-file.h>
 #include <util/dstr.h>
+#include <util/platform.h>
 
 #define SETTING_IMAGE_PATH             "image_path"
 #define SETTING_CLUT_AMOUNT            "clut_amount"
@@ -16,6 +17,8 @@ struct lut_filter_data {
 
 	char                           *file;
 	float                          clut_amount;
+
+	char                           *fused_code;
 };
 
 static const char *color_grade_filter_get_name(void *unused)
@@ -105,7 +108,11 @@ static void *color_grade_filter_create(
 {
 	struct lut_filter_data *filter =
 		bzalloc(sizeof(struct lut_filter_data));
+	char *fused_path = obs_module_file("fused/color_grade.effect");
+
 	filter->context = context;
+	filter->fused_code = os_quick_read_utf8_file(fused_path);
+	bfree(fused_path);
 
 	obs_source_update(context, settings);
 	return filter;
@@ -120,6 +127,7 @@ static void color_grade_filter_destroy(void *data)
 	gs_image_file_free(&filter->image);
 	obs_leave_graphics();
 
+	bfree(filter->fused_code);
 	bfree(filter->file);
 	bfree(filter);
 }
@@ -150,15 +158,37 @@ static void color_grade_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static const char *color_grade_filter_fused_code(void *data)
+{
+	struct lut_filter_data *filter = data;
+
+	/* without a LUT the filter skips itself */
+	return filter->target ? filter->fused_code : NULL;
+}
+
+static void color_grade_filter_fused_render(void *data, gs_effect_t *effect,
+		const char *prefix)
+{
+	struct lut_filter_data *filter = data;
+
+	gs_effect_set_texture(obs_fused_effect_get_param(effect, prefix,
+				"clut"), filter->target);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"clut_amount"), filter->clut_amount);
+}
+
 struct obs_source_info color_grade_filter = {
 	.id                            = "clut_filter",
 	.type                          = OBS_SOURCE_TYPE_FILTER,
-	.output_flags                  = OBS_SOURCE_VIDEO,
+	.output_flags                  = OBS_SOURCE_VIDEO |
+	                                 OBS_SOURCE_STATIC_VIDEO,
 	.get_name                      = color_grade_filter_get_name,
 	.create                        = color_grade_filter_create,
 	.destroy                       = color_grade_filter_destroy,
 	.update                        = color_grade_filter_update,
 	.get_defaults                  = color_grade_filter_defaults,
 	.get_properties                = color_grade_filter_properties,
-	.video_render                  = color_grade_filter_render
+	.video_render                  = color_grade_filter_render,
+	.get_fused_code                = color_grade_filter_fused_code,
+	.fused_render                  = color_grade_filter_fused_render
 };
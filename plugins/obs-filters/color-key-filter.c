@@ -2,6 +2,7 @@
 #include <graphics/matrix4.h>
 #include <graphics/vec2.h>
 #include <graphics/vec4.h>
+#include <util/platform.h>
 
 #define SETTING_OPACITY                "opacity"
 #define SETTING_CONTRAST               "contrast"
@@ -35,6 +36,8 @@ struct color_key_filter_data {
 	gs_eparam_t                    *similarity_param;
 	gs_eparam_t                    *smoothness_param;
 
+	char                           *fused_code;
+
 	struct vec4                    color;
 	float                          contrast;
 	float                          brightness;
@@ -118,6 +121,7 @@ static void color_key_destroy(void *data)
 		obs_leave_graphics();
 	}
 
+	bfree(filter->fused_code);
 	bfree(data);
 }
 
@@ -153,6 +157,10 @@ static void *color_key_create(obs_data_t *settings, obs_source_t *context)
 
 	bfree(effect_path);
 
+	effect_path = obs_module_file("fused/color_key.effect");
+	filter->fused_code = os_quick_read_utf8_file(effect_path);
+	bfree(effect_path);
+
 	if (!filter->effect) {
 		color_key_destroy(filter);
 		return NULL;
@@ -183,6 +191,33 @@ static void color_key_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static const char *color_key_fused_code(void *data)
+{
+	struct color_key_filter_data *filter = data;
+	return filter->fused_code;
+}
+
+static void color_key_fused_render(void *data, gs_effect_t *effect,
+		const char *prefix)
+{
+	struct color_key_filter_data *filter = data;
+
+	gs_effect_set_vec4(obs_fused_effect_get_param(effect, prefix,
+				"opacity_color"), &filter->color);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"contrast"), filter->contrast);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"brightness"), filter->brightness);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"gamma"), filter->gamma);
+	gs_effect_set_vec4(obs_fused_effect_get_param(effect, prefix,
+				"key_color"), &filter->key_color);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"similarity"), filter->similarity);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"smoothness"), filter->smoothness);
+}
+
 static bool key_type_changed(obs_properties_t *props, obs_property_t *p,
 		obs_data_t *settings)
 {
@@ -245,12 +280,15 @@ static void color_key_defaults(obs_data_t *settings)
 struct obs_source_info color_key_filter = {
 	.id                            = "color_key_filter",
 	.type                          = OBS_SOURCE_TYPE_FILTER,
-	.output_flags                  = OBS_SOURCE_VIDEO,
+	.output_flags                  = OBS_SOURCE_VIDEO |
+	                                 OBS_SOURCE_STATIC_VIDEO,
 	.get_name                      = color_key_name,
 	.create                        = color_key_create,
 	.destroy                       = color_key_destroy,
 	.video_render                  = color_key_render,
 	.update                        = color_key_update,
 	.get_properties                = color_key_properties,
-	.get_defaults                  = color_key_defaults
+	.get_defaults                  = color_key_defaults,
+	.get_fused_code                = color_key_fused_code,
+	.fused_render                  = color_key_fused_render
 };
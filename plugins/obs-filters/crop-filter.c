@@ -1,5 +1,6 @@
 #include <obs-module.h>
 #include <graphics/vec2.h>
+#include <util/platform.h>
 
 struct crop_filter_data {
 	obs_source_t                   *context;
@@ -20,6 +21,8 @@ struct crop_filter_data {
 
 	struct vec2                    mul_val;
 	struct vec2                    add_val;
+
+	char                           *fused_code;
 };
 
 static const char *crop_filter_get_name(void *unused)
@@ -46,6 +49,10 @@ static void *crop_filter_create(obs_data_t *settings, obs_source_t *context)
 		return NULL;
 	}
 
+	effect_path = obs_module_file("fused/crop.effect");
+	filter->fused_code = os_quick_read_utf8_file(effect_path);
+	bfree(effect_path);
+
 	filter->param_mul = gs_effect_get_param_by_name(filter->effect,
 			"mul_val");
 	filter->param_add = gs_effect_get_param_by_name(filter->effect,
@@ -63,6 +70,7 @@ static void crop_filter_destroy(void *data)
 	gs_effect_destroy(filter->effect);
 	obs_leave_graphics();
 
+	bfree(filter->fused_code);
 	bfree(filter);
 }
 
@@ -195,6 +203,23 @@ static void crop_filter_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static const char *crop_filter_fused_code(void *data)
+{
+	struct crop_filter_data *filter = data;
+	return filter->fused_code;
+}
+
+static void crop_filter_fused_render(void *data, gs_effect_t *effect,
+		const char *prefix)
+{
+	struct crop_filter_data *filter = data;
+
+	gs_effect_set_vec2(obs_fused_effect_get_param(effect, prefix,
+				"mul_val"), &filter->mul_val);
+	gs_effect_set_vec2(obs_fused_effect_get_param(effect, prefix,
+				"add_val"), &filter->add_val);
+}
+
 static uint32_t crop_filter_width(void *data)
 {
 	struct crop_filter_data *crop = data;
@@ -210,7 +235,8 @@ static uint32_t crop_filter_height(void *data)
 struct obs_source_info crop_filter = {
 	.id                            = "crop_filter",
 	.type                          = OBS_SOURCE_TYPE_FILTER,
-	.output_flags                  = OBS_SOURCE_VIDEO,
+	.output_flags                  = OBS_SOURCE_VIDEO |
+	                                 OBS_SOURCE_STATIC_VIDEO,
 	.get_name                      = crop_filter_get_name,
 	.create                        = crop_filter_create,
 	.destroy                       = crop_filter_destroy,
@@ -220,5 +246,7 @@ struct obs_source_info crop_filter = {
 	.video_tick                    = crop_filter_tick,
 	.video_render                  = crop_filter_render,
 	.get_width                     = crop_filter_width,
-	.get_height                    = crop_filter_height
+	.get_height                    = crop_filter_height,
+	.get_fused_code                = crop_filter_fused_code,
+	.fused_render                  = crop_filter_fused_render
 };
@@ -227,7 +227,8 @@ static uint32_t scroll_filter_height(void *data)
 struct obs_source_info scroll_filter = {
 	.id                            = "scroll_filter",
 	.type                          = OBS_SOURCE_TYPE_FILTER,
-	.output_flags                  = OBS_SOURCE_VIDEO,
+	.output_flags                  = OBS_SOURCE_VIDEO |
+	                                 OBS_SOURCE_PARALLEL_TICK,
 	.get_name                      = scroll_filter_get_name,
 	.create                        = scroll_filter_create,
 	.destroy                       = scroll_filter_destroy,
@@ -12,6 +12,8 @@ struct sharpness_data {
 
 	float                          sharpness;
 	float                          texwidth, texheight;
+
+	char                           *fused_code;
 };
 
 static const char *sharpness_getname(void *unused)
@@ -38,6 +40,7 @@ static void sharpness_destroy(void *data)
 		obs_leave_graphics();
 	}
 
+	bfree(filter->fused_code);
 	bfree(data);
 }
 
@@ -65,6 +68,10 @@ static void *sharpness_create(obs_data_t *settings, obs_source_t *context)
 
 	bfree(effect_path);
 
+	effect_path = obs_module_file("fused/sharpness.effect");
+	filter->fused_code = os_quick_read_utf8_file(effect_path);
+	bfree(effect_path);
+
 	if (!filter->effect) {
 		sharpness_destroy(filter);
 		return NULL;
@@ -96,6 +103,29 @@ static void sharpness_render(void *data, gs_effect_t *effect)
 	UNUSED_PARAMETER(effect);
 }
 
+static const char *sharpness_fused_code(void *data)
+{
+	struct sharpness_data *filter = data;
+	return filter->fused_code;
+}
+
+static void sharpness_fused_render(void *data, gs_effect_t *effect,
+		const char *prefix)
+{
+	struct sharpness_data *filter = data;
+	obs_source_t *target = obs_filter_get_target(filter->context);
+
+	filter->texwidth = (float)obs_source_get_width(target);
+	filter->texheight = (float)obs_source_get_height(target);
+
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"sharpness"), filter->sharpness);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"texture_width"), filter->texwidth);
+	gs_effect_set_float(obs_fused_effect_get_param(effect, prefix,
+				"texture_height"), filter->texheight);
+}
+
 static obs_properties_t *sharpness_properties(void *data)
 {
 	obs_properties_t *props = obs_properties_create();
@@ -115,12 +145,14 @@ static void sharpness_defaults(obs_data_t *settings)
 struct obs_source_info sharpness_filter = {
 	.id = "sharpness_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = sharpness_getname,
 	.create = sharpness_create,
 	.destroy = sharpness_destroy,
 	.update = sharpness_update,
 	.video_render = sharpness_render,
 	.get_properties = sharpness_properties,
-	.get_defaults = sharpness_defaults
+	.get_defaults = sharpness_defaults,
+	.get_fused_code = sharpness_fused_code,
+	.fused_render = sharpness_fused_render
 };
@@ -33,6 +33,7 @@
 #include "log.h"
 
 #include <util/platform.h>
+#include <util/threading.h>
 
 #ifdef CRYPTO
 
@@ -146,8 +147,24 @@ static void HandleCtrl(RTMP *r, const RTMPPacket *packet);
 static void HandleServerBW(RTMP *r, const RTMPPacket *packet);
 static void HandleClientBW(RTMP *r, const RTMPPacket *packet);
 
+#ifdef _WIN32
+typedef WSABUF RTMPIOVec;
+#define IOV_SET(v, p, l) ((v).buf = (char *)(p), (v).len = (ULONG)(l))
+#define IOV_BASE(v) ((v).buf)
+#define IOV_LEN(v) ((v).len)
+#else
+typedef struct iovec RTMPIOVec;
+#define IOV_SET(v, p, l) ((v).iov_base = (void *)(p), (v).iov_len = (size_t)(l))
+#define IOV_BASE(v) ((char *)(v).iov_base)
+#define IOV_LEN(v) ((v).iov_len)
+#endif
+
+/* max buffers per vectored write; chunk headers and chunk data each take one */
+#define RTMP_MAX_IOV 1024
+
 static int ReadN(RTMP *r, char *buffer, int n);
 static int WriteN(RTMP *r, const char *buffer, int n);
+static int WriteV(RTMP *r, RTMPIOVec *iov, int iovcnt);
 
 static void DecodeTEA(AVal *key, AVal *text);
 
@@ -1453,6 +1470,7 @@ WriteN(RTMP *r, const char *buffer, int n)
             nBytes = r->m_customSendFunc(&r->m_sb, ptr, n, r->m_customSendParam);
         else
             nBytes = RTMPSockBuf_Send(&r->m_sb, ptr, n);
+        os_atomic_inc_long(&r->m_nSendCalls);
         /*RTMP_Log(RTMP_LOGDEBUG, "%s: %d\n", __FUNCTION__, nBytes); */
 
         if (nBytes < 0)
@@ -1486,6 +1504,119 @@ WriteN(RTMP *r, const char *buffer, int n)
     return n == 0;
 }
 
+/* vectored sends can only be used when the data goes to the socket as is */
+static int
+CanWriteV(RTMP *r)
+{
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+        return FALSE;
+    if (r->m_bCustomSend && r->m_customSendFunc)
+        return FALSE;
+#ifdef CRYPTO
+    if (r->Link.rc4keyOut || r->m_sb.sb_ssl)
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+static int
+SendV(RTMP *r, RTMPIOVec *iov, int iovcnt)
+{
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(r->m_sb.sb_socket, iov, (DWORD)iovcnt, &sent, 0, NULL, NULL) != 0)
+        return -1;
+    return (int)sent;
+#else
+    struct msghdr msg;
+    int flags = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+#ifdef MSG_MORE
+    if (r->m_bSendMore)
+        flags |= MSG_MORE;
+#endif
+    return (int)sendmsg(r->m_sb.sb_socket, &msg, flags);
+#endif
+}
+
+static int
+WriteV(RTMP *r, RTMPIOVec *iov, int iovcnt)
+{
+    if (!CanWriteV(r))
+    {
+        char *buf, *ptr;
+        int total = 0;
+        int ret;
+
+        for (int i = 0; i < iovcnt; i++)
+            total += (int)IOV_LEN(iov[i]);
+
+        buf = malloc(total);
+        if (!buf)
+            return FALSE;
+
+        ptr = buf;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            memcpy(ptr, IOV_BASE(iov[i]), IOV_LEN(iov[i]));
+            ptr += IOV_LEN(iov[i]);
+        }
+
+        ret = WriteN(r, buf, total);
+        free(buf);
+        return ret;
+    }
+
+    while (iovcnt > 0)
+    {
+        int nBytes;
+
+#if defined(RTMP_NETSTACK_DUMP)
+        for (int i = 0; i < iovcnt; i++)
+            fwrite(IOV_BASE(iov[i]), 1, IOV_LEN(iov[i]), netstackdump);
+#endif
+
+        nBytes = SendV(r, iov, iovcnt);
+        os_atomic_inc_long(&r->m_nSendCalls);
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d", __FUNCTION__,
+                     sockerr);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            r->last_error_code = sockerr;
+
+            RTMP_Close(r);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        /* skip past whatever was written, partial writes are resumed in the
+         * middle of a buffer */
+        while (iovcnt > 0 && (size_t)nBytes >= (size_t)IOV_LEN(*iov))
+        {
+            nBytes -= (int)IOV_LEN(*iov);
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0 && nBytes > 0)
+            IOV_SET(*iov, IOV_BASE(*iov) + nBytes, IOV_LEN(*iov) - nBytes);
+    }
+
+    return TRUE;
+}
+
 #define SAVC(x)	static const AVal av_##x = AVC(#x)
 
 SAVC(app);
@@ -4103,26 +4234,69 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
             toff = tbuf;
         }
     }
-    while (nSize + hSize)
+    if (!tbuf)
     {
-        int wrote;
+        /* the first chunk is sent with the packet header directly in front
+         * of it, every following chunk is preceded by the same continuation
+         * header, so all chunks of the packet are gathered into a single
+         * vectored write instead of one write per chunk */
+        RTMPIOVec iov[RTMP_MAX_IOV];
+        char chunkHeader[3];
+        int chunkHeaderSize = 1 + cSize;
+        int iovcnt = 0;
+
+        chunkHeader[0] = (0xc0 | c);
+        if (cSize)
+        {
+            int tmp = packet->m_nChannel - 64;
+            chunkHeader[1] = tmp & 0xff;
+            if (cSize == 2)
+                chunkHeader[2] = tmp >> 8;
+        }
 
         if (nSize < nChunkSize)
             nChunkSize = nSize;
 
         RTMP_LogHexString(RTMP_LOGDEBUG2, (uint8_t *)header, hSize);
         RTMP_LogHexString(RTMP_LOGDEBUG2, (uint8_t *)buffer, nChunkSize);
-        if (tbuf)
-        {
-            memcpy(toff, header, nChunkSize + hSize);
-            toff += nChunkSize + hSize;
-        }
-        else
+        IOV_SET(iov[iovcnt], header, nChunkSize + hSize);
+        iovcnt++;
+        nSize -= nChunkSize;
+        buffer += nChunkSize;
+
+        while (nSize > 0)
         {
-            wrote = WriteN(r, header, nChunkSize + hSize);
-            if (!wrote)
-                return FALSE;
+            if (nSize < nChunkSize)
+                nChunkSize = nSize;
+
+            if (iovcnt + 2 > RTMP_MAX_IOV)
+            {
+                if (!WriteV(r, iov, iovcnt))
+                    return FALSE;
+                iovcnt = 0;
+            }
+
+            RTMP_LogHexString(RTMP_LOGDEBUG2, (uint8_t *)buffer, nChunkSize);
+            IOV_SET(iov[iovcnt], chunkHeader, chunkHeaderSize);
+            iovcnt++;
+            IOV_SET(iov[iovcnt], buffer, nChunkSize);
+            iovcnt++;
+            nSize -= nChunkSize;
+            buffer += nChunkSize;
         }
+
+        if (!WriteV(r, iov, iovcnt))
+            return FALSE;
+    }
+    while (tbuf && nSize + hSize)
+    {
+        if (nSize < nChunkSize)
+            nChunkSize = nSize;
+
+        RTMP_LogHexString(RTMP_LOGDEBUG2, (uint8_t *)header, hSize);
+        RTMP_LogHexString(RTMP_LOGDEBUG2, (uint8_t *)buffer, nChunkSize);
+        memcpy(toff, header, nChunkSize + hSize);
+        toff += nChunkSize + hSize;
         nSize -= nChunkSize;
         buffer += nChunkSize;
         hSize = 0;
@@ -290,6 +290,8 @@ extern "C"
         uint8_t m_bSendCounter;
 
         uint8_t m_bUseNagle;
+        uint8_t m_bSendMore;	/* more data follows the next write */
+        volatile long m_nSendCalls;	/* number of socket send calls made, updated atomically */
         uint8_t m_bCustomSend;
         void*   m_customSendParam;
         CUSTOMSEND m_customSendFunc;
@@ -67,6 +67,7 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
 #define GetSockError()	errno
 #define SetSockError(e)	errno = e
 #undef closesocket
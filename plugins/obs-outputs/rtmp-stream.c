@@ -31,24 +31,73 @@ static void log_rtmp(int level, const char *format, va_list args)
 	blogva(LOG_INFO, format, args);
 }
 
-static inline size_t num_buffered_packets(struct rtmp_stream *stream);
+/* sequence numbers are allowed to wrap around */
+static inline long seq_diff(long a, long b)
+{
+	return (long)((unsigned long)a - (unsigned long)b);
+}
+
+static inline long seq_next(long seq)
+{
+	return (long)((unsigned long)seq + 1);
+}
+
+static inline size_t num_buffered_packets(struct rtmp_stream *stream)
+{
+	long write_seq = os_atomic_load_long(&stream->packets_write_seq);
+	long read_seq = os_atomic_load_long(&stream->packets_read_seq);
+	return (size_t)seq_diff(write_seq, read_seq);
+}
+
+static inline struct encoder_packet *ring_packet(struct rtmp_stream *stream,
+		long seq)
+{
+	return &stream->packets[(unsigned long)seq & (PACKET_RING_SIZE - 1)];
+}
+
+/* consumer side: pops the next packet without checking whether it was
+ * dropped */
+static inline bool pop_packet(struct rtmp_stream *stream,
+		struct encoder_packet *packet, long *seq)
+{
+	long read_seq = os_atomic_load_long(&stream->packets_read_seq);
+	long write_seq = os_atomic_load_long(&stream->packets_write_seq);
 
+	if (read_seq == write_seq)
+		return false;
+
+	*packet = *ring_packet(stream, read_seq);
+	*seq = read_seq;
+	os_atomic_set_long(&stream->packets_read_seq, seq_next(read_seq));
+	return true;
+}
+
+/* must only be called once send_thread_exited is signaled, or from the send
+ * thread itself */
 static inline void free_packets(struct rtmp_stream *stream)
 {
+	struct encoder_packet packet;
 	size_t num_packets;
-
-	pthread_mutex_lock(&stream->packets_mutex);
+	long seq;
 
 	num_packets = num_buffered_packets(stream);
 	if (num_packets)
 		info("Freeing %d remaining packets", (int)num_packets);
 
-	while (stream->packets.size) {
-		struct encoder_packet packet;
-		circlebuf_pop_front(&stream->packets, &packet, sizeof(packet));
+	while (pop_packet(stream, &packet, &seq))
+		obs_encoder_packet_release(&packet);
+}
+
+/* must only be called while no packets can be added */
+static inline void free_overflow_packets(struct rtmp_stream *stream)
+{
+	struct encoder_packet packet;
+
+	while (stream->overflow.size) {
+		circlebuf_pop_front(&stream->overflow, &packet,
+				sizeof(packet));
 		obs_encoder_packet_release(&packet);
 	}
-	pthread_mutex_unlock(&stream->packets_mutex);
 }
 
 static inline bool stopping(struct rtmp_stream *stream)
@@ -92,7 +141,14 @@ static void rtmp_stream_destroy(void *data)
 		}
 	}
 
+	if (stream->send_thread_exited)
+		os_event_wait(stream->send_thread_exited);
 	free_packets(stream);
+	free_overflow_packets(stream);
+	bfree(stream->packets);
+	circlebuf_free(&stream->overflow);
+	for (size_t i = 0; i < NUM_DROP_PRIORITIES; i++)
+		circlebuf_free(&stream->video_index[i]);
 	dstr_free(&stream->path);
 	dstr_free(&stream->key);
 	dstr_free(&stream->username);
@@ -101,8 +157,6 @@ static void rtmp_stream_destroy(void *data)
 	dstr_free(&stream->bind_ip);
 	os_event_destroy(stream->stop_event);
 	os_sem_destroy(stream->send_sem);
-	pthread_mutex_destroy(&stream->packets_mutex);
-	circlebuf_free(&stream->packets);
 #ifdef TEST_FRAMEDROPS
 	circlebuf_free(&stream->droptest_info);
 #endif
@@ -111,6 +165,7 @@ static void rtmp_stream_destroy(void *data)
 	os_event_destroy(stream->buffer_has_data_event);
 	os_event_destroy(stream->socket_available_event);
 	os_event_destroy(stream->send_thread_signaled_exit);
+	os_event_destroy(stream->send_thread_exited);
 	pthread_mutex_destroy(&stream->write_buf_mutex);
 
 	if (stream->write_buf)
@@ -122,14 +177,13 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
-	pthread_mutex_init_value(&stream->packets_mutex);
+	stream->packets = bzalloc(sizeof(struct encoder_packet) *
+			PACKET_RING_SIZE);
 
 	RTMP_Init(&stream->rtmp);
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_LogSetLevel(RTMP_LOGWARNING);
 
-	if (pthread_mutex_init(&stream->packets_mutex, NULL) != 0)
-		goto fail;
 	if (os_event_init(&stream->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
 
@@ -158,6 +212,14 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		warn("Failed to initialize socket exit event");
 		goto fail;
 	}
+	if (os_event_init(&stream->send_thread_exited,
+		OS_EVENT_TYPE_MANUAL) != 0) {
+		warn("Failed to initialize send thread exit event");
+		goto fail;
+	}
+
+	/* there is no send thread yet */
+	os_event_signal(stream->send_thread_exited);
 
 	UNUSED_PARAMETER(settings);
 	return stream;
@@ -206,20 +268,35 @@ static inline void set_rtmp_dstr(AVal *val, struct dstr *str)
 	val->av_len = valid ? (int)str->len : 0;
 }
 
+static inline bool packet_dropped(struct rtmp_stream *stream,
+		const struct encoder_packet *packet, long seq)
+{
+	if (packet->type != OBS_ENCODER_VIDEO)
+		return false;
+
+	for (int i = packet->drop_priority + 1; i < NUM_DROP_PRIORITIES; i++) {
+		long drop_seq = os_atomic_load_long(&stream->drop_seq[i]);
+		if (seq_diff(seq, drop_seq) < 0)
+			return true;
+	}
+
+	return false;
+}
+
 static inline bool get_next_packet(struct rtmp_stream *stream,
 		struct encoder_packet *packet)
 {
-	bool new_packet = false;
+	long seq;
+
+	while (pop_packet(stream, packet, &seq)) {
+		if (!packet_dropped(stream, packet, seq))
+			return true;
 
-	pthread_mutex_lock(&stream->packets_mutex);
-	if (stream->packets.size) {
-		circlebuf_pop_front(&stream->packets, packet,
-				sizeof(struct encoder_packet));
-		new_packet = true;
+		os_atomic_inc_long(&stream->dropped_frames);
+		obs_encoder_packet_release(packet);
 	}
-	pthread_mutex_unlock(&stream->packets_mutex);
 
-	return new_packet;
+	return false;
 }
 
 static bool discard_recv_data(struct rtmp_stream *stream, size_t size)
@@ -471,6 +548,10 @@ static void *send_thread(void *data)
 			}
 		}
 
+		/* lets the socket coalesce the end of this packet with the
+		 * start of the next one when more are already waiting */
+		stream->rtmp.m_bSendMore = num_buffered_packets(stream) > 0;
+
 		if (send_packet(stream, &packet, false, packet.track_idx) < 0) {
 			os_atomic_set_bool(&stream->disconnected, true);
 			break;
@@ -505,6 +586,9 @@ static void *send_thread(void *data)
 	os_event_reset(stream->stop_event);
 	os_atomic_set_bool(&stream->active, false);
 	stream->sent_headers = false;
+
+	/* a reconnect may be waiting to reuse the packet ring */
+	os_event_signal(stream->send_thread_exited);
 	return NULL;
 }
 
@@ -624,8 +708,11 @@ static int init_send(struct rtmp_stream *stream)
 
 	reset_semaphore(stream);
 
+	os_event_reset(stream->send_thread_exited);
+
 	ret = pthread_create(&stream->send_thread, NULL, send_thread, stream);
 	if (ret != 0) {
+		os_event_signal(stream->send_thread_exited);
 		RTMP_Close(&stream->rtmp);
 		warn("Failed to create send thread");
 		return OBS_OUTPUT_ERROR;
@@ -869,7 +956,11 @@ static bool init_connect(struct rtmp_stream *stream)
 		pthread_join(stream->send_thread, NULL);
 	}
 
+	/* after a disconnect, the detached send thread of the previous
+	 * connection may still be draining the packet ring */
+	os_event_wait(stream->send_thread_exited);
 	free_packets(stream);
+	free_overflow_packets(stream);
 
 	service = obs_output_get_service(stream->output);
 	if (!service)
@@ -877,9 +968,11 @@ static bool init_connect(struct rtmp_stream *stream)
 
 	os_atomic_set_bool(&stream->disconnected, false);
 	stream->total_bytes_sent = 0;
-	stream->dropped_frames   = 0;
-	stream->min_priority     = 0;
-	stream->got_first_video  = false;
+	os_atomic_set_long(&stream->dropped_frames, 0);
+	stream->min_priority      = 0;
+	stream->wait_for_keyframe = false;
+	stream->got_first_video   = false;
+	stream->ring_full_warned  = false;
 
 	settings = obs_output_get_settings(stream->output);
 	dstr_copy(&stream->path,     obs_service_get_url(service));
@@ -951,87 +1044,151 @@ static bool rtmp_stream_start(void *data)
 			stream) == 0;
 }
 
-static inline bool add_packet(struct rtmp_stream *stream,
+static inline void index_video_packet(struct rtmp_stream *stream,
+		struct encoder_packet *packet, long seq)
+{
+	struct video_packet_index entry = {seq, packet->dts_usec};
+	int priority = packet->drop_priority;
+
+	if (priority < 0)
+		priority = 0;
+	else if (priority >= NUM_DROP_PRIORITIES)
+		priority = NUM_DROP_PRIORITIES - 1;
+
+	circlebuf_push_back(&stream->video_index[priority], &entry,
+			sizeof(entry));
+}
+
+/* the ring must have space for the packet */
+static inline void push_packet(struct rtmp_stream *stream,
 		struct encoder_packet *packet)
 {
-	circlebuf_push_back(&stream->packets, packet,
-			sizeof(struct encoder_packet));
-	return true;
+	long write_seq = stream->packets_write_seq;
+
+	if (packet->type == OBS_ENCODER_VIDEO && !packet->keyframe)
+		index_video_packet(stream, packet, write_seq);
+
+	*ring_packet(stream, write_seq) = *packet;
+	os_atomic_set_long(&stream->packets_write_seq, seq_next(write_seq));
+	os_sem_post(stream->send_sem);
 }
 
-static inline size_t num_buffered_packets(struct rtmp_stream *stream)
+static inline bool ring_full(struct rtmp_stream *stream)
 {
-	return stream->packets.size / sizeof(struct encoder_packet);
+	return num_buffered_packets(stream) >= PACKET_RING_SIZE;
 }
 
-static void drop_frames(struct rtmp_stream *stream, const char *name,
-		int highest_priority, bool pframes)
+static void flush_overflow(struct rtmp_stream *stream)
 {
-	UNUSED_PARAMETER(pframes);
+	struct encoder_packet packet;
 
-	struct circlebuf new_buf            = {0};
-	int              num_frames_dropped = 0;
+	while (stream->overflow.size && !ring_full(stream)) {
+		circlebuf_pop_front(&stream->overflow, &packet,
+				sizeof(packet));
+		push_packet(stream, &packet);
+	}
+}
 
-#ifdef _DEBUG
-	int start_packets = (int)num_buffered_packets(stream);
-#else
-	UNUSED_PARAMETER(name);
-#endif
+/* non-keyframe video is dropped well before the ring is full (see
+ * add_video_packet), so only audio and keyframes can end up here when the
+ * send thread is stalled.  those are never discarded, they are kept in
+ * order until the ring has space again */
+static inline void add_packet(struct rtmp_stream *stream,
+		struct encoder_packet *packet)
+{
+	if (stream->overflow.size || ring_full(stream)) {
+		if (!stream->ring_full_warned) {
+			warn("Packet buffer is full, holding packets until "
+			     "the connection catches up");
+			stream->ring_full_warned = true;
+		}
+
+		circlebuf_push_back(&stream->overflow, packet, sizeof(*packet));
+		return;
+	}
 
-	circlebuf_reserve(&new_buf, sizeof(struct encoder_packet) * 8);
+	push_packet(stream, packet);
+}
 
-	while (stream->packets.size) {
-		struct encoder_packet packet;
-		circlebuf_pop_front(&stream->packets, &packet, sizeof(packet));
+/* removes index entries of packets that the send thread already took */
+static void trim_video_index(struct rtmp_stream *stream)
+{
+	long read_seq = os_atomic_load_long(&stream->packets_read_seq);
 
-		/* do not drop audio data or video keyframes */
-		if (packet.type          == OBS_ENCODER_AUDIO ||
-		    packet.drop_priority >= highest_priority) {
-			circlebuf_push_back(&new_buf, &packet, sizeof(packet));
+	for (size_t i = 0; i < NUM_DROP_PRIORITIES; i++) {
+		struct circlebuf *index = &stream->video_index[i];
+		struct video_packet_index entry;
 
-		} else {
-			num_frames_dropped++;
-			obs_encoder_packet_release(&packet);
+		while (index->size) {
+			circlebuf_peek_front(index, &entry, sizeof(entry));
+			if (seq_diff(entry.seq, read_seq) >= 0)
+				break;
+
+			circlebuf_pop_front(index, NULL, sizeof(entry));
 		}
 	}
+}
+
+static void drop_frames(struct rtmp_stream *stream, const char *name,
+		int highest_priority, bool pframes)
+{
+	long write_seq = stream->packets_write_seq;
+	size_t num_frames_dropped = 0;
+
+	UNUSED_PARAMETER(pframes);
 
-	circlebuf_free(&stream->packets);
-	stream->packets = new_buf;
+	/* everything currently queued below this priority is now dropped by
+	 * the send thread, which only needs a single sequence number */
+	os_atomic_set_long(&stream->drop_seq[highest_priority], write_seq);
+
+	for (int i = 0; i < highest_priority; i++) {
+		struct circlebuf *index = &stream->video_index[i];
+
+		num_frames_dropped += index->size /
+			sizeof(struct video_packet_index);
+		circlebuf_pop_front(index, NULL, index->size);
+	}
 
 	if (stream->min_priority < highest_priority)
 		stream->min_priority = highest_priority;
 	if (!num_frames_dropped)
 		return;
 
-	stream->dropped_frames += num_frames_dropped;
 #ifdef _DEBUG
-	debug("Dropped %s, prev packet count: %d, new packet count: %d",
+	debug("Dropped %s, %d frames out of %d packets",
 			name,
-			start_packets,
+			(int)num_frames_dropped,
 			(int)num_buffered_packets(stream));
+#else
+	UNUSED_PARAMETER(name);
 #endif
 }
 
 static bool find_first_video_packet(struct rtmp_stream *stream,
-		struct encoder_packet *first)
+		struct video_packet_index *first)
 {
-	size_t count = stream->packets.size / sizeof(*first);
+	bool found = false;
 
-	for (size_t i = 0; i < count; i++) {
-		struct encoder_packet *cur = circlebuf_data(&stream->packets,
-				i * sizeof(*first));
-		if (cur->type == OBS_ENCODER_VIDEO && !cur->keyframe) {
-			*first = *cur;
-			return true;
+	for (size_t i = 0; i < NUM_DROP_PRIORITIES; i++) {
+		struct circlebuf *index = &stream->video_index[i];
+		struct video_packet_index entry;
+
+		if (!index->size)
+			continue;
+
+		circlebuf_peek_front(index, &entry, sizeof(entry));
+		if (!found || seq_diff(entry.seq, first->seq) < 0) {
+			*first = entry;
+			found = true;
 		}
 	}
 
-	return false;
+	return found;
 }
 
 static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 {
-	struct encoder_packet first;
+	struct video_packet_index first;
 	int64_t buffer_duration_usec;
 	size_t num_packets = num_buffered_packets(stream);
 	const char *name = pframes ? "p-frames" : "b-frames";
@@ -1068,20 +1225,42 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 static bool add_video_packet(struct rtmp_stream *stream,
 		struct encoder_packet *packet)
 {
+	trim_video_index(stream);
 	check_to_drop_frames(stream, false);
 	check_to_drop_frames(stream, true);
 
+	/* keeps the end of the ring for audio and keyframes.  dropped packets
+	 * keep their slots until the send thread skips them, so the queued
+	 * frames are dropped as well and nothing is queued again until the
+	 * next keyframe, which the following frames can reference */
+	if (!packet->keyframe &&
+	    num_buffered_packets(stream) >= PACKET_RING_VIDEO_LIMIT) {
+		drop_frames(stream, "frames for buffer space",
+				OBS_NAL_PRIORITY_HIGHEST, true);
+		stream->wait_for_keyframe = true;
+	}
+
+	if (stream->wait_for_keyframe) {
+		if (!packet->keyframe) {
+			os_atomic_inc_long(&stream->dropped_frames);
+			return false;
+		}
+
+		stream->wait_for_keyframe = false;
+	}
+
 	/* if currently dropping frames, drop packets until it reaches the
 	 * desired priority */
 	if (packet->drop_priority < stream->min_priority) {
-		stream->dropped_frames++;
+		os_atomic_inc_long(&stream->dropped_frames);
 		return false;
 	} else {
 		stream->min_priority = 0;
 	}
 
 	stream->last_dts_usec = packet->dts_usec;
-	return add_packet(stream, packet);
+	add_packet(stream, packet);
+	return true;
 }
 
 static void rtmp_stream_data(void *data, struct encoder_packet *packet)
@@ -1105,19 +1284,19 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 		obs_encoder_packet_ref(&new_packet, packet);
 	}
 
-	pthread_mutex_lock(&stream->packets_mutex);
-
 	if (!disconnected(stream)) {
-		added_packet = (packet->type == OBS_ENCODER_VIDEO) ?
-			add_video_packet(stream, &new_packet) :
+		flush_overflow(stream);
+
+		if (packet->type == OBS_ENCODER_VIDEO) {
+			added_packet = add_video_packet(stream, &new_packet);
+		} else {
 			add_packet(stream, &new_packet);
+			added_packet = true;
+		}
 	}
 
-	pthread_mutex_unlock(&stream->packets_mutex);
-
-	if (added_packet)
-		os_sem_post(stream->send_sem);
-	else
+	/* the send thread is signaled when a packet enters the ring */
+	if (!added_packet)
 		obs_encoder_packet_release(&new_packet);
 }
 
@@ -1170,10 +1349,17 @@ static uint64_t rtmp_stream_total_bytes_sent(void *data)
 	return stream->total_bytes_sent;
 }
 
+static uint64_t rtmp_stream_total_send_calls(void *data)
+{
+	struct rtmp_stream *stream = data;
+	/* written by the send thread */
+	return (unsigned long)os_atomic_load_long(&stream->rtmp.m_nSendCalls);
+}
+
 static int rtmp_stream_dropped_frames(void *data)
 {
 	struct rtmp_stream *stream = data;
-	return stream->dropped_frames;
+	return (int)os_atomic_load_long(&stream->dropped_frames);
 }
 
 static float rtmp_stream_congestion(void *data)
@@ -1212,5 +1398,6 @@ struct obs_output_info rtmp_output_info = {
 	.get_total_bytes      = rtmp_stream_total_bytes_sent,
 	.get_congestion       = rtmp_stream_congestion,
 	.get_connect_time_ms  = rtmp_stream_connect_time,
-	.get_dropped_frames   = rtmp_stream_dropped_frames
+	.get_dropped_frames   = rtmp_stream_dropped_frames,
+	.get_total_send_calls = rtmp_stream_total_send_calls
 };
@@ -44,13 +44,43 @@ struct droptest_info {
 };
 #endif
 
+/* must be a power of two */
+#define PACKET_RING_SIZE 4096
+
+/* non-keyframe video is only queued below this many packets, the rest of
+ * the ring is kept for audio and keyframes */
+#define PACKET_RING_VIDEO_LIMIT (PACKET_RING_SIZE * 3 / 4)
+#define NUM_DROP_PRIORITIES (OBS_NAL_PRIORITY_HIGHEST + 1)
+
+struct video_packet_index {
+	long             seq;
+	int64_t          dts_usec;
+};
+
 struct rtmp_stream {
 	obs_output_t     *output;
 
-	pthread_mutex_t  packets_mutex;
-	struct circlebuf packets;
+	/* packets waiting to be sent.  this is a single producer (the encoded
+	 * packet callback, which libobs serializes) and single consumer (the
+	 * send thread) ring, so neither side ever has to take a lock */
+	struct encoder_packet *packets;
+	volatile long    packets_write_seq;
+	volatile long    packets_read_seq;
+	bool             ring_full_warned;
 	bool             sent_headers;
 
+	/* producer side: audio and keyframes that did not fit in the ring,
+	 * moved to the ring in order as soon as there is space again */
+	struct circlebuf overflow;
+
+	/* video packets queued before drop_seq[p] with a drop priority lower
+	 * than p are discarded by the send thread instead of being sent */
+	volatile long    drop_seq[NUM_DROP_PRIORITIES];
+
+	/* producer-side list of the queued non-keyframe video packets of each
+	 * drop priority, used to get the buffer duration in constant time */
+	struct circlebuf video_index[NUM_DROP_PRIORITIES];
+
 	bool             got_first_video;
 	int64_t          start_dts_offset;
 
@@ -77,12 +107,13 @@ struct rtmp_stream {
 	int64_t          drop_threshold_usec;
 	int64_t          pframe_drop_threshold_usec;
 	int              min_priority;
+	bool             wait_for_keyframe;
 	float            congestion;
 
 	int64_t          last_dts_usec;
 
 	uint64_t         total_bytes_sent;
-	int              dropped_frames;
+	volatile long    dropped_frames;
 
 #ifdef TEST_FRAMEDROPS
 	struct circlebuf droptest_info;
@@ -104,6 +135,10 @@ struct rtmp_stream {
 	os_event_t       *buffer_has_data_event;
 	os_event_t       *socket_available_event;
 	os_event_t       *send_thread_signaled_exit;
+
+	/* signaled once the send thread is done with the packet ring, the
+	 * ring must not be drained elsewhere until then */
+	os_event_t       *send_thread_exited;
 };
 
 #ifdef _WIN32
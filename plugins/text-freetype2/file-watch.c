@@ -0,0 +1,189 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <time.h>
+#include "file-watch.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+struct file_watch {
+	char   *path;
+
+	/* polling */
+	time_t timestamp;
+	float  elapsed;
+	bool   update_pending;
+
+#ifdef __linux__
+	int    fd;
+	int    wd;
+	char   *name;
+#endif
+};
+
+static time_t get_modified_timestamp(const char *filename)
+{
+	struct stat stats;
+
+	// stat is apparently terrifying and horrible, but we only call it once
+	// every second at most.
+	if (os_stat(filename, &stats) != 0)
+		return -1;
+
+	return stats.st_mtime;
+}
+
+#ifdef __linux__
+/* watches the directory rather than the file itself, so that files which
+ * are replaced (written to a temporary file and renamed) keep being
+ * watched.  only finished writes are watched, so files that are still
+ * being written are not read half way */
+static bool inotify_watch_init(struct file_watch *watch)
+{
+	char *dir = bstrdup(watch->path);
+	char *slash = strrchr(dir, '/');
+
+	if (slash) {
+		watch->name = bstrdup(slash + 1);
+		if (slash == dir)
+			slash++;
+		*slash = 0;
+	} else {
+		watch->name = bstrdup(dir);
+		bfree(dir);
+		dir = bstrdup(".");
+	}
+
+	watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch->fd != -1)
+		watch->wd = inotify_add_watch(watch->fd, dir,
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
+
+	bfree(dir);
+
+	if (watch->fd == -1 || watch->wd == -1) {
+		if (watch->fd != -1)
+			close(watch->fd);
+		watch->fd = -1;
+		return false;
+	}
+
+	return true;
+}
+
+static bool inotify_watch_poll(struct file_watch *watch)
+{
+	char buf[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	bool changed = false;
+	ssize_t len;
+
+	/* drain all pending events, multiple writes within a tick only
+	 * cause a single reload */
+	while ((len = read(watch->fd, buf, sizeof(buf))) > 0) {
+		char *ptr = buf;
+
+		while (ptr < buf + len) {
+			struct inotify_event *event =
+				(struct inotify_event*)ptr;
+
+			if (event->len && strcmp(event->name, watch->name) == 0)
+				changed = true;
+
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	return changed;
+}
+#endif
+
+struct file_watch *file_watch_create(const char *path)
+{
+	struct file_watch *watch;
+
+	if (!path || !*path)
+		return NULL;
+
+	watch = bzalloc(sizeof(struct file_watch));
+	watch->path = bstrdup(path);
+	watch->timestamp = get_modified_timestamp(path);
+
+#ifdef __linux__
+	if (!inotify_watch_init(watch))
+		blog(LOG_DEBUG, "file_watch_create: inotify unavailable for "
+		                "'%s', polling instead", path);
+#endif
+
+	return watch;
+}
+
+void file_watch_destroy(struct file_watch *watch)
+{
+	if (!watch)
+		return;
+
+#ifdef __linux__
+	if (watch->fd != -1)
+		close(watch->fd);
+	bfree(watch->name);
+#endif
+
+	bfree(watch->path);
+	bfree(watch);
+}
+
+bool file_watch_poll(struct file_watch *watch, float seconds)
+{
+	bool changed = false;
+
+	if (!watch)
+		return false;
+
+#ifdef __linux__
+	if (watch->fd != -1)
+		return inotify_watch_poll(watch);
+#endif
+
+	watch->elapsed += seconds;
+
+	/* reloads one poll after the change was seen, so files that are
+	 * still being written are not read half way */
+	if (watch->elapsed >= 1.0f) {
+		time_t t = get_modified_timestamp(watch->path);
+		watch->elapsed = 0.0f;
+
+		if (watch->update_pending) {
+			watch->update_pending = false;
+			changed = true;
+		}
+
+		if (watch->timestamp != t) {
+			watch->timestamp = t;
+			watch->update_pending = true;
+		}
+	}
+
+	return changed;
+}
@@ -0,0 +1,34 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+
+/*
+ *   Watches a text file for changes.  On Linux, inotify is used so changes
+ * are picked up on the next tick; elsewhere (or if inotify is unavailable)
+ * the modification time is polled once a second.
+ */
+
+struct file_watch;
+
+extern struct file_watch *file_watch_create(const char *path);
+extern void file_watch_destroy(struct file_watch *watch);
+
+/* Returns true if the file should be reloaded */
+extern bool file_watch_poll(struct file_watch *watch, float seconds);
@@ -0,0 +1,450 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <util/threading.h>
+#include <util/darray.h>
+#include "glyph-atlas.h"
+
+#define num_cache_slots 65535
+
+extern FT_Library ft2_lib;
+extern uint32_t texbuf_w, texbuf_h;
+
+struct glyph_atlas {
+	char                 *path;
+	FT_Long              face_index;
+	uint16_t             size;
+	long                 refs;
+
+	pthread_mutex_t      mutex;
+	FT_Face              face;
+
+	uint32_t             cell_w, cell_h;
+	uint32_t             cols, num_cells;
+	uint32_t             next_cell;
+	uint32_t             preload_h;
+
+	struct atlas_glyph   *glyphs[num_cache_slots];
+	struct atlas_glyph   *lru_first;
+	struct atlas_glyph   *lru_last;
+
+	uint8_t              *texbuf;
+	gs_texture_t         *tex;
+	bool                 tex_dirty;
+
+	bool                 out_of_space;
+
+	struct glyph_atlas   *next;
+};
+
+/* never held while entering the graphics context: sources can be destroyed
+ * by the graphics thread, which then releases their atlas with the
+ * graphics context held */
+static pthread_mutex_t atlas_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct glyph_atlas *first_atlas = NULL;
+
+/* faces are created and freed with this locked, the library itself is not
+ * thread safe */
+static pthread_mutex_t face_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ------------------------------------------------------------------------- */
+
+static inline void lru_remove(struct glyph_atlas *atlas,
+		struct atlas_glyph *glyph)
+{
+	if (glyph->lru_prev)
+		glyph->lru_prev->lru_next = glyph->lru_next;
+	else
+		atlas->lru_first = glyph->lru_next;
+
+	if (glyph->lru_next)
+		glyph->lru_next->lru_prev = glyph->lru_prev;
+	else
+		atlas->lru_last = glyph->lru_prev;
+
+	glyph->lru_prev = NULL;
+	glyph->lru_next = NULL;
+}
+
+static inline void lru_push_back(struct glyph_atlas *atlas,
+		struct atlas_glyph *glyph)
+{
+	glyph->lru_prev = atlas->lru_last;
+	glyph->lru_next = NULL;
+
+	if (atlas->lru_last)
+		atlas->lru_last->lru_next = glyph;
+	else
+		atlas->lru_first = glyph;
+
+	atlas->lru_last = glyph;
+}
+
+static bool alloc_cell(struct glyph_atlas *atlas, uint32_t *cell)
+{
+	struct atlas_glyph *evict;
+
+	if (atlas->next_cell < atlas->num_cells) {
+		*cell = atlas->next_cell++;
+		return true;
+	}
+
+	evict = atlas->lru_first;
+	if (!evict)
+		return false;
+
+	lru_remove(atlas, evict);
+	atlas->glyphs[evict->index] = NULL;
+	*cell = evict->cell;
+	bfree(evict);
+	return true;
+}
+
+#define glyph_pos x + (y*slot->bitmap.pitch)
+#define buf_pos (dx + x) + ((dy + y) * texbuf_w)
+
+static struct atlas_glyph *cache_glyph(struct glyph_atlas *atlas,
+		FT_UInt glyph_index)
+{
+	FT_GlyphSlot slot = atlas->face->glyph;
+	struct atlas_glyph *glyph;
+	uint32_t cell, dx, dy;
+	uint32_t g_w, g_h;
+
+	FT_Load_Glyph(atlas->face, glyph_index, FT_LOAD_DEFAULT);
+	FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL);
+
+	g_w = slot->bitmap.width;
+	g_h = slot->bitmap.rows;
+
+	if (!alloc_cell(atlas, &cell)) {
+		if (!atlas->out_of_space) {
+			blog(LOG_WARNING, "Out of space trying to render "
+			                  "glyphs");
+			atlas->out_of_space = true;
+		}
+		return NULL;
+	}
+
+	dx = (cell % atlas->cols) * atlas->cell_w;
+	dy = (cell / atlas->cols) * atlas->cell_h;
+
+	/* keep a one pixel gap to the next cell so filtering does not pick
+	 * up neighbouring glyphs */
+	if (g_w > atlas->cell_w - 1) g_w = atlas->cell_w - 1;
+	if (g_h > atlas->cell_h - 1) g_h = atlas->cell_h - 1;
+
+	for (uint32_t y = 0; y < atlas->cell_h; y++)
+		memset(atlas->texbuf + dx + (dy + y) * texbuf_w, 0,
+				atlas->cell_w);
+
+	for (uint32_t y = 0; y < g_h; y++) {
+		for (uint32_t x = 0; x < g_w; x++)
+			atlas->texbuf[buf_pos] =
+				slot->bitmap.buffer[glyph_pos];
+	}
+
+	glyph = bzalloc(sizeof(struct atlas_glyph));
+	glyph->index = glyph_index;
+	glyph->cell = cell;
+	glyph->info.u = (float)dx / (float)texbuf_w;
+	glyph->info.u2 = (float)(dx + g_w) / (float)texbuf_w;
+	glyph->info.v = (float)dy / (float)texbuf_h;
+	glyph->info.v2 = (float)(dy + g_h) / (float)texbuf_h;
+	glyph->info.w = g_w;
+	glyph->info.h = g_h;
+	glyph->info.yoff = slot->bitmap_top;
+	glyph->info.xoff = slot->bitmap_left;
+	glyph->info.xadv = slot->advance.x >> 6;
+
+	atlas->glyphs[glyph_index] = glyph;
+	atlas->tex_dirty = true;
+	return glyph;
+}
+
+static struct atlas_glyph *get_glyph(struct glyph_atlas *atlas, wchar_t ch)
+{
+	FT_UInt glyph_index = FT_Get_Char_Index(atlas->face, ch);
+	struct atlas_glyph *glyph;
+
+	if (glyph_index >= num_cache_slots)
+		return NULL;
+
+	glyph = atlas->glyphs[glyph_index];
+	if (!glyph) {
+		glyph = cache_glyph(atlas, glyph_index);
+		if (glyph)
+			lru_push_back(atlas, glyph);
+	}
+
+	return glyph;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void calc_cell_size(struct glyph_atlas *atlas)
+{
+	FT_Face face = atlas->face;
+	FT_Size_Metrics *metrics = &face->size->metrics;
+	long w, h;
+
+	if (FT_IS_SCALABLE(face)) {
+		w = FT_MulFix(face->bbox.xMax - face->bbox.xMin,
+				metrics->x_scale);
+		h = FT_MulFix(face->bbox.yMax - face->bbox.yMin,
+				metrics->y_scale);
+	} else {
+		w = metrics->max_advance;
+		h = metrics->ascender - metrics->descender;
+	}
+
+	/* 26.6 fixed point, rounded up, plus the gap between cells */
+	w = ((w + 63) >> 6) + 1;
+	h = ((h + 63) >> 6) + 1;
+
+	if (w < 2) w = 2;
+	if (h < 2) h = 2;
+	if (w > (long)texbuf_w) w = (long)texbuf_w;
+	if (h > (long)texbuf_h) h = (long)texbuf_h;
+
+	atlas->cell_w    = (uint32_t)w;
+	atlas->cell_h    = (uint32_t)h;
+	atlas->cols      = texbuf_w / atlas->cell_w;
+	atlas->num_cells = atlas->cols * (texbuf_h / atlas->cell_h);
+}
+
+static void atlas_destroy(struct glyph_atlas *atlas)
+{
+	for (uint32_t i = 0; i < num_cache_slots; i++)
+		bfree(atlas->glyphs[i]);
+
+	if (atlas->tex) {
+		obs_enter_graphics();
+		gs_texture_destroy(atlas->tex);
+		obs_leave_graphics();
+	}
+
+	if (atlas->face) {
+		pthread_mutex_lock(&face_mutex);
+		FT_Done_Face(atlas->face);
+		pthread_mutex_unlock(&face_mutex);
+	}
+
+	pthread_mutex_destroy(&atlas->mutex);
+	bfree(atlas->texbuf);
+	bfree(atlas->path);
+	bfree(atlas);
+}
+
+static struct glyph_atlas *atlas_create(const char *path, FT_Long index,
+		uint16_t size)
+{
+	struct glyph_atlas *atlas = bzalloc(sizeof(struct glyph_atlas));
+	atlas->path       = bstrdup(path);
+	atlas->face_index = index;
+	atlas->size       = size;
+	atlas->refs       = 1;
+
+	if (pthread_mutex_init(&atlas->mutex, NULL) != 0) {
+		bfree(atlas->path);
+		bfree(atlas);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&face_mutex);
+	if (FT_New_Face(ft2_lib, path, index, &atlas->face) != 0)
+		atlas->face = NULL;
+	pthread_mutex_unlock(&face_mutex);
+
+	if (!atlas->face) {
+		atlas_destroy(atlas);
+		return NULL;
+	}
+
+	FT_Set_Pixel_Sizes(atlas->face, 0, size);
+	FT_Select_Charmap(atlas->face, FT_ENCODING_UNICODE);
+
+	calc_cell_size(atlas);
+	atlas->texbuf = bzalloc(texbuf_w * texbuf_h);
+
+	obs_enter_graphics();
+	atlas->tex = gs_texture_create(texbuf_w, texbuf_h, GS_A8, 1, NULL,
+			GS_DYNAMIC);
+	obs_leave_graphics();
+
+	glyph_atlas_preload(atlas, L"abcdefghijklmnopqrstuvwxyz" \
+		L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890" \
+		L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
+	return atlas;
+}
+
+static struct glyph_atlas *find_atlas(const char *path, FT_Long index,
+		uint16_t size)
+{
+	struct glyph_atlas *atlas = first_atlas;
+
+	while (atlas) {
+		if (atlas->face_index == index && atlas->size == size &&
+		    strcmp(atlas->path, path) == 0) {
+			atlas->refs++;
+			break;
+		}
+
+		atlas = atlas->next;
+	}
+
+	return atlas;
+}
+
+struct glyph_atlas *glyph_atlas_get(const char *path, FT_Long index,
+		uint16_t size)
+{
+	struct glyph_atlas *atlas;
+	struct glyph_atlas *created;
+
+	if (!path || !ft2_lib)
+		return NULL;
+
+	pthread_mutex_lock(&atlas_list_mutex);
+	atlas = find_atlas(path, index, size);
+	pthread_mutex_unlock(&atlas_list_mutex);
+
+	if (atlas)
+		return atlas;
+
+	/* creating the atlas enters the graphics context, so it is done
+	 * with the list unlocked, and the list is checked again in case
+	 * another source created the same atlas in the meantime */
+	created = atlas_create(path, index, size);
+	if (!created)
+		return NULL;
+
+	pthread_mutex_lock(&atlas_list_mutex);
+	atlas = find_atlas(path, index, size);
+	if (!atlas) {
+		created->next = first_atlas;
+		first_atlas = created;
+	}
+	pthread_mutex_unlock(&atlas_list_mutex);
+
+	if (!atlas)
+		return created;
+
+	atlas_destroy(created);
+	return atlas;
+}
+
+void glyph_atlas_release(struct glyph_atlas *atlas)
+{
+	struct glyph_atlas **prev_next;
+	bool destroy;
+
+	if (!atlas)
+		return;
+
+	pthread_mutex_lock(&atlas_list_mutex);
+
+	destroy = --atlas->refs == 0;
+	if (destroy) {
+		prev_next = &first_atlas;
+		while (*prev_next != atlas)
+			prev_next = &(*prev_next)->next;
+		*prev_next = atlas->next;
+	}
+
+	pthread_mutex_unlock(&atlas_list_mutex);
+
+	/* unlinked, so nothing else can reach it any more */
+	if (destroy)
+		atlas_destroy(atlas);
+}
+
+void glyph_atlas_pin_text(struct glyph_atlas *atlas, const wchar_t *text,
+		size_t len, struct atlas_glyph **glyphs)
+{
+	pthread_mutex_lock(&atlas->mutex);
+
+	for (size_t i = 0; i < len; i++) {
+		struct atlas_glyph *glyph = NULL;
+
+		if (text[i] != L'\n')
+			glyph = get_glyph(atlas, text[i]);
+
+		if (glyph && glyph->pins++ == 0)
+			lru_remove(atlas, glyph);
+
+		glyphs[i] = glyph;
+	}
+
+	pthread_mutex_unlock(&atlas->mutex);
+}
+
+void glyph_atlas_unpin(struct glyph_atlas *atlas, struct atlas_glyph **glyphs,
+		size_t num)
+{
+	pthread_mutex_lock(&atlas->mutex);
+
+	for (size_t i = 0; i < num; i++) {
+		struct atlas_glyph *glyph = glyphs[i];
+
+		if (glyph && --glyph->pins == 0)
+			lru_push_back(atlas, glyph);
+	}
+
+	pthread_mutex_unlock(&atlas->mutex);
+}
+
+void glyph_atlas_preload(struct glyph_atlas *atlas, const wchar_t *text)
+{
+	size_t len = wcslen(text);
+
+	pthread_mutex_lock(&atlas->mutex);
+
+	for (size_t i = 0; i < len; i++) {
+		struct atlas_glyph *glyph = get_glyph(atlas, text[i]);
+
+		if (glyph && atlas->preload_h < (uint32_t)glyph->info.h)
+			atlas->preload_h = (uint32_t)glyph->info.h;
+	}
+
+	pthread_mutex_unlock(&atlas->mutex);
+}
+
+uint32_t glyph_atlas_get_preload_h(struct glyph_atlas *atlas)
+{
+	uint32_t preload_h;
+
+	pthread_mutex_lock(&atlas->mutex);
+	preload_h = atlas->preload_h;
+	pthread_mutex_unlock(&atlas->mutex);
+
+	return preload_h;
+}
+
+gs_texture_t *glyph_atlas_get_texture(struct glyph_atlas *atlas)
+{
+	pthread_mutex_lock(&atlas->mutex);
+
+	if (atlas->tex && atlas->tex_dirty) {
+		gs_texture_set_image(atlas->tex, atlas->texbuf, texbuf_w,
+				false);
+		atlas->tex_dirty = false;
+	}
+
+	pthread_mutex_unlock(&atlas->mutex);
+	return atlas->tex;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+    Copyright (C) 2018 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ *   Glyph atlas shared by all text sources using the same font file, face
+ * index and size.  Glyphs are rendered into fixed size cells of a single A8
+ * texture.  Glyphs used by the current text of a source are pinned; unpinned
+ * glyphs are kept until their cell is needed, least recently used first.
+ */
+
+#include <obs-module.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+struct glyph_info {
+	float u, v, u2, v2;
+	int32_t w, h, xoff, yoff;
+	int32_t xadv;
+};
+
+struct atlas_glyph {
+	struct glyph_info  info;
+	FT_UInt            index;
+	uint32_t           cell;
+	long               pins;
+
+	/* unpinned glyphs only, least recently used first */
+	struct atlas_glyph *lru_prev;
+	struct atlas_glyph *lru_next;
+};
+
+struct glyph_atlas;
+
+extern struct glyph_atlas *glyph_atlas_get(const char *path, FT_Long index,
+		uint16_t size);
+extern void glyph_atlas_release(struct glyph_atlas *atlas);
+
+/* Pins the glyphs of each character of the text.  Entries of characters that
+ * could not be cached are set to NULL.  Line breaks are not looked up. */
+extern void glyph_atlas_pin_text(struct glyph_atlas *atlas,
+		const wchar_t *text, size_t len, struct atlas_glyph **glyphs);
+extern void glyph_atlas_unpin(struct glyph_atlas *atlas,
+		struct atlas_glyph **glyphs, size_t num);
+
+/* Caches glyphs without pinning them */
+extern void glyph_atlas_preload(struct glyph_atlas *atlas,
+		const wchar_t *text);
+
+/* Height of the tallest glyph preloaded so far.  Sources use at least this
+ * as their line height, so it does not depend on the atlas's other users. */
+extern uint32_t glyph_atlas_get_preload_h(struct glyph_atlas *atlas);
+
+/* Must be called within the graphics context.  Uploads any newly cached
+ * glyphs before returning the texture. */
+extern gs_texture_t *glyph_atlas_get_texture(struct glyph_atlas *atlas);
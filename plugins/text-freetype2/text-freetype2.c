@@ -38,7 +38,8 @@ static struct obs_source_info freetype2_source_info = {
 #ifdef _WIN32
 	                OBS_SOURCE_DEPRECATED |
 #endif
-	                OBS_SOURCE_CUSTOM_DRAW,
+	                OBS_SOURCE_CUSTOM_DRAW |
+	                OBS_SOURCE_STATIC_VIDEO,
 	.get_name = ft2_source_get_name,
 	.create = ft2_source_create,
 	.destroy = ft2_source_destroy,
@@ -165,17 +166,9 @@ static void ft2_source_destroy(void *data)
 {
 	struct ft2_source *srcdata = data;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
-	
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
+	free_text_layout(srcdata);
+	glyph_atlas_release(srcdata->atlas);
+	file_watch_destroy(srcdata->watch);
 
 	if (srcdata->font_name != NULL)
 		bfree(srcdata->font_name);
@@ -183,23 +176,11 @@ static void ft2_source_destroy(void *data)
 		bfree(srcdata->font_style);
 	if (srcdata->text != NULL)
 		bfree(srcdata->text);
-	if (srcdata->texbuf != NULL)
-		bfree(srcdata->texbuf);
-	if (srcdata->colorbuf != NULL)
-		bfree(srcdata->colorbuf);
 	if (srcdata->text_file != NULL)
 		bfree(srcdata->text_file);
 
 	obs_enter_graphics();
 
-	if (srcdata->tex != NULL) {
-		gs_texture_destroy(srcdata->tex);
-		srcdata->tex = NULL;
-	}
-	if (srcdata->vbuf != NULL) {
-		gs_vertexbuffer_destroy(srcdata->vbuf);
-		srcdata->vbuf = NULL;
-	}
 	if (srcdata->draw_effect != NULL) {
 		gs_effect_destroy(srcdata->draw_effect);
 		srcdata->draw_effect = NULL;
@@ -215,15 +196,16 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	struct ft2_source *srcdata = data;
 	if (srcdata == NULL) return;
 
-	if (srcdata->tex == NULL || srcdata->vbuf == NULL) return;
+	if (srcdata->atlas == NULL || srcdata->vbuf == NULL) return;
 	if (srcdata->text == NULL || *srcdata->text == 0) return;
+	if (srcdata->quads.num == 0) return;
 
 	gs_reset_blend_state();
 	if (srcdata->outline_text) draw_outlines(srcdata);
 	if (srcdata->drop_shadow) draw_drop_shadow(srcdata);
 
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex,
-		srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6);
+	draw_uv_vbuffer(srcdata->vbuf, glyph_atlas_get_texture(srcdata->atlas),
+		srcdata->draw_effect, (uint32_t)srcdata->quads.num * 6);
 
 	UNUSED_PARAMETER(effect);
 }
@@ -234,28 +216,14 @@ static void ft2_video_tick(void *data, float seconds)
 	if (srcdata == NULL) return;
 	if (!srcdata->from_file || !srcdata->text_file) return;
 
-	if (os_gettime_ns() - srcdata->last_checked >= 1000000000) {
-		time_t t = get_modified_timestamp(srcdata->text_file);
-		srcdata->last_checked = os_gettime_ns();
-
-		if (srcdata->update_file) {
-			if (srcdata->log_mode)
-				read_from_end(srcdata, srcdata->text_file);
-			else
-				load_text_from_file(srcdata,
-					srcdata->text_file);
-			cache_glyphs(srcdata, srcdata->text);
-			set_up_vertex_buffer(srcdata);
-			srcdata->update_file = false;
-		}
-
-		if (srcdata->m_timestamp != t) {
-			srcdata->m_timestamp = t;
-			srcdata->update_file = true;
-		}
+	if (file_watch_poll(srcdata->watch, seconds)) {
+		if (srcdata->log_mode)
+			read_from_end(srcdata, srcdata->text_file);
+		else
+			load_text_from_file(srcdata, srcdata->text_file);
+		set_up_vertex_buffer(srcdata);
+		obs_source_video_changed(srcdata->src);
 	}
-
-	UNUSED_PARAMETER(seconds);
 }
 
 static bool init_font(struct ft2_source *srcdata)
@@ -266,12 +234,11 @@ static bool init_font(struct ft2_source *srcdata)
 	if (!path)
 		return false;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
+	free_text_layout(srcdata);
+	glyph_atlas_release(srcdata->atlas);
 
-	return FT_New_Face(ft2_lib, path, index, &srcdata->font_face) == 0;
+	srcdata->atlas = glyph_atlas_get(path, index, srcdata->font_size);
+	return srcdata->atlas != NULL;
 }
 
 static void ft2_source_update(void *data, obs_data_t *settings)
@@ -280,6 +247,7 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	obs_data_t *font_obj = obs_data_get_obj(settings, "font");
 	bool vbuf_needs_update = false;
 	bool word_wrap = false;
+	bool drop_shadow, outline_text;
 	uint32_t color[2];
 	uint32_t custom_width = 0;
 
@@ -291,10 +259,17 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (!font_obj)
 		return;
 
-	srcdata->drop_shadow = obs_data_get_bool(settings, "drop_shadow");
-	srcdata->outline_text = obs_data_get_bool(settings, "outline");
+	drop_shadow = obs_data_get_bool(settings, "drop_shadow");
+	outline_text = obs_data_get_bool(settings, "outline");
 	word_wrap = obs_data_get_bool(settings, "word_wrap");
 
+	if (drop_shadow != srcdata->drop_shadow ||
+	    outline_text != srcdata->outline_text) {
+		srcdata->drop_shadow = drop_shadow;
+		srcdata->outline_text = outline_text;
+		vbuf_needs_update = true;
+	}
+
 	color[0] = (uint32_t)obs_data_get_int(settings, "color1");
 	color[1] = (uint32_t)obs_data_get_int(settings, "color2");
 
@@ -366,7 +341,6 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 		bfree(srcdata->font_style);
 		srcdata->font_name = NULL;
 		srcdata->font_style = NULL;
-		srcdata->max_h = 0;
 		vbuf_needs_update = true;
 	}
 
@@ -375,24 +349,11 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	srcdata->font_size  = font_size;
 	srcdata->font_flags = font_flags;
 
-	if (!init_font(srcdata) || srcdata->font_face == NULL) {
+	if (!init_font(srcdata)) {
 		blog(LOG_WARNING, "FT2-text: Failed to load font %s",
 			srcdata->font_name);
 		goto error;
 	}
-	else {
-		FT_Set_Pixel_Sizes(srcdata->font_face, 0, srcdata->font_size); 
-		FT_Select_Charmap(srcdata->font_face, FT_ENCODING_UNICODE);
-	}
-
-	if (srcdata->texbuf != NULL) {
-		bfree(srcdata->texbuf);
-		srcdata->texbuf = NULL;
-	}
-	srcdata->texbuf = bzalloc(texbuf_w * texbuf_h);
-
-	if (srcdata->font_face)
-		cache_standard_glyphs(srcdata);
 
 skip_font_load:
 	if (from_file) {
@@ -404,6 +365,9 @@ skip_font_load:
 			bfree(srcdata->text);
 			srcdata->text = NULL;
 
+			file_watch_destroy(srcdata->watch);
+			srcdata->watch = NULL;
+
 			os_utf8_to_wcs_ptr(emptystr, strlen(emptystr),
 					&srcdata->text);
 			blog(LOG_WARNING, "FT2-text: Failed to open %s for "
@@ -416,17 +380,22 @@ skip_font_load:
 				goto error;
 
 			bfree(srcdata->text_file);
+			file_watch_destroy(srcdata->watch);
 
 			srcdata->text_file = bstrdup(tmp);
+			srcdata->watch = file_watch_create(tmp);
 			if (chat_log_mode)
 				read_from_end(srcdata, tmp);
 			else
 				load_text_from_file(srcdata, tmp);
-			srcdata->last_checked = os_gettime_ns();
 		}
 	}
 	else {
 		const char *tmp = obs_data_get_string(settings, "text");
+
+		file_watch_destroy(srcdata->watch);
+		srcdata->watch = NULL;
+
 		if (!tmp || !*tmp) goto error;
 
 		if (srcdata->text != NULL) {
@@ -437,10 +406,8 @@ skip_font_load:
 		os_utf8_to_wcs_ptr(tmp, strlen(tmp), &srcdata->text);
 	}
 
-	if (srcdata->font_face) {
-		cache_glyphs(srcdata, srcdata->text);
+	if (srcdata->atlas)
 		set_up_vertex_buffer(srcdata);
-	}
 
 error:
 	obs_data_release(font_obj);
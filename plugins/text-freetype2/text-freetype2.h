@@ -16,15 +16,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
 #include <obs-module.h>
+#include <util/darray.h>
 #include <ft2build.h>
+#include "glyph-atlas.h"
+#include "file-watch.h"
 
-#define num_cache_slots 65535
-#define src_glyph srcdata->cacheglyphs[glyph_index]
-
-struct glyph_info {
-	float u, v, u2, v2;
-	int32_t w, h, xoff, yoff;
-	int32_t xadv;
+struct text_quad {
+	struct atlas_glyph *glyph;
+	float x, y;
 };
 
 struct ft2_source {
@@ -37,25 +36,25 @@ struct ft2_source {
 	bool from_file;
 	char *text_file;
 	wchar_t *text;
-	time_t m_timestamp;
-	bool update_file;
-	uint64_t last_checked;
+	struct file_watch *watch;
 
 	uint32_t cx, cy, max_h, custom_width;
-	uint32_t texbuf_x, texbuf_y;
 	uint32_t color[2];
-	uint32_t *colorbuf;
 
 	int32_t cur_scroll, scroll_speed;
 
-	gs_texture_t *tex;
-
-	struct glyph_info *cacheglyphs[num_cache_slots];
+	struct glyph_atlas *atlas;
 
-	FT_Face	font_face;
+	/* glyphs pinned for the current text (one per character), and the
+	 * quads currently in the vertex buffers */
+	DARRAY(struct atlas_glyph*) pins;
+	DARRAY(struct text_quad) quads;
+	uint32_t quad_colors[2];
 
-	uint8_t *texbuf;
+	/* capacity of the vertex buffers in quads */
+	uint32_t vbuf_quads;
 	gs_vertbuffer_t *vbuf;
+	gs_vertbuffer_t *shadow_vbuf;
 
 	gs_effect_t *draw_effect;
 	bool outline_text, drop_shadow;
@@ -82,14 +81,8 @@ static obs_properties_t *ft2_source_properties(void *unused);
 
 static const char *ft2_source_get_name(void *unused);
 
-uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata);
-
-time_t get_modified_timestamp(char *filename);
 void load_text_from_file(struct ft2_source *srcdata, const char *filename);
 void read_from_end(struct ft2_source *srcdata, const char *filename);
 
-void cache_standard_glyphs(struct ft2_source *srcdata);
-void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs);
-
 void set_up_vertex_buffer(struct ft2_source *srcdata);
-void fill_vertex_buffer(struct ft2_source *srcdata);
+void free_text_layout(struct ft2_source *srcdata);
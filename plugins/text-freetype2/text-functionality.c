@@ -19,321 +19,305 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <util/platform.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include <sys/stat.h>
 #include "text-freetype2.h"
 #include "obs-convenience.h"
 
 float offsets[16] = { -2.0f, 0.0f, 0.0f, -2.0f, 2.0f, 0.0f, 2.0f, 0.0f,
 	0.0f, 2.0f, 0.0f, 2.0f, -2.0f, 0.0f, -2.0f, 0.0f };
 
-extern uint32_t texbuf_w, texbuf_h;
 
 void draw_outlines(struct ft2_source *srcdata)
 {
 	// Horrible (hopefully temporary) solution for outlines.
-	uint32_t *tmp;
+	gs_texture_t *tex = glyph_atlas_get_texture(srcdata->atlas);
+	uint32_t num_verts = (uint32_t)srcdata->quads.num * 6;
 
-	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(srcdata->vbuf);
-
-	if (!srcdata->text)
+	if (!srcdata->text || !srcdata->shadow_vbuf)
 		return;
 
-	tmp = vdata->colors;
-	vdata->colors = srcdata->colorbuf;
-
 	gs_matrix_push();
 	for (int32_t i = 0; i < 8; i++) {
 		gs_matrix_translate3f(offsets[i * 2], offsets[(i * 2) + 1],
 			0.0f);
-		draw_uv_vbuffer(srcdata->vbuf, srcdata->tex,
-			srcdata->draw_effect,
-			(uint32_t)wcslen(srcdata->text) * 6);
+		draw_uv_vbuffer(srcdata->shadow_vbuf, tex,
+			srcdata->draw_effect, num_verts);
 	}
 	gs_matrix_identity();
 	gs_matrix_pop();
-
-	vdata->colors = tmp;
 }
 
 void draw_drop_shadow(struct ft2_source *srcdata)
 {
 	// Horrible (hopefully temporary) solution for drop shadow.
-	uint32_t *tmp;
-
-	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(srcdata->vbuf);
+	gs_texture_t *tex = glyph_atlas_get_texture(srcdata->atlas);
+	uint32_t num_verts = (uint32_t)srcdata->quads.num * 6;
 
-	if (!srcdata->text)
+	if (!srcdata->text || !srcdata->shadow_vbuf)
 		return;
 
-	tmp = vdata->colors;
-	vdata->colors = srcdata->colorbuf;
-
 	gs_matrix_push();
 	gs_matrix_translate3f(4.0f, 4.0f, 0.0f);
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex,
-		srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6);
+	draw_uv_vbuffer(srcdata->shadow_vbuf, tex,
+		srcdata->draw_effect, num_verts);
 	gs_matrix_identity();
 	gs_matrix_pop();
-
-	vdata->colors = tmp;
 }
 
-void set_up_vertex_buffer(struct ft2_source *srcdata)
+static inline uint32_t glyph_xadv(const struct atlas_glyph *glyph)
 {
-	FT_UInt glyph_index = 0;
-	uint32_t x = 0, space_pos = 0, word_width = 0;
-	size_t len;
-
-	if (!srcdata->text)
-		return;
-
-	if (srcdata->custom_width >= 100)
-		srcdata->cx = srcdata->custom_width;
-	else
-		srcdata->cx = get_ft2_text_width(srcdata->text, srcdata);
-	srcdata->cy = srcdata->max_h;
+	return glyph ? (uint32_t)glyph->info.xadv : 0;
+}
 
-	obs_enter_graphics();
-	if (srcdata->vbuf != NULL) {
-		gs_vertbuffer_t *tmpvbuf = srcdata->vbuf;
-		srcdata->vbuf = NULL;
-		gs_vertexbuffer_destroy(tmpvbuf);
-	}
+static uint32_t get_text_width(struct ft2_source *srcdata, size_t len)
+{
+	uint32_t w = 0, max_w = 0;
 
-	if (*srcdata->text == 0) {
-		obs_leave_graphics();
-		return;
+	for (size_t i = 0; i < len; i++) {
+		if (srcdata->text[i] == L'\n') w = 0;
+		else {
+			w += glyph_xadv(srcdata->pins.array[i]);
+			if (w > max_w) max_w = w;
+		}
 	}
 
-	srcdata->vbuf = create_uv_vbuffer((uint32_t)wcslen(srcdata->text) * 6,
-			true);
-
-	if (srcdata->custom_width <= 100) goto skip_word_wrap;
-	if (!srcdata->word_wrap) goto skip_word_wrap;
-
-	len = wcslen(srcdata->text);
+	return max_w;
+}
 
-	for (uint32_t i = 0; i <= len; i++) {
-		if (i == wcslen(srcdata->text)) goto eos_check;
+static void apply_word_wrap(struct ft2_source *srcdata, size_t len)
+{
+	wchar_t *text = srcdata->text;
+	uint32_t x = 0, space_pos = 0, word_width = 0;
 
-		if (srcdata->text[i] != L' ' && srcdata->text[i] != L'\n')
-			goto next_char;
+	for (size_t i = 0; i <= len; i++) {
+		if (i < len && text[i] != L' ' && text[i] != L'\n') {
+			word_width += glyph_xadv(srcdata->pins.array[i]);
+			continue;
+		}
 
-	eos_check:;
 		if (x + word_width > srcdata->custom_width) {
 			if (space_pos != 0)
-				srcdata->text[space_pos] = L'\n';
+				text[space_pos] = L'\n';
 			x = 0;
 		}
-		if (i == wcslen(srcdata->text)) goto eos_skip;
+		if (i == len)
+			break;
 
 		x += word_width;
 		word_width = 0;
-		if (srcdata->text[i] == L'\n')
+		if (text[i] == L'\n')
 			x = 0;
-		if (srcdata->text[i] == L' ')
-			space_pos = i;
-	next_char:;
-		glyph_index = FT_Get_Char_Index(srcdata->font_face,
-			srcdata->text[i]);
-		word_width += src_glyph->xadv;
-	eos_skip:;
-	}
+		if (text[i] == L' ')
+			space_pos = (uint32_t)i;
 
-skip_word_wrap:;
-	fill_vertex_buffer(srcdata);
-	obs_leave_graphics();
+		word_width += glyph_xadv(srcdata->pins.array[i]);
+	}
 }
 
-void fill_vertex_buffer(struct ft2_source *srcdata)
+static void layout_quads(struct ft2_source *srcdata, size_t len,
+		struct darray *quads_da)
 {
-	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(srcdata->vbuf);
-	if (vdata == NULL || !srcdata->text) return;
-
-	struct vec2 *tvarray = (struct vec2 *)vdata->tvarray[0].array;
-	uint32_t *col = (uint32_t *)vdata->colors;
-
-	FT_UInt glyph_index = 0;
-
+	DARRAY(struct text_quad) quads;
 	uint32_t dx = 0, dy = srcdata->max_h, max_y = dy;
-	uint32_t cur_glyph = 0;
-	size_t len = wcslen(srcdata->text);
 
-	if (srcdata->colorbuf != NULL) {
-		bfree(srcdata->colorbuf);
-		srcdata->colorbuf = NULL;
-	}
-	srcdata->colorbuf = bzalloc(sizeof(uint32_t)*wcslen(srcdata->text) * 6);
-	for (size_t i = 0; i < len * 6; i++) {
-		srcdata->colorbuf[i] = 0xFF000000;
-	}
+	quads.da = *quads_da;
 
 	for (size_t i = 0; i < len; i++) {
-	add_linebreak:;
-		if (srcdata->text[i] != L'\n') goto draw_glyph;
-		dx = 0; i++;
-		dy += srcdata->max_h + 4;
-		if (i == wcslen(srcdata->text)) goto skip_glyph;
-		if (srcdata->text[i] == L'\n') goto add_linebreak;
-	draw_glyph:;
-		// Skip filthy dual byte Windows line breaks
-		if (srcdata->text[i] == L'\r') goto skip_glyph;
+		struct atlas_glyph *glyph = srcdata->pins.array[i];
+		const struct glyph_info *info;
+		struct text_quad *quad;
+		int64_t bottom;
 
-		glyph_index = FT_Get_Char_Index(srcdata->font_face,
-			srcdata->text[i]);
-		if (src_glyph == NULL)
-			goto skip_glyph;
+		if (srcdata->text[i] == L'\n') {
+			dx = 0;
+			dy += srcdata->max_h + 4;
+			continue;
+		}
 
-		if (srcdata->custom_width < 100) goto skip_custom_width;
+		// Skip filthy dual byte Windows line breaks
+		if (srcdata->text[i] == L'\r' || !glyph)
+			continue;
+
+		info = &glyph->info;
 
-		if (dx + src_glyph->xadv > srcdata->custom_width) {
+		if (srcdata->custom_width >= 100 &&
+		    dx + info->xadv > srcdata->custom_width) {
 			dx = 0;
 			dy += srcdata->max_h + 4;
 		}
 
-	skip_custom_width:;
-
-		set_v3_rect(vdata->points + (cur_glyph * 6),
-			(float)dx + (float)src_glyph->xoff,
-			(float)dy - (float)src_glyph->yoff,
-			(float)src_glyph->w,
-			(float)src_glyph->h);
-		set_v2_uv(tvarray + (cur_glyph * 6),
-			src_glyph->u,
-			src_glyph->v,
-			src_glyph->u2,
-			src_glyph->v2);
-		set_rect_colors2(col + (cur_glyph * 6),
-			srcdata->color[0],
-			srcdata->color[1]);
-		dx += src_glyph->xadv;
-		if (dy - (float)src_glyph->yoff + src_glyph->h > max_y)
-			max_y = dy - src_glyph->yoff + src_glyph->h;
-		cur_glyph++;
-	skip_glyph:;
+		quad = da_push_back_new(quads);
+		quad->glyph = glyph;
+		quad->x = (float)dx + (float)info->xoff;
+		quad->y = (float)dy - (float)info->yoff;
+
+		dx += info->xadv;
+
+		bottom = (int64_t)dy - info->yoff + info->h;
+		if (bottom > (int64_t)max_y)
+			max_y = (uint32_t)bottom;
 	}
 
+	*quads_da = quads.da;
 	srcdata->cy = max_y;
 }
 
-void cache_standard_glyphs(struct ft2_source *srcdata)
+static inline bool quads_equal(const struct text_quad *a,
+		const struct text_quad *b)
 {
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
+	return a->glyph == b->glyph && a->x == b->x && a->y == b->y;
+}
 
-	srcdata->texbuf_x = 0;
-	srcdata->texbuf_y = 0;
+static void write_quads(gs_vertbuffer_t *vbuf, const struct text_quad *quads,
+		size_t first, size_t last, uint32_t color1, uint32_t color2)
+{
+	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(vbuf);
+	struct vec2 *tvarray = (struct vec2 *)vdata->tvarray[0].array;
+
+	for (size_t i = first; i < last; i++) {
+		const struct glyph_info *info = &quads[i].glyph->info;
+
+		set_v3_rect(vdata->points + (i * 6),
+			quads[i].x, quads[i].y,
+			(float)info->w, (float)info->h);
+		set_v2_uv(tvarray + (i * 6),
+			info->u, info->v, info->u2, info->v2);
+		set_rect_colors2(vdata->colors + (i * 6), color1, color2);
+	}
 
-	cache_glyphs(srcdata, L"abcdefghijklmnopqrstuvwxyz" \
-		L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890" \
-		L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
+	gs_vertexbuffer_flush(vbuf);
 }
 
-#define glyph_pos x + (y*slot->bitmap.pitch)
-#define buf_pos (dx + x) + ((dy + y) * texbuf_w)
+static void destroy_vertex_buffers(struct ft2_source *srcdata)
+{
+	gs_vertexbuffer_destroy(srcdata->vbuf);
+	gs_vertexbuffer_destroy(srcdata->shadow_vbuf);
+	srcdata->vbuf = NULL;
+	srcdata->shadow_vbuf = NULL;
+	srcdata->vbuf_quads = 0;
+}
 
-void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
+/* only rewrites the quads that differ from the ones already in the vertex
+ * buffers, buffers are only recreated when they need to grow */
+static void update_vertex_buffers(struct ft2_source *srcdata,
+		const struct text_quad *quads, size_t num)
 {
-	FT_GlyphSlot slot;
-	FT_UInt glyph_index = 0;
+	bool shadow = srcdata->outline_text || srcdata->drop_shadow;
+	size_t old_num = srcdata->quads.num;
+	size_t first = 0, last = num;
+	bool rewrite_all = false;
 
-	if (!srcdata->font_face || !cache_glyphs)
-		return;
+	obs_enter_graphics();
 
-	slot = srcdata->font_face->glyph;
+	if (!shadow && srcdata->shadow_vbuf) {
+		gs_vertexbuffer_destroy(srcdata->shadow_vbuf);
+		srcdata->shadow_vbuf = NULL;
+	}
 
-	uint32_t dx = srcdata->texbuf_x, dy = srcdata->texbuf_y;
+	if (num > srcdata->vbuf_quads || !srcdata->vbuf ||
+	    (shadow && !srcdata->shadow_vbuf)) {
+		uint32_t capacity = srcdata->vbuf_quads ?
+			srcdata->vbuf_quads : 64;
+		while (capacity < num)
+			capacity *= 2;
+
+		destroy_vertex_buffers(srcdata);
+
+		srcdata->vbuf = create_uv_vbuffer(capacity * 6, true);
+		if (shadow)
+			srcdata->shadow_vbuf = create_uv_vbuffer(capacity * 6,
+					true);
+		srcdata->vbuf_quads = capacity;
+		rewrite_all = true;
+	}
 
-	int32_t cached_glyphs = 0;
-	size_t len = wcslen(cache_glyphs);
+	if (srcdata->quad_colors[0] != srcdata->color[0] ||
+	    srcdata->quad_colors[1] != srcdata->color[1]) {
+		srcdata->quad_colors[0] = srcdata->color[0];
+		srcdata->quad_colors[1] = srcdata->color[1];
+		rewrite_all = true;
+	}
 
-	for (size_t i = 0; i < len; i++) {
-		glyph_index = FT_Get_Char_Index(srcdata->font_face,
-			cache_glyphs[i]);
+	if (!rewrite_all) {
+		size_t common = old_num < num ? old_num : num;
 
-		if (src_glyph != NULL)
-			goto skip_glyph;
+		while (first < common &&
+		       quads_equal(quads + first, srcdata->quads.array + first))
+			first++;
+		while (last > first && last <= old_num &&
+		       quads_equal(quads + last - 1,
+			       srcdata->quads.array + last - 1))
+			last--;
+	}
 
-		FT_Load_Glyph(srcdata->font_face, glyph_index, FT_LOAD_DEFAULT);
-		FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL);
+	if (first < last) {
+		write_quads(srcdata->vbuf, quads, first, last,
+				srcdata->color[0], srcdata->color[1]);
+		if (srcdata->shadow_vbuf)
+			write_quads(srcdata->shadow_vbuf, quads, first, last,
+					0xFF000000, 0xFF000000);
+	}
 
-		uint32_t g_w = slot->bitmap.width;
-		uint32_t g_h = slot->bitmap.rows;
+	obs_leave_graphics();
+}
 
-		if (srcdata->max_h < g_h) srcdata->max_h = g_h;
+void set_up_vertex_buffer(struct ft2_source *srcdata)
+{
+	DARRAY(struct atlas_glyph*) old_pins;
+	DARRAY(struct text_quad) quads;
+	size_t len;
 
-		if (dx + g_w >= texbuf_w) {
-			dx = 0;
-			dy += srcdata->max_h + 1;
-		}
+	if (!srcdata->text || !srcdata->atlas)
+		return;
 
-		if (dy + g_h >= texbuf_h) {
-			blog(LOG_WARNING, "Out of space trying to render glyphs");
-			break;
-		}
+	da_init(old_pins);
+	da_init(quads);
 
-		src_glyph = bzalloc(sizeof(struct glyph_info));
-		src_glyph->u = (float)dx / (float)texbuf_w;
-		src_glyph->u2 = (float)(dx + g_w) / (float)texbuf_w;
-		src_glyph->v = (float)dy / (float)texbuf_h;
-		src_glyph->v2 = (float)(dy + g_h) / (float)texbuf_h;
-		src_glyph->w = g_w;
-		src_glyph->h = g_h;
-		src_glyph->yoff = slot->bitmap_top;
-		src_glyph->xoff = slot->bitmap_left;
-		src_glyph->xadv = slot->advance.x >> 6;
-
-		for (uint32_t y = 0; y < g_h; y++) {
-			for (uint32_t x = 0; x < g_w; x++)
-				srcdata->texbuf[buf_pos] =
-					slot->bitmap.buffer[glyph_pos];
-		}
+	/* pin the glyphs of the new text before unpinning the old ones so
+	 * glyphs used by both cannot be evicted in between */
+	len = wcslen(srcdata->text);
+	da_move(old_pins, srcdata->pins);
+	da_resize(srcdata->pins, len);
+	glyph_atlas_pin_text(srcdata->atlas, srcdata->text, len,
+			srcdata->pins.array);
 
-		dx += (g_w + 1);
-		if (dx >= texbuf_w) {
-			dx = 0;
-			dy += srcdata->max_h;
-		}
+	srcdata->max_h = glyph_atlas_get_preload_h(srcdata->atlas);
+	for (size_t i = 0; i < len; i++) {
+		struct atlas_glyph *glyph = srcdata->pins.array[i];
 
-		cached_glyphs++;
-	skip_glyph:;
+		if (glyph && srcdata->max_h < (uint32_t)glyph->info.h)
+			srcdata->max_h = (uint32_t)glyph->info.h;
 	}
 
-	srcdata->texbuf_x = dx;
-	srcdata->texbuf_y = dy;
-
-	if (cached_glyphs > 0) {
+	if (srcdata->custom_width >= 100)
+		srcdata->cx = srcdata->custom_width;
+	else
+		srcdata->cx = get_text_width(srcdata, len);
+	srcdata->cy = srcdata->max_h;
 
-		obs_enter_graphics();
+	if (srcdata->custom_width > 100 && srcdata->word_wrap)
+		apply_word_wrap(srcdata, len);
 
-		if (srcdata->tex != NULL) {
-			gs_texture_t *tmp_texture = NULL;
-			tmp_texture = srcdata->tex;
-			srcdata->tex = NULL;
-			gs_texture_destroy(tmp_texture);
-		}
+	layout_quads(srcdata, len, &quads.da);
+	update_vertex_buffers(srcdata, quads.array, quads.num);
 
-		srcdata->tex = gs_texture_create(texbuf_w, texbuf_h,
-			GS_A8, 1, (const uint8_t **)&srcdata->texbuf, 0);
+	da_move(srcdata->quads, quads);
 
-		obs_leave_graphics();
-	}
+	glyph_atlas_unpin(srcdata->atlas, old_pins.array, old_pins.num);
+	da_free(old_pins);
 }
 
-time_t get_modified_timestamp(char *filename)
+void free_text_layout(struct ft2_source *srcdata)
 {
-	struct stat stats;
+	if (srcdata->atlas)
+		glyph_atlas_unpin(srcdata->atlas, srcdata->pins.array,
+				srcdata->pins.num);
 
-	// stat is apparently terrifying and horrible, but we only call it once
-	// every second at most.
-	if (os_stat(filename, &stats) != 0)
-		return -1;
+	da_free(srcdata->pins);
+	da_free(srcdata->quads);
 
-	return stats.st_mtime;
+	obs_enter_graphics();
+	destroy_vertex_buffers(srcdata);
+	obs_leave_graphics();
 }
 
 static void remove_cr(wchar_t* source)
@@ -401,14 +385,53 @@ void load_text_from_file(struct ft2_source *srcdata, const char *filename)
 	bfree(tmp_read);
 }
 
+/* position after the line break that precedes the last max_lines lines */
+static uint32_t find_tail_start(FILE *file, uint32_t filesize, bool utf16,
+		uint16_t max_lines)
+{
+	uint8_t block[4096];
+	uint32_t char_size = utf16 ? 2 : 1;
+	uint32_t pos = filesize;
+	uint16_t line_breaks = 0;
+
+	/* read backwards a block at a time rather than a character at a
+	 * time, log files can be large */
+	while (pos >= char_size) {
+		uint32_t size = pos < sizeof(block) ? pos : sizeof(block);
+		uint32_t start = pos - size;
+
+		fseek(file, start, SEEK_SET);
+		if (fread(block, 1, size, file) != size)
+			break;
+
+		for (uint32_t i = size; i >= char_size; i -= char_size) {
+			bool line_break;
+
+			if (utf16) {
+				uint16_t value;
+				memcpy(&value, block + i - 2, 2);
+				line_break = value == L'\n';
+			} else {
+				line_break = block[i - 1] == '\n';
+			}
+
+			if (line_break && ++line_breaks > max_lines)
+				return start + i;
+		}
+
+		pos = start + (size % char_size);
+	}
+
+	return 0;
+}
+
 void read_from_end(struct ft2_source *srcdata, const char *filename)
 {
 	FILE *tmp_file = NULL;
 	uint32_t filesize = 0, cur_pos = 0;
 	char *tmp_read = NULL;
-	uint16_t value = 0, line_breaks = 0;
+	uint16_t value = 0;
 	size_t bytes_read;
-	char bvalue;
 
 	bool utf16 = false;
 
@@ -427,27 +450,7 @@ void read_from_end(struct ft2_source *srcdata, const char *filename)
 
 	fseek(tmp_file, 0, SEEK_END);
 	filesize = (uint32_t)ftell(tmp_file);
-	cur_pos = filesize;
-
-	while (line_breaks <= 6 && cur_pos != 0) {
-		if (!utf16) cur_pos--;
-		else cur_pos -= 2;
-		fseek(tmp_file, cur_pos, SEEK_SET);
-
-		if (!utf16) {
-			bytes_read = fread(&bvalue, 1, 1, tmp_file);
-			if (bytes_read == 1 && bvalue == '\n')
-				line_breaks++;
-		}
-		else {
-			bytes_read = fread(&value, 2, 1, tmp_file);
-			if (bytes_read == 2 && value == L'\n')
-				line_breaks++;
-		}
-	}
-
-	if (cur_pos != 0)
-		cur_pos += (utf16) ? 2 : 1;
+	cur_pos = find_tail_start(tmp_file, filesize, utf16, 6);
 
 	fseek(tmp_file, cur_pos, SEEK_SET);
 
@@ -483,27 +486,3 @@ void read_from_end(struct ft2_source *srcdata, const char *filename)
 	bfree(tmp_read);
 }
 
-uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
-{
-	FT_GlyphSlot slot = srcdata->font_face->glyph;
-	FT_UInt glyph_index = 0;
-	uint32_t w = 0, max_w = 0;
-	size_t len;
-
-	if (!text)
-		return 0;
-
-	len = wcslen(text);
-	for (size_t i = 0; i < len; i++) {
-		glyph_index = FT_Get_Char_Index(srcdata->font_face, text[i]);
-		FT_Load_Glyph(srcdata->font_face, glyph_index, FT_LOAD_DEFAULT);
-
-		if (text[i] == L'\n') w = 0;
-		else {
-			w += slot->advance.x >> 6;
-			if (w > max_w) max_w = w;
-		}
-	}
-
-	return max_w;
-}
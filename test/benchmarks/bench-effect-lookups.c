@@ -0,0 +1,266 @@
+#include <stdlib.h>
+
+#include "bench-util.h"
+#include "obs-internal.h"
+#include "graphics/effect.h"
+
+/*
+ *   Counts and measures the effect parameter lookups made each frame by the
+ * output conversion, the async frame conversion and the async frame draw.
+ * The effects are the ones libobs loads, compiled by the null graphics
+ * module.
+ *
+ *   "Before" is the old lookup, which compared the name against every
+ * parameter of the effect with strcmp.  "After" is the current code: call
+ * sites that use gs_effect_get_param_cached only look their parameter up on
+ * the first frame, and the remaining lookups go through the hash index of
+ * the effect, which only calls strcmp when the hashes match.
+ */
+
+#define FRAMES 100000
+
+/* keeps the timed lookups from being optimized out */
+static volatile uintptr_t lookup_sink;
+
+struct lookup_site {
+	const char *name;
+	bool       cached;
+};
+
+/* render_convert_texture in obs-video.c */
+static const struct lookup_site output_conversion_sites[] = {
+	{"image",          false},
+	{"u_plane_offset", true},
+	{"v_plane_offset", true},
+	{"width",          true},
+	{"height",         true},
+	{"width_i",        true},
+	{"height_i",       true},
+	{"width_d2",       true},
+	{"height_d2",      true},
+	{"width_d2_i",     true},
+	{"height_d2_i",    true},
+	{"input_height",   true},
+};
+
+/* update_async_texrender in obs-source.c */
+static const struct lookup_site async_conversion_sites[] = {
+	{"image",              false},
+	{"width",              true},
+	{"height",             true},
+	{"width_d2",           true},
+	{"width_d2_i",         true},
+	{"input_width_i_d2",   true},
+	{"int_width",          true},
+	{"int_input_width",    true},
+	{"int_u_plane_offset", true},
+	{"int_v_plane_offset", true},
+};
+
+/* obs_source_draw_texture in obs-source.c */
+static const struct lookup_site async_draw_sites[] = {
+	{"color_range_min", false},
+	{"color_range_max", false},
+	{"color_matrix",    false},
+	{"image",           false},
+};
+
+struct workload {
+	const char               *name;
+	gs_effect_t              *effect;
+	const struct lookup_site *sites;
+	size_t                   num_sites;
+};
+
+struct lookup_counts {
+	size_t lookups;
+	size_t compares;
+	size_t strcmps;
+};
+
+#define NUM_SITES(sites) (sizeof(sites) / sizeof(sites[0]))
+
+/* ------------------------------------------------------------------------- */
+
+/* the lookup before the index was added */
+static gs_eparam_t *linear_get_param(const gs_effect_t *effect,
+		const char *name)
+{
+	for (size_t i = 0; i < effect->params.num; i++) {
+		struct gs_effect_param *param = effect->params.array + i;
+
+		if (strcmp(param->name, name) == 0)
+			return param;
+	}
+
+	return NULL;
+}
+
+static void count_linear_lookup(const gs_effect_t *effect, const char *name,
+		struct lookup_counts *counts)
+{
+	counts->lookups++;
+
+	for (size_t i = 0; i < effect->params.num; i++) {
+		counts->compares++;
+		counts->strcmps++;
+
+		if (strcmp(effect->params.array[i].name, name) == 0)
+			break;
+	}
+}
+
+/* follows the probing of gs_effect_get_param_by_name */
+static void count_index_lookup(const gs_effect_t *effect, const char *name,
+		struct lookup_counts *counts)
+{
+	uint32_t hash = effect_name_hash(name);
+	size_t mask = effect->param_index_size - 1;
+	size_t slot = hash & mask;
+	size_t idx;
+
+	counts->lookups++;
+
+	while ((idx = effect->param_index[slot]) != 0) {
+		struct gs_effect_param *param = effect->params.array + idx - 1;
+
+		counts->compares++;
+
+		if (param->name_hash == hash) {
+			counts->strcmps++;
+			if (strcmp(param->name, name) == 0)
+				break;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool check_workload(const struct workload *work)
+{
+	bool success = true;
+
+	for (size_t i = 0; i < work->num_sites; i++) {
+		const char *name = work->sites[i].name;
+		gs_eparam_t *param = gs_effect_get_param_by_name(work->effect,
+				name);
+
+		if (!param || param != linear_get_param(work->effect, name)) {
+			fprintf(stderr, "%s: lookup of '%s' failed\n",
+					work->name, name);
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+static void count_workload(const struct workload *work)
+{
+	struct lookup_counts before = {0};
+	struct lookup_counts after  = {0};
+	struct lookup_counts first  = {0};
+
+	for (size_t i = 0; i < work->num_sites; i++) {
+		const struct lookup_site *site = work->sites + i;
+
+		count_linear_lookup(work->effect, site->name, &before);
+
+		if (site->cached)
+			count_index_lookup(work->effect, site->name, &first);
+		else
+			count_index_lookup(work->effect, site->name, &after);
+	}
+
+	printf("%s (%d parameters), per frame:\n", work->name,
+			(int)work->effect->params.num);
+	printf("  before: %2d lookups, %3d name compares, %3d strcmp\n",
+			(int)before.lookups, (int)before.compares,
+			(int)before.strcmps);
+	printf("  after:  %2d lookups, %3d hash compares, %3d strcmp "
+			"(+%d cached lookups on the first frame)\n",
+			(int)after.lookups, (int)after.compares,
+			(int)after.strcmps, (int)first.lookups);
+}
+
+static void time_workload(const struct workload *work)
+{
+	struct gs_eparam_cache *caches;
+	uintptr_t sink = 0;
+	double linear_ns, index_ns, cached_ns;
+	uint64_t start;
+
+	caches = bzalloc(sizeof(struct gs_eparam_cache) * work->num_sites);
+
+	start = os_gettime_ns();
+	for (int frame = 0; frame < FRAMES; frame++)
+		for (size_t i = 0; i < work->num_sites; i++)
+			sink += (uintptr_t)linear_get_param(work->effect,
+					work->sites[i].name);
+	linear_ns = bench_ns_per(start, FRAMES);
+
+	start = os_gettime_ns();
+	for (int frame = 0; frame < FRAMES; frame++)
+		for (size_t i = 0; i < work->num_sites; i++)
+			sink += (uintptr_t)gs_effect_get_param_by_name(
+					work->effect, work->sites[i].name);
+	index_ns = bench_ns_per(start, FRAMES);
+
+	start = os_gettime_ns();
+	for (int frame = 0; frame < FRAMES; frame++) {
+		for (size_t i = 0; i < work->num_sites; i++) {
+			const struct lookup_site *site = work->sites + i;
+
+			sink += (uintptr_t)(site->cached ?
+				gs_effect_get_param_cached(work->effect,
+					site->name, caches + i) :
+				gs_effect_get_param_by_name(work->effect,
+					site->name));
+		}
+	}
+	cached_ns = bench_ns_per(start, FRAMES);
+
+	printf("  linear %7.1f ns/frame, index %7.1f ns/frame, "
+			"index + cache %7.1f ns/frame\n",
+			linear_ns, index_ns, cached_ns);
+
+	lookup_sink = sink;
+
+	bfree(caches);
+}
+
+int main(void)
+{
+	struct workload workloads[3];
+	gs_effect_t *conversion;
+	gs_effect_t *draw;
+	bool success = true;
+
+	if (!bench_startup(1920, 1080))
+		return EXIT_FAILURE;
+
+	conversion = obs->video.conversion_effect;
+	draw = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+
+	workloads[0] = (struct workload){"output conversion", conversion,
+		output_conversion_sites, NUM_SITES(output_conversion_sites)};
+	workloads[1] = (struct workload){"async frame conversion", conversion,
+		async_conversion_sites, NUM_SITES(async_conversion_sites)};
+	workloads[2] = (struct workload){"async frame draw", draw,
+		async_draw_sites, NUM_SITES(async_draw_sites)};
+
+	for (size_t i = 0; i < 3; i++) {
+		if (!check_workload(workloads + i)) {
+			success = false;
+			continue;
+		}
+
+		count_workload(workloads + i);
+		time_workload(workloads + i);
+	}
+
+	obs_shutdown();
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench-util.h"
+
+/*
+ *   Checks the AVX2 format conversion kernels against the SSE2/C versions and
+ * measures both.  The SSE2/C versions are static, so this builds its own copy
+ * of format-conversion.c, and format-conversion-avx2.c is compiled into the
+ * benchmark as well.
+ *
+ *   Widths that aren't a multiple of 8 are included so that the trailing
+ * pixel groups the AVX2 kernels handle with scalar code are covered.
+ */
+#include "media-io/format-conversion.c"
+
+#define MAX_PLANES    3
+#define TARGET_PIXELS (100 * 1000 * 1000)
+
+/* exit code that makes ctest report the test as skipped */
+#define EXIT_SKIPPED  77
+
+struct plane_layout {
+	/* bytes per pixel of a line, as a fraction */
+	uint32_t line_num;
+	uint32_t line_den;
+	uint32_t height_den;
+};
+
+struct frame_layout {
+	size_t              planes;
+	struct plane_layout plane[MAX_PLANES];
+
+	/* decompress_422 processes min(in, out)/2 dwords of each line on all
+	 * paths, which runs past the line, so pad the last lines */
+	uint32_t            extra_lines;
+};
+
+static const struct frame_layout uyvx_layout = {1, {{4, 1, 1}}, 0};
+static const struct frame_layout i420_layout =
+	{3, {{1, 1, 1}, {1, 2, 2}, {1, 2, 2}}, 0};
+static const struct frame_layout nv12_layout = {2, {{1, 1, 1}, {1, 1, 2}}, 0};
+static const struct frame_layout i444_layout =
+	{3, {{1, 1, 1}, {1, 1, 1}, {1, 1, 1}}, 0};
+static const struct frame_layout rgba_layout = {1, {{4, 1, 1}}, 0};
+static const struct frame_layout packed_422_in_layout = {1, {{2, 1, 1}}, 1};
+static const struct frame_layout packed_422_out_layout = {1, {{2, 1, 1}}, 3};
+
+enum kernel_type {
+	KERNEL_COMPRESS,
+	KERNEL_DECOMPRESS_PLANAR,
+	KERNEL_DECOMPRESS_PACKED
+};
+
+struct kernel {
+	const char                 *name;
+	enum kernel_type           type;
+	const struct frame_layout  *in;
+	const struct frame_layout  *out;
+	bool                       leading_lum;
+
+	compress_func_t            compress[2];
+	decompress_planar_func_t   decompress_planar[2];
+	decompress_packed_func_t   decompress_packed[2];
+};
+
+static const struct kernel kernels[] = {
+	{"uyvx_to_i420", KERNEL_COMPRESS, &uyvx_layout, &i420_layout, false,
+		{compress_uyvx_to_i420_sse2, compress_uyvx_to_i420_avx2}},
+	{"uyvx_to_nv12", KERNEL_COMPRESS, &uyvx_layout, &nv12_layout, false,
+		{compress_uyvx_to_nv12_sse2, compress_uyvx_to_nv12_avx2}},
+	{"uyvx_to_i444", KERNEL_COMPRESS, &uyvx_layout, &i444_layout, false,
+		{convert_uyvx_to_i444_sse2, convert_uyvx_to_i444_avx2}},
+	{"decompress_420", KERNEL_DECOMPRESS_PLANAR,
+		&i420_layout, &rgba_layout, false, {NULL},
+		{decompress_420_c, decompress_420_avx2}},
+	{"decompress_nv12", KERNEL_DECOMPRESS_PLANAR,
+		&nv12_layout, &rgba_layout, false, {NULL},
+		{decompress_nv12_c, decompress_nv12_avx2}},
+	{"decompress_422_y", KERNEL_DECOMPRESS_PACKED,
+		&packed_422_in_layout, &packed_422_out_layout, true,
+		{NULL}, {NULL},
+		{decompress_422_c, decompress_422_avx2}},
+	{"decompress_422_u", KERNEL_DECOMPRESS_PACKED,
+		&packed_422_in_layout, &packed_422_out_layout, false,
+		{NULL}, {NULL},
+		{decompress_422_c, decompress_422_avx2}},
+};
+
+static const uint32_t sizes[][2] = {
+	{1280, 720},
+	{1920, 1080},
+	{3840, 2160},
+	{852,  480},
+	{1364, 768},
+	{1916, 1080},
+};
+
+struct frame {
+	uint8_t  *data[MAX_PLANES];
+	uint32_t linesize[MAX_PLANES];
+	size_t   size[MAX_PLANES];
+	size_t   planes;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void frame_init(struct frame *frame, const struct frame_layout *layout,
+		uint32_t cx, uint32_t cy)
+{
+	memset(frame, 0, sizeof(*frame));
+	frame->planes = layout->planes;
+
+	for (size_t i = 0; i < layout->planes; i++) {
+		const struct plane_layout *plane = layout->plane + i;
+		uint32_t height = cy / plane->height_den + layout->extra_lines;
+
+		frame->linesize[i] = cx * plane->line_num / plane->line_den;
+		frame->size[i]     = (size_t)frame->linesize[i] * height;
+		frame->data[i]     = bzalloc(frame->size[i]);
+	}
+}
+
+static void frame_randomize(struct frame *frame)
+{
+	for (size_t i = 0; i < frame->planes; i++)
+		for (size_t j = 0; j < frame->size[i]; j++)
+			frame->data[i][j] = (uint8_t)rand();
+}
+
+static bool frame_equal(const struct frame *a, const struct frame *b)
+{
+	for (size_t i = 0; i < a->planes; i++)
+		if (memcmp(a->data[i], b->data[i], a->size[i]) != 0)
+			return false;
+	return true;
+}
+
+static void frame_free(struct frame *frame)
+{
+	for (size_t i = 0; i < frame->planes; i++)
+		bfree(frame->data[i]);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline void run_kernel(const struct kernel *kernel, size_t path,
+		const struct frame *in, struct frame *out, uint32_t cy)
+{
+	switch (kernel->type) {
+	case KERNEL_COMPRESS:
+		kernel->compress[path](in->data[0], in->linesize[0], 0, cy,
+				out->data, out->linesize);
+		break;
+	case KERNEL_DECOMPRESS_PLANAR:
+		kernel->decompress_planar[path](
+				(const uint8_t *const *)in->data, in->linesize,
+				0, cy, out->data[0], out->linesize[0]);
+		break;
+	case KERNEL_DECOMPRESS_PACKED:
+		kernel->decompress_packed[path](in->data[0], in->linesize[0],
+				0, cy, out->data[0], out->linesize[0],
+				kernel->leading_lum);
+		break;
+	}
+}
+
+static double time_kernel(const struct kernel *kernel, size_t path,
+		const struct frame *in, struct frame *out, uint32_t cy,
+		uint32_t iterations)
+{
+	uint64_t start = os_gettime_ns();
+
+	for (uint32_t i = 0; i < iterations; i++)
+		run_kernel(kernel, path, in, out, cy);
+
+	return bench_ns_per(start, iterations) / 1000.0;
+}
+
+static bool test_kernel(const struct kernel *kernel, uint32_t cx, uint32_t cy)
+{
+	struct frame in, out_generic, out_avx2;
+	uint32_t iterations = TARGET_PIXELS / (cx * cy);
+	double generic_us, avx2_us;
+	bool equal;
+
+	if (!iterations)
+		iterations = 1;
+
+	frame_init(&in, kernel->in, cx, cy);
+	frame_init(&out_generic, kernel->out, cx, cy);
+	frame_init(&out_avx2, kernel->out, cx, cy);
+	frame_randomize(&in);
+
+	run_kernel(kernel, 0, &in, &out_generic, cy);
+	run_kernel(kernel, 1, &in, &out_avx2, cy);
+	equal = frame_equal(&out_generic, &out_avx2);
+
+	generic_us = time_kernel(kernel, 0, &in, &out_generic, cy, iterations);
+	avx2_us    = time_kernel(kernel, 1, &in, &out_avx2, cy, iterations);
+
+	printf("%-17s %4ux%-4u  generic %8.1f us, avx2 %8.1f us "
+			"(%.2fx)%s\n",
+			kernel->name, cx, cy, generic_us, avx2_us,
+			avx2_us > 0.0 ? generic_us / avx2_us : 0.0,
+			equal ? "" : ", OUTPUT DIFFERS");
+
+	frame_free(&in);
+	frame_free(&out_generic);
+	frame_free(&out_avx2);
+	return equal;
+}
+
+int main(void)
+{
+	bool success = true;
+
+	if (!cpu_has_avx2()) {
+		printf("AVX2 is not supported on this CPU, skipping\n");
+		return EXIT_SKIPPED;
+	}
+
+	srand(1);
+
+	for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+		for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+			if (!test_kernel(kernels + i, sizes[j][0], sizes[j][1]))
+				success = false;
+		}
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,306 @@
+#include <stdlib.h>
+#include <util/threading.h>
+
+#include "bench-util.h"
+#include "obs-internal.h"
+
+/*
+ *   Measures the cost per packet of the output packet interleaving.  An
+ * output with a video track and up to six audio tracks is started with
+ * encoders that never produce anything, and synthetic packets are then fed
+ * straight into the interleaving callback the output registered with its
+ * encoders.  Audio can be made to lead video, like with a video encoder that
+ * has a few frames of latency, which keeps more packets queued.
+ */
+
+#define VIDEO_FRAMES      30000
+#define AUDIO_FRAME_SIZE  1024
+#define SAMPLE_RATE       48000
+#define FPS               30
+
+typedef void (*new_packet_t)(void *param, struct encoder_packet *packet);
+
+struct bench_output {
+	obs_output_t *output;
+	uint64_t     packets;
+	int64_t      last_dts_usec;
+	bool         out_of_order;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const char *bench_encoder_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Encoder";
+}
+
+static void *bench_encoder_create(obs_data_t *settings, obs_encoder_t *encoder)
+{
+	UNUSED_PARAMETER(settings);
+	return encoder;
+}
+
+static void bench_encoder_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static bool bench_encoder_encode(void *data, struct encoder_frame *frame,
+		struct encoder_packet *packet, bool *received_packet)
+{
+	*received_packet = false;
+
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(frame);
+	UNUSED_PARAMETER(packet);
+	return true;
+}
+
+static size_t bench_encoder_frame_size(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return AUDIO_FRAME_SIZE;
+}
+
+static struct obs_encoder_info bench_video_encoder = {
+	.id       = "bench_video_encoder",
+	.type     = OBS_ENCODER_VIDEO,
+	.codec    = "h264",
+	.get_name = bench_encoder_name,
+	.create   = bench_encoder_create,
+	.destroy  = bench_encoder_destroy,
+	.encode   = bench_encoder_encode
+};
+
+static struct obs_encoder_info bench_audio_encoder = {
+	.id             = "bench_audio_encoder",
+	.type           = OBS_ENCODER_AUDIO,
+	.codec          = "AAC",
+	.get_name       = bench_encoder_name,
+	.create         = bench_encoder_create,
+	.destroy        = bench_encoder_destroy,
+	.encode         = bench_encoder_encode,
+	.get_frame_size = bench_encoder_frame_size
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const char *bench_output_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Output";
+}
+
+static void *bench_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	struct bench_output *bench = bzalloc(sizeof(struct bench_output));
+	bench->output = output;
+
+	UNUSED_PARAMETER(settings);
+	return bench;
+}
+
+static void bench_output_destroy(void *data)
+{
+	bfree(data);
+}
+
+static bool bench_output_start(void *data)
+{
+	struct bench_output *bench = data;
+
+	if (!obs_output_can_begin_data_capture(bench->output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(bench->output, 0))
+		return false;
+
+	return obs_output_begin_data_capture(bench->output, 0);
+}
+
+static void bench_output_stop(void *data, uint64_t ts)
+{
+	struct bench_output *bench = data;
+	obs_output_end_data_capture(bench->output);
+
+	UNUSED_PARAMETER(ts);
+}
+
+static void bench_output_packet(void *data, struct encoder_packet *packet)
+{
+	struct bench_output *bench = data;
+
+	if (bench->packets && packet->dts_usec < bench->last_dts_usec)
+		bench->out_of_order = true;
+
+	bench->last_dts_usec = packet->dts_usec;
+	bench->packets++;
+}
+
+static struct obs_output_info bench_output = {
+	.id             = "bench_output",
+	.flags          = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED |
+	                  OBS_OUTPUT_MULTI_TRACK,
+	.get_name       = bench_output_name,
+	.create         = bench_output_create,
+	.destroy        = bench_output_destroy,
+	.start          = bench_output_start,
+	.stop           = bench_output_stop,
+	.encoded_packet = bench_output_packet
+};
+
+/* ------------------------------------------------------------------------- */
+
+static new_packet_t get_interleave_callback(obs_encoder_t *encoder,
+		obs_output_t *output)
+{
+	new_packet_t callback = NULL;
+
+	pthread_mutex_lock(&encoder->callbacks_mutex);
+	for (size_t i = 0; i < encoder->callbacks.num; i++) {
+		struct encoder_callback *cb = encoder->callbacks.array + i;
+
+		if (cb->param == output) {
+			callback = cb->new_packet;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&encoder->callbacks_mutex);
+
+	return callback;
+}
+
+static inline void init_packet(struct encoder_packet *packet,
+		obs_encoder_t *encoder, enum obs_encoder_type type,
+		int64_t ts, int32_t den)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->type         = type;
+	packet->encoder      = encoder;
+	packet->pts          = ts;
+	packet->dts          = ts;
+	packet->timebase_num = 1;
+	packet->timebase_den = den;
+	packet->dts_usec     = ts * 1000000LL / den;
+}
+
+/* returns the number of packets fed */
+static uint64_t feed_packets(obs_output_t *output, new_packet_t callback,
+		obs_encoder_t *video, obs_encoder_t **audio, size_t tracks,
+		int64_t audio_lead_usec)
+{
+	int64_t audio_frames = 0;
+	uint64_t count = 0;
+
+	for (int64_t frame = 0; frame < VIDEO_FRAMES; frame++) {
+		struct encoder_packet packet;
+		int64_t video_usec = frame * 1000000LL / FPS;
+
+		for (;;) {
+			int64_t audio_ts = audio_frames * AUDIO_FRAME_SIZE;
+			int64_t audio_usec = audio_ts * 1000000LL / SAMPLE_RATE;
+
+			if (audio_usec > video_usec + audio_lead_usec)
+				break;
+
+			for (size_t i = 0; i < tracks; i++) {
+				init_packet(&packet, audio[i],
+						OBS_ENCODER_AUDIO, audio_ts,
+						SAMPLE_RATE);
+				callback(output, &packet);
+				count++;
+			}
+
+			audio_frames++;
+		}
+
+		init_packet(&packet, video, OBS_ENCODER_VIDEO, frame, FPS);
+		packet.keyframe = (frame % (FPS * 2)) == 0;
+		callback(output, &packet);
+		count++;
+	}
+
+	return count;
+}
+
+static bool run_benchmark(size_t tracks, int64_t audio_lead_ms)
+{
+	obs_encoder_t *audio[MAX_AUDIO_MIXES] = {0};
+	obs_encoder_t *video;
+	obs_output_t *output;
+	struct bench_output *bench;
+	new_packet_t callback;
+	uint64_t count;
+	uint64_t start;
+	bool success = false;
+
+	output = obs_output_create("bench_output", "interleave", NULL, NULL);
+	video = obs_video_encoder_create("bench_video_encoder", "video", NULL,
+			NULL);
+	obs_encoder_set_video(video, obs_get_video());
+	obs_output_set_video_encoder(output, video);
+
+	for (size_t i = 0; i < tracks; i++) {
+		audio[i] = obs_audio_encoder_create("bench_audio_encoder",
+				"audio", NULL, i, NULL);
+		obs_encoder_set_audio(audio[i], obs_get_audio());
+		obs_output_set_audio_encoder(output, audio[i], i);
+	}
+
+	if (!obs_output_start(output)) {
+		fprintf(stderr, "Couldn't start the output\n");
+		goto fail;
+	}
+
+	callback = get_interleave_callback(video, output);
+	if (!callback) {
+		fprintf(stderr, "Output is not interleaving packets\n");
+		goto fail;
+	}
+
+	bench = output->context.data;
+	start = os_gettime_ns();
+	count = feed_packets(output, callback, video, audio, tracks,
+			audio_lead_ms * 1000);
+
+	printf("%d audio track(s), audio %4d ms ahead: %8.1f ns/packet, "
+			"%"PRIu64" of %"PRIu64" packets sent%s\n",
+			(int)tracks, (int)audio_lead_ms,
+			bench_ns_per(start, count), bench->packets, count,
+			bench->out_of_order ? ", OUT OF ORDER" : "");
+
+	success = !bench->out_of_order;
+
+fail:
+	obs_output_force_stop(output);
+	obs_output_release(output);
+	obs_encoder_release(video);
+	for (size_t i = 0; i < tracks; i++)
+		obs_encoder_release(audio[i]);
+	return success;
+}
+
+int main(void)
+{
+	static const size_t tracks[] = {1, 2, 6};
+	static const int64_t leads_ms[] = {0, 500, 2000};
+	bool success = true;
+
+	if (!bench_startup(320, 180))
+		return EXIT_FAILURE;
+
+	obs_register_encoder(&bench_video_encoder);
+	obs_register_encoder(&bench_audio_encoder);
+	obs_register_output(&bench_output);
+
+	for (size_t i = 0; i < sizeof(tracks) / sizeof(tracks[0]); i++) {
+		for (size_t j = 0; j < sizeof(leads_ms) / sizeof(leads_ms[0]);
+				j++) {
+			if (!run_benchmark(tracks[i], leads_ms[j]))
+				success = false;
+		}
+	}
+
+	obs_shutdown();
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,282 @@
+#include <stdlib.h>
+
+#include <util/dstr.h>
+
+#include "bench-util.h"
+
+/*
+ *   Measures loading a large scene collection with obs_data.  A collection
+ * with the same layout the frontend saves is generated and turned into JSON,
+ * which is then repeatedly parsed, walked with the same lookups that
+ * obs_load_source and the scene source do for each source and scene item,
+ * and saved back to JSON.
+ */
+
+#define NUM_INPUTS         2000
+#define NUM_SCENES         100
+#define ITEMS_PER_SCENE    40
+#define SETTINGS_PER_INPUT 24
+#define LOAD_RUNS          10
+
+static const char *source_int_keys[] = {
+	"mixers", "sync", "flags", "push-to-mute-delay", "push-to-talk-delay",
+	"deinterlace_mode", "deinterlace_field_order", "monitoring_type"
+};
+
+static const char *source_bool_keys[] = {
+	"enabled", "muted", "push-to-mute", "push-to-talk"
+};
+
+static const char *item_int_keys[] = {
+	"align", "bounds_type", "bounds_align", "crop_left", "crop_top",
+	"crop_right", "crop_bottom", "scale_filter", "id"
+};
+
+#define NUM_KEYS(keys) (sizeof(keys) / sizeof(keys[0]))
+
+struct load_stats {
+	size_t  sources;
+	size_t  items;
+	int64_t checksum;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static obs_data_t *create_source(const char *id, const char *name)
+{
+	obs_data_t *source   = obs_data_create();
+	obs_data_t *hotkeys  = obs_data_create();
+	obs_data_t *priv     = obs_data_create();
+
+	obs_data_set_string(source, "name", name);
+	obs_data_set_string(source, "id", id);
+	obs_data_set_double(source, "volume", 1.0);
+
+	for (size_t i = 0; i < NUM_KEYS(source_int_keys); i++)
+		obs_data_set_int(source, source_int_keys[i], (long long)i);
+	for (size_t i = 0; i < NUM_KEYS(source_bool_keys); i++)
+		obs_data_set_bool(source, source_bool_keys[i], i & 1);
+
+	obs_data_set_obj(source, "hotkeys", hotkeys);
+	obs_data_set_obj(source, "private_settings", priv);
+
+	obs_data_release(hotkeys);
+	obs_data_release(priv);
+	return source;
+}
+
+static obs_data_t *create_item(size_t input)
+{
+	obs_data_t *item = obs_data_create();
+	struct vec2 pos, scale;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "input %d", (int)input);
+	vec2_set(&pos, (float)input, (float)input * 0.5f);
+	vec2_set(&scale, 1.0f, 1.0f);
+
+	obs_data_set_string(item, "name", name.array);
+	obs_data_set_bool(item, "visible", true);
+	obs_data_set_bool(item, "locked", false);
+	obs_data_set_double(item, "rot", 0.0);
+	obs_data_set_vec2(item, "pos", &pos);
+	obs_data_set_vec2(item, "scale", &scale);
+	obs_data_set_vec2(item, "bounds", &scale);
+
+	for (size_t i = 0; i < NUM_KEYS(item_int_keys); i++)
+		obs_data_set_int(item, item_int_keys[i], (long long)input);
+
+	dstr_free(&name);
+	return item;
+}
+
+static obs_data_t *create_collection(void)
+{
+	obs_data_t       *collection = obs_data_create();
+	obs_data_array_t *sources    = obs_data_array_create();
+	struct dstr      name        = {0};
+
+	for (size_t i = 0; i < NUM_INPUTS; i++) {
+		obs_data_t *settings = obs_data_create();
+		obs_data_t *source;
+
+		dstr_printf(&name, "input %d", (int)i);
+		source = create_source("color_source", name.array);
+
+		for (int j = 0; j < SETTINGS_PER_INPUT; j++) {
+			dstr_printf(&name, "setting_%d", j);
+			obs_data_set_int(settings, name.array, (long long)i);
+		}
+
+		obs_data_set_obj(source, "settings", settings);
+		obs_data_array_push_back(sources, source);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	for (size_t i = 0; i < NUM_SCENES; i++) {
+		obs_data_t       *settings = obs_data_create();
+		obs_data_array_t *items    = obs_data_array_create();
+		obs_data_t       *source;
+
+		dstr_printf(&name, "scene %d", (int)i);
+		source = create_source("scene", name.array);
+
+		for (size_t j = 0; j < ITEMS_PER_SCENE; j++) {
+			obs_data_t *item = create_item(
+					(i * ITEMS_PER_SCENE + j) % NUM_INPUTS);
+			obs_data_array_push_back(items, item);
+			obs_data_release(item);
+		}
+
+		obs_data_set_array(settings, "items", items);
+		obs_data_set_obj(source, "settings", settings);
+		obs_data_array_push_back(sources, source);
+		obs_data_array_release(items);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	obs_data_set_string(collection, "name", "Benchmark");
+	obs_data_set_string(collection, "current_scene", "scene 0");
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	dstr_free(&name);
+	return collection;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void load_item(obs_data_t *item, struct load_stats *stats)
+{
+	struct vec2 pos, scale, bounds;
+	const char *name = obs_data_get_string(item, "name");
+
+	obs_data_get_vec2(item, "pos", &pos);
+	obs_data_get_vec2(item, "scale", &scale);
+	obs_data_get_vec2(item, "bounds", &bounds);
+
+	stats->checksum += (int64_t)pos.x;
+	stats->checksum += obs_data_get_bool(item, "visible");
+	stats->checksum += obs_data_get_bool(item, "locked");
+	stats->checksum += (int64_t)obs_data_get_double(item, "rot");
+	stats->checksum += name && *name;
+
+	for (size_t i = 0; i < NUM_KEYS(item_int_keys); i++)
+		stats->checksum += obs_data_get_int(item, item_int_keys[i]);
+
+	stats->items++;
+}
+
+static void load_source(obs_data_t *source, struct load_stats *stats)
+{
+	obs_data_t *settings = obs_data_get_obj(source, "settings");
+	obs_data_t *hotkeys  = obs_data_get_obj(source, "hotkeys");
+	obs_data_t *priv     = obs_data_get_obj(source, "private_settings");
+	const char *id       = obs_data_get_string(source, "id");
+	const char *name     = obs_data_get_string(source, "name");
+
+	obs_data_set_default_double(source, "volume", 1.0);
+	obs_data_set_default_int(source, "mixers", 0xF);
+	obs_data_set_default_bool(source, "enabled", true);
+	obs_data_set_default_bool(source, "muted", false);
+
+	stats->checksum += (int64_t)obs_data_get_double(source, "volume");
+	stats->checksum += name && *name;
+
+	for (size_t i = 0; i < NUM_KEYS(source_int_keys); i++)
+		stats->checksum += obs_data_get_int(source, source_int_keys[i]);
+	for (size_t i = 0; i < NUM_KEYS(source_bool_keys); i++)
+		stats->checksum += obs_data_get_bool(source,
+				source_bool_keys[i]);
+
+	if (strcmp(id, "scene") == 0) {
+		obs_data_array_t *items = obs_data_get_array(settings, "items");
+		size_t count = obs_data_array_count(items);
+
+		for (size_t i = 0; i < count; i++) {
+			obs_data_t *item = obs_data_array_item(items, i);
+			load_item(item, stats);
+			obs_data_release(item);
+		}
+
+		obs_data_array_release(items);
+	} else {
+		struct dstr key = {0};
+
+		for (int i = 0; i < SETTINGS_PER_INPUT; i++) {
+			dstr_printf(&key, "setting_%d", i);
+			stats->checksum += obs_data_get_int(settings, key.array);
+		}
+
+		dstr_free(&key);
+	}
+
+	obs_data_release(settings);
+	obs_data_release(hotkeys);
+	obs_data_release(priv);
+	stats->sources++;
+}
+
+static void load_collection(obs_data_t *collection, struct load_stats *stats)
+{
+	obs_data_array_t *sources = obs_data_get_array(collection, "sources");
+	size_t count = obs_data_array_count(sources);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *source = obs_data_array_item(sources, i);
+		load_source(source, stats);
+		obs_data_release(source);
+	}
+
+	obs_data_array_release(sources);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(void)
+{
+	struct load_stats expected = {0};
+	obs_data_t *collection = create_collection();
+	char *json = bstrdup(obs_data_get_json(collection));
+	uint64_t parse_ns = 0, load_ns = 0, save_ns = 0;
+	bool success = true;
+
+	load_collection(collection, &expected);
+	obs_data_release(collection);
+
+	for (int run = 0; run < LOAD_RUNS; run++) {
+		struct load_stats stats = {0};
+		uint64_t start = os_gettime_ns();
+		uint64_t parsed, loaded;
+
+		collection = obs_data_create_from_json(json);
+		parsed = os_gettime_ns();
+
+		load_collection(collection, &stats);
+		loaded = os_gettime_ns();
+
+		obs_data_get_json(collection);
+		save_ns  += os_gettime_ns() - loaded;
+		load_ns  += loaded - parsed;
+		parse_ns += parsed - start;
+
+		obs_data_release(collection);
+
+		if (memcmp(&stats, &expected, sizeof(stats)) != 0)
+			success = false;
+	}
+
+	printf("%d sources, %d scene items, %d KB of JSON\n",
+			(int)expected.sources, (int)expected.items,
+			(int)(strlen(json) / 1024));
+	printf("parse %8.2f ms, load %8.2f ms, save %8.2f ms per collection"
+			"%s\n",
+			(double)parse_ns / LOAD_RUNS / 1000000.0,
+			(double)load_ns  / LOAD_RUNS / 1000000.0,
+			(double)save_ns  / LOAD_RUNS / 1000000.0,
+			success ? "" : ", LOADED VALUES DIFFER");
+
+	bfree(json);
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <util/threading.h>
+#include <graphics/vec4.h>
+
+#include "bench-util.h"
+#include "obs-internal.h"
+
+/*
+ *   Runs the whole render pipeline headless with the null graphics module:
+ * a scene with a synchronous source and an async source fed with I420 frames
+ * is rendered, converted to NV12 and staged into a raw video output, which
+ * checks that it receives every frame in order.  Also prints how long the
+ * graphics thread took per frame.
+ */
+
+#define CX              1280
+#define CY              720
+#define TEST_FRAMES     150
+#define ASYNC_CX        640
+#define ASYNC_CY        360
+#define TIMEOUT_NS      30000000000ULL
+
+struct bench_output {
+	obs_output_t  *output;
+	volatile long frames;
+	uint64_t      last_timestamp;
+	bool          bad_frame;
+	os_event_t    *done;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const char *bench_color_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Color Source";
+}
+
+static void *bench_color_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void bench_color_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static uint32_t bench_color_width(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return CX;
+}
+
+static uint32_t bench_color_height(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return CY;
+}
+
+static void bench_color_render(void *data, gs_effect_t *effect)
+{
+	gs_effect_t    *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
+	gs_eparam_t    *color = gs_effect_get_param_by_name(solid, "color");
+	gs_technique_t *tech  = gs_effect_get_technique(solid, "Solid");
+	struct vec4    color_val;
+
+	vec4_from_rgba(&color_val, 0xFF3366CC);
+	gs_effect_set_vec4(color, &color_val);
+
+	gs_technique_begin(tech);
+	gs_technique_begin_pass(tech, 0);
+
+	gs_draw_sprite(NULL, 0, CX, CY);
+
+	gs_technique_end_pass(tech);
+	gs_technique_end(tech);
+
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(effect);
+}
+
+static struct obs_source_info bench_color_source = {
+	.id           = "bench_color_source",
+	.type         = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_VIDEO,
+	.get_name     = bench_color_name,
+	.create       = bench_color_create,
+	.destroy      = bench_color_destroy,
+	.get_width    = bench_color_width,
+	.get_height   = bench_color_height,
+	.video_render = bench_color_render
+};
+
+static const char *bench_async_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Async Source";
+}
+
+static struct obs_source_info bench_async_source = {
+	.id           = "bench_async_source",
+	.type         = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO,
+	.get_name     = bench_async_name,
+	.create       = bench_color_create,
+	.destroy      = bench_color_destroy
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const char *bench_output_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Benchmark Raw Output";
+}
+
+static void *bench_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	struct bench_output *bench = bzalloc(sizeof(struct bench_output));
+	bench->output = output;
+	os_event_init(&bench->done, OS_EVENT_TYPE_MANUAL);
+
+	UNUSED_PARAMETER(settings);
+	return bench;
+}
+
+static void bench_output_destroy(void *data)
+{
+	struct bench_output *bench = data;
+
+	os_event_destroy(bench->done);
+	bfree(bench);
+}
+
+static bool bench_output_start(void *data)
+{
+	struct bench_output *bench = data;
+
+	if (!obs_output_can_begin_data_capture(bench->output, 0))
+		return false;
+
+	return obs_output_begin_data_capture(bench->output, 0);
+}
+
+static void bench_output_stop(void *data, uint64_t ts)
+{
+	struct bench_output *bench = data;
+	obs_output_end_data_capture(bench->output);
+
+	UNUSED_PARAMETER(ts);
+}
+
+static void bench_output_raw_video(void *data, struct video_data *frame)
+{
+	struct bench_output *bench = data;
+	long frames = bench->frames;
+
+	if (!frame->data[0] || !frame->data[1] || !frame->linesize[0] ||
+	    (frames && frame->timestamp <= bench->last_timestamp))
+		bench->bad_frame = true;
+
+	bench->last_timestamp = frame->timestamp;
+
+	if (os_atomic_inc_long(&bench->frames) == TEST_FRAMES)
+		os_event_signal(bench->done);
+}
+
+static struct obs_output_info bench_output = {
+	.id        = "bench_raw_output",
+	.flags     = OBS_OUTPUT_VIDEO,
+	.get_name  = bench_output_name,
+	.create    = bench_output_create,
+	.destroy   = bench_output_destroy,
+	.start     = bench_output_start,
+	.stop      = bench_output_stop,
+	.raw_video = bench_output_raw_video
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void output_async_frame(obs_source_t *source, uint8_t *planes,
+		uint8_t value)
+{
+	struct obs_source_frame frame = {
+		.data      = {planes,
+		              planes + ASYNC_CX * ASYNC_CY,
+		              planes + ASYNC_CX * ASYNC_CY * 5 / 4},
+		.linesize  = {ASYNC_CX, ASYNC_CX / 2, ASYNC_CX / 2},
+		.width     = ASYNC_CX,
+		.height    = ASYNC_CY,
+		.format    = VIDEO_FORMAT_I420,
+		.timestamp = os_gettime_ns()
+	};
+
+	memset(planes, value, ASYNC_CX * ASYNC_CY * 3 / 2);
+
+	video_format_get_parameters(VIDEO_CS_601, VIDEO_RANGE_PARTIAL,
+			frame.color_matrix, frame.color_range_min,
+			frame.color_range_max);
+
+	obs_source_output_video(source, &frame);
+}
+
+static bool run_test(void)
+{
+	obs_scene_t *scene = obs_scene_create("scene");
+	obs_source_t *color = obs_source_create("bench_color_source",
+			"color", NULL, NULL);
+	obs_source_t *async = obs_source_create("bench_async_source",
+			"async", NULL, NULL);
+	obs_output_t *output = obs_output_create("bench_raw_output", "raw",
+			NULL, NULL);
+	struct bench_output *bench = output->context.data;
+	uint8_t *planes = bmalloc(ASYNC_CX * ASYNC_CY * 3 / 2);
+	uint64_t start = os_gettime_ns();
+	bool success = false;
+	int device_type;
+	uint8_t value = 0;
+
+	obs_enter_graphics();
+	device_type = gs_get_device_type();
+	obs_leave_graphics();
+
+	if (device_type != GS_DEVICE_NULL) {
+		fprintf(stderr, "Not using the null graphics module\n");
+		goto fail;
+	}
+
+	obs_scene_add(scene, color);
+	obs_scene_add(scene, async);
+	obs_set_output_source(0, obs_scene_get_source(scene));
+
+	if (!obs_output_start(output)) {
+		fprintf(stderr, "Couldn't start the output\n");
+		goto fail;
+	}
+
+	while (os_event_try(bench->done) == EAGAIN) {
+		if (os_gettime_ns() - start > TIMEOUT_NS) {
+			fprintf(stderr, "Timed out waiting for frames\n");
+			break;
+		}
+
+		output_async_frame(async, planes, value++);
+		os_sleep_ms(10);
+	}
+
+	obs_output_stop(output);
+
+	printf("%ld frames output, %u of %u frames lagged, "
+			"%.1f us average render time%s\n",
+			bench->frames, obs_get_lagged_frames(),
+			obs_get_total_frames(),
+			(double)obs_get_average_frame_time_ns() / 1000.0,
+			bench->bad_frame ? ", BAD FRAMES" : "");
+
+	success = bench->frames >= TEST_FRAMES && !bench->bad_frame;
+
+fail:
+	obs_set_output_source(0, NULL);
+	obs_output_release(output);
+	obs_source_release(async);
+	obs_source_release(color);
+	obs_scene_release(scene);
+	bfree(planes);
+	return success;
+}
+
+int main(void)
+{
+	bool success;
+
+	if (!bench_startup(CX, CY))
+		return EXIT_FAILURE;
+
+	obs_register_source(&bench_color_source);
+	obs_register_source(&bench_async_source);
+	obs_register_output(&bench_output);
+
+	success = run_test();
+
+	obs_shutdown();
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <util/platform.h>
+#include <obs.h>
+
+/* starts libobs with the null graphics module, so no GPU or display is
+ * needed */
+static inline bool bench_startup(uint32_t cx, uint32_t cy)
+{
+	struct obs_video_info ovi = {0};
+	struct obs_audio_info oai = {0};
+
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "Couldn't start libobs\n");
+		return false;
+	}
+
+	ovi.graphics_module = DL_NULL;
+	ovi.fps_num         = 30;
+	ovi.fps_den         = 1;
+	ovi.base_width      = cx;
+	ovi.base_height     = cy;
+	ovi.output_width    = cx;
+	ovi.output_height   = cy;
+	ovi.output_format   = VIDEO_FORMAT_NV12;
+	ovi.gpu_conversion  = true;
+	ovi.colorspace      = VIDEO_CS_709;
+	ovi.range           = VIDEO_RANGE_PARTIAL;
+	ovi.scale_type      = OBS_SCALE_BICUBIC;
+
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "Couldn't initialize video with '%s'\n",
+				DL_NULL);
+		obs_shutdown();
+		return false;
+	}
+
+	oai.samples_per_sec = 48000;
+	oai.speakers        = SPEAKERS_STEREO;
+
+	if (!obs_reset_audio(&oai)) {
+		fprintf(stderr, "Couldn't initialize audio\n");
+		obs_shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+static inline double bench_ns_per(uint64_t start_ns, uint64_t count)
+{
+	return count ? (double)(os_gettime_ns() - start_ns) / (double)count
+		: 0.0;
+}